@@ -4,31 +4,188 @@
 
 #include "IndexOutOfBound.h"
 #include "ElementNotExist.h"
+#include "Search.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /**
  * The ArrayList is just like vector in C++.
  * You should know that "capacity" here doesn't mean how many elements are now in this list, where it means
  * the length of the array of your internal implemention
  *
- * The iterator iterates in the order of the elements being loaded into this list
+ * The array is raw memory: only the first size() slots hold constructed elements, so T
+ * needs no default constructor. A trivially copyable T is moved with memcpy/realloc.
+ * When the array is full its length is multiplied by the growth factor (2 by default,
+ * see setGrowthFactor); reserve() and shrinkToFit() set it directly.
+ *
+ * The iterator iterates in the order of the elements being loaded into this list.
+ * Iterator::remove() leaves a gap which the walk carries along and drops at the end
+ * of the list. If the walk stops early, the gap stays until the next call which
+ * changes the list; the const functions read around it and never move an element,
+ * so a const list may be read from several threads at once.
  */
 template <class T>
 class ArrayList
 {
 private:
+    static const int Min_capacity = 4;
+    static const bool Trivial = std::is_trivially_copyable<T>::value;
+
     int Size, save_size;
     T *data;
+    double growth;
+
+    /*
+     * Iterator::remove() leaves a gap of gap_len destroyed slots at gap_from,
+     * which the iterator slides along as it goes, so removing many elements in
+     * one walk moves every element only once. Size does not count the gap.
+     * Every other function which changes the list closes the gap first (see
+     * closeGap); the const ones read around it (see at and firstPiece). A gap
+     * which reaches the end of the list has nothing behind it, and is dropped at once.
+     */
+    int gap_from, gap_len;
+
+    static T *allocate(int n) {
+        T *p = (T *) std::malloc((size_t) n * sizeof(T));
+        if (p == NULL) throw std::bad_alloc();
+        return p;
+    }
 
     /*
-     * double the space of data
-     */
-    void doubleSpace() {
-        save_size *= 2;
-        T *new_data = new T[save_size];
-        for (int i = 0; i < Size; ++i)
-            new_data[i] = data[i];
-        delete[] (data);
+     * Move n elements to the uninitialized slots at to, leaving the slots at from uninitialized.
+     * The ranges may overlap if to < from.
+     */
+    static void relocate(T *to, T *from, int n) {
+        if (Trivial) {
+            if (n > 0) std::memmove((void *) to, (const void *) from, (size_t) n * sizeof(T));
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
+    /*
+     * The same, for overlapping ranges with to > from
+     */
+    static void relocateBackward(T *to, T *from, int n) {
+        if (Trivial) {
+            if (n > 0) std::memmove((void *) to, (const void *) from, (size_t) n * sizeof(T));
+            return;
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
+    /*
+     * Move the elements after the gap left by Iterator::remove() down over it
+     */
+    void closeGap() {
+        if (gap_len == 0) return;
+        relocate(data + gap_from, data + gap_from + gap_len, Size - gap_from);
+        gap_len = 0;
+    }
+
+    /*
+     * The number of elements before the gap; those after it start at data + firstPiece() + gap_len
+     */
+    int firstPiece() const {
+        return gap_len > 0 ? gap_from : Size;
+    }
+
+    /*
+     * The element at index, reading around the gap
+     */
+    const T &at(int index) const {
+        return index < firstPiece() ? data[index] : data[index + gap_len];
+    }
+
+    void destroy(int from, int to) {
+        if (!std::is_trivially_destructible<T>::value)
+            for (int i = from; i < to; ++i)
+                data[i].~T();
+    }
+
+    /*
+     * The capacity after growing a list which needs room for need elements.
+     * The product is taken in double and cut down to INT_MAX.
+     * @throw std::bad_alloc if need is more than INT_MAX
+     */
+    int nextCapacity(long long need) const {
+        if (need > INT_MAX) throw std::bad_alloc();
+        double g = save_size * growth;
+        int n = g < INT_MAX ? (int) g : INT_MAX;
+        if (n < need) n = (int) need;
+        if (n < Min_capacity) n = Min_capacity;
+        return n;
+    }
+
+    /*
+     * Change the length of data to n >= Size
+     */
+    void reallocate(int n) {
+        if (n == 0) {
+            std::free(data);
+            data = NULL;
+        } else if (Trivial) {
+            T *p = (T *) std::realloc((void *) data, (size_t) n * sizeof(T));
+            if (p == NULL) throw std::bad_alloc();
+            data = p;
+        } else {
+            T *new_data = allocate(n);
+            relocate(new_data, data, Size);
+            std::free(data);
+            data = new_data;
+        }
+        save_size = n;
+    }
+
+    /*
+     * Append an element made from args to a full list.
+     * It is made before the old elements move, since args may refer to one of them.
+     */
+    template <class... Args>
+    void growAndEmplace(Args&&... args) {
+        int n = nextCapacity((long long) Size + 1);
+        if (Trivial) {
+            T e(std::forward<Args>(args)...);
+            reallocate(n);
+            new (data + Size) T(std::move(e));
+            return;
+        }
+        T *new_data = allocate(n);
+        try {
+            new (new_data + Size) T(std::forward<Args>(args)...);
+        } catch (...) {
+            std::free(new_data);
+            throw;
+        }
+        relocate(new_data, data, Size);
+        std::free(data);
         data = new_data;
+        save_size = n;
+    }
+
+    /*
+     * Make this a copy of x, with no spare capacity
+     */
+    void copy(const ArrayList& x) {
+        Size = 0;
+        save_size = 0;
+        data = NULL;
+        gap_from = gap_len = 0;
+        growth = x.growth;
+        reallocate(x.Size);
+        for (; Size < x.Size; ++Size)
+            new (data + Size) T(x.at(Size));
     }
 
 public:
@@ -62,7 +219,16 @@ public:
         const T &next() {
             if (!hasNext()) throw ElementNotExist();
             if (dead) dead = false;
-            return container->data[++index];
+            ++index;
+            if (container->gap_len > 0) {
+                if (container->gap_from != index) container->closeGap();
+                else {
+                    T *to = container->data + index;
+                    relocate(to, to + container->gap_len, 1);
+                    if (++container->gap_from == container->Size) container->gap_len = 0;
+                }
+            }
+            return container->data[index];
         }
 
         /**
@@ -76,24 +242,29 @@ public:
         void remove() {
             if (index < 0 || dead) throw ElementNotExist();
             dead = true;
-            container->removeIndex(index--);
+            ArrayList *c = container;
+            if (c->gap_len > 0 && c->gap_from != index + 1) c->closeGap();
+            c->data[index].~T();
+            c->gap_from = index--;
+            ++c->gap_len;
+            --c->Size;
+            if (c->gap_from == c->Size) c->gap_len = 0;
         }
     };
 
     /**
      * TODO Constructs an empty array list.
+     * No memory is taken before the first element is added.
      */
-    ArrayList() { 
-        save_size = 4;
-        data = new T[save_size];
-        Size = 0;
-    }
+    ArrayList(): Size(0), save_size(0), data(NULL), growth(2), gap_from(0), gap_len(0) {}
 
     /**
      * TODO Destructor
      */
     ~ArrayList() {
-        delete[] (data);
+        closeGap();
+        destroy(0, Size);
+        std::free(data);
     }
 
     /**
@@ -101,15 +272,11 @@ public:
      */
     ArrayList& operator=(const ArrayList& x) { 
         if (this != &x) {
-            if (save_size != x.save_size) {
-                delete [] (data);
-                save_size = x.save_size;
-                data = new T[save_size];
-            }
-
-            Size = x.Size;
-            for (int i = 0; i < Size; ++i)
-                data[i] = x.data[i];
+            clear();
+            growth = x.growth;
+            if (save_size < x.Size) reallocate(x.Size);
+            for (; Size < x.Size; ++Size)
+                new (data + Size) T(x.at(Size));
         }
         return (*this);
     }
@@ -118,11 +285,77 @@ public:
      * TODO Copy-constructor
      */
     ArrayList(const ArrayList& x) { 
-        Size = x.Size;
-        save_size = x.save_size;
-        data = new T[save_size];
-        for (int i = 0; i < Size; ++i)
-            data[i] = x.data[i];
+        copy(x);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    ArrayList(ArrayList&& x): Size(x.Size), save_size(x.save_size), data(x.data), growth(x.growth),
+            gap_from(x.gap_from), gap_len(x.gap_len) {
+        x.Size = x.save_size = x.gap_len = 0;
+        x.data = NULL;
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    ArrayList& operator=(ArrayList&& x) {
+        if (this != &x) {
+            closeGap();
+            destroy(0, Size);
+            std::free(data);
+            Size = x.Size, save_size = x.save_size, data = x.data, growth = x.growth;
+            gap_from = x.gap_from, gap_len = x.gap_len;
+            x.Size = x.save_size = x.gap_len = 0;
+            x.data = NULL;
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this list and x.
+     */
+    void swap(ArrayList& x) {
+        std::swap(Size, x.Size);
+        std::swap(save_size, x.save_size);
+        std::swap(data, x.data);
+        std::swap(growth, x.growth);
+        std::swap(gap_from, x.gap_from);
+        std::swap(gap_len, x.gap_len);
+    }
+
+    /**
+     * Sets the factor (> 1) by which a full list multiplies its capacity.
+     */
+    void setGrowthFactor(double f) {
+        if (f > 1) growth = f;
+    }
+
+    /**
+     * Makes room for at least n elements, so that adding up to n elements in
+     * all moves none of them.
+     */
+    void reserve(int n) {
+        closeGap();
+        if (n > save_size) reallocate(n);
+    }
+
+    /**
+     * Gives back the unused capacity.
+     */
+    void shrinkToFit() {
+        closeGap();
+        if (Size < save_size) reallocate(Size);
+    }
+
+    /**
+     * Returns the number of elements this list holds before it has to grow.
+     */
+    int capacity() const {
+        return save_size;
     }
 
     /**
@@ -130,11 +363,27 @@ public:
      * Always returns true.
      */
     bool add(const T& e) {
-        if (Size == save_size) doubleSpace();
-        data[Size++] = e;
+        emplace(e);
         return true;
     }
 
+    bool add(T&& e) {
+        emplace(std::move(e));
+        return true;
+    }
+
+    /**
+     * Appends an element made from args to the end of this list,
+     * built in place.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        closeGap();
+        if (Size == save_size) growAndEmplace(std::forward<Args>(args)...);
+        else new (data + Size) T(std::forward<Args>(args)...);
+        ++Size;
+    }
+
     /**
      * TODO Inserts the specified element to the specified position in this list.
      * The range of index parameter is [0, size], where index=0 means inserting to the head,
@@ -142,18 +391,37 @@ public:
      * @throw IndexOutOfBound
      */
     void add(int index, const T& element) {
-        if (index <0 || index > size) throw IndexOutOfBound();
-        if (Size == save_size) doubleSpace();
-        for (int i = Size - 1; i >= index; --i)
-            data[i + 1] = data[i];
-        data[index] = element;
+        T e(element);
+        add(index, std::move(e));
+    }
+
+    void add(int index, T&& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        closeGap();
+        if (index == Size) {
+            emplace(std::move(element));
+            return;
+        }
+        if (Size == save_size) reallocate(nextCapacity((long long) Size + 1));
+        if (Trivial) {
+            std::memmove((void *) (data + index + 1), (const void *) (data + index), (size_t) (Size - index) * sizeof(T));
+            new (data + index) T(std::move(element));
+        } else {
+            new (data + Size) T(std::move(data[Size - 1]));
+            for (int i = Size - 1; i > index; --i)
+                data[i] = std::move(data[i - 1]);
+            data[index] = std::move(element);
+        }
         ++Size;
     }
 
     /**
      * TODO Removes all of the elements from this list.
+     * The capacity is kept.
      */
     void clear() {
+        closeGap();
+        destroy(0, Size);
         Size = 0;
     }
 
@@ -161,9 +429,40 @@ public:
      * TODO Returns true if this list contains the specified element.
      */
     bool contains(const T& e) const {
-        for (int i = 0; i < Size; ++i)
-            if (data[i] == e) return true;
-        return false;
+        return indexOf(e) >= 0;
+    }
+
+    /**
+     * Returns the index of the first occurrence of the specified element in this list,
+     * or -1 if it is not there.
+     */
+    int indexOf(const T& e) const {
+        int n = firstPiece();
+        int i = Search<T>::indexOf(data, n, e);
+        if (i >= 0 || n == Size) return i;
+        i = Search<T>::indexOf(data + n + gap_len, Size - n, e);
+        return i < 0 ? -1 : n + i;
+    }
+
+    /**
+     * Returns the index of the last occurrence of the specified element in this list,
+     * or -1 if it is not there.
+     */
+    int lastIndexOf(const T& e) const {
+        int n = firstPiece();
+        if (n < Size) {
+            int i = Search<T>::lastIndexOf(data + n + gap_len, Size - n, e);
+            if (i >= 0) return n + i;
+        }
+        return Search<T>::lastIndexOf(data, n, e);
+    }
+
+    /**
+     * Returns the number of occurrences of the specified element in this list.
+     */
+    int count(const T& e) const {
+        int n = firstPiece();
+        return Search<T>::count(data, n, e) + Search<T>::count(data + n + gap_len, Size - n, e);
     }
 
     /**
@@ -173,7 +472,7 @@ public:
      */
     const T& get(int index) const {
         if (index < 0 || index >= Size) throw  IndexOutOfBound();
-        return data[index];    
+        return at(index);
     }
 
     /**
@@ -190,9 +489,15 @@ public:
      */
     void removeIndex(int index) {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
+        closeGap();
         --Size;
+        if (Trivial) {
+            std::memmove((void *) (data + index), (const void *) (data + index + 1), (size_t) (Size - index) * sizeof(T));
+            return;
+        }
         for (int i = index; i < Size; ++i)
-            data[i] = data[i + 1];
+            data[i] = std::move(data[i + 1]);
+        data[Size].~T();
     }
 
     /**
@@ -200,12 +505,10 @@ public:
      * Returns true if it was present in the list, otherwise false.
      */
     bool remove(const T &e) {
-        for (int i = 0; i < Size; ++i)
-            if (data[i] == e) {
-                removeIndex(i);
-                return true;
-            }
-        return false;
+        int i = indexOf(e);
+        if (i < 0) return false;
+        removeIndex(i);
+        return true;
     }
 
     /**
@@ -215,9 +518,100 @@ public:
      */
     void set(int index, const T &element) {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
+        closeGap();
         data[index] = element;
     }
 
+    void set(int index, T &&element) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        closeGap();
+        data[index] = std::move(element);
+    }
+
+    /**
+     * Inserts the elements of [first, last) at the specified position, shifting the
+     * following elements once. I is a forward iterator (a pointer will do); the range
+     * must not point into this list.
+     * @throw IndexOutOfBound
+     * @throw std::bad_alloc if the list would hold more than INT_MAX elements
+     */
+    template <class I>
+    void insertRange(int index, I first, I last) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        closeGap();
+        long long len = 0;
+        for (I i = first; i != last; ++i) ++len;
+        if (len == 0) return;
+        if (Size + len > save_size) reallocate(nextCapacity(Size + len));
+        int n = (int) len;
+        relocateBackward(data + index + n, data + index, Size - index);
+        int k = 0;
+        try {
+            for (; first != last; ++first, ++k)
+                new (data + index + k) T(*first);
+        } catch (...) {
+            destroy(index, index + k);
+            relocate(data + index, data + index + n, Size - index);
+            throw;
+        }
+        Size += n;
+    }
+
+    /**
+     * Appends all of the elements of x to the end of this list.
+     */
+    void addAll(const ArrayList& x) {
+        addAll(Size, x);
+    }
+
+    /**
+     * Inserts all of the elements of x at the specified position.
+     * @throw IndexOutOfBound
+     */
+    void addAll(int index, const ArrayList& x) {
+        if (&x == this) {
+            ArrayList c(x);
+            insertRange(index, c.data, c.data + c.Size);
+        } else {
+            int n = x.firstPiece();
+            insertRange(index, x.data, x.data + n);
+            insertRange(index + n, x.data + n + x.gap_len, x.data + x.Size + x.gap_len);
+        }
+    }
+
+    /**
+     * Removes the elements whose index is in [from, to), shifting the following
+     * elements once.
+     * @throw IndexOutOfBound
+     */
+    void removeRange(int from, int to) {
+        if (from < 0 || to > Size || from > to) throw IndexOutOfBound();
+        if (from == to) return;
+        closeGap();
+        destroy(from, to);
+        relocate(data + from, data + to, Size - to);
+        Size -= to - from;
+    }
+
+    /**
+     * Removes every element e for which pred(e) is true, in one pass.
+     * Returns the number of elements removed.
+     */
+    template <class F>
+    int removeIf(F pred) {
+        closeGap();
+        int n = 0;
+        for (int i = 0; i < Size; ++i) {
+            if (pred((const T &) data[i])) continue;
+            if (n != i) data[n] = std::move(data[i]);
+            ++n;
+        }
+        int removed = Size - n;
+        destroy(n, Size);
+        Size = n;
+        return removed;
+    }
+
     /**
      * TODO Returns the number of elements in this list.
      */
@@ -0,0 +1,405 @@
+/** @file */
+#ifndef __CONCURRENTHASHMAP_H
+#define __CONCURRENTHASHMAP_H
+
+#include "HashMap.h"
+#include "ArrayList.h"
+#include "Epoch.h"
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * ConcurrentHashMap is a HashMap which may be used by many threads at once.
+ *
+ * The keys are split by hash into a power-of-two number of segments, each a
+ * chained hash table with its own lock. put(), remove() and clear() lock the
+ * segments they change; get(), containsKey() and containsValue() take no lock
+ * at all: they only hold an Epoch::Guard, and the nodes unlinked by writers are
+ * deleted through Epoch::retire() once no reader can see them.
+ *
+ * A node never changes after it is published: put() on a present key links a
+ * new node in place of the old one, and a segment grows by building a new
+ * table of new nodes. So a reader always sees a whole (key, value) pair.
+ *
+ * Unlike HashMap::get(), get() returns the value by copy, since the node holding
+ * it may be deleted as soon as the call returns. The iterator walks a snapshot
+ * taken by iterator(); a pair put or removed while the snapshot is taken may or
+ * may not be in it.
+ *
+ * Template argument H is the hash function, as in HashMap.
+ */
+template <class K, class V, class H>
+class ConcurrentHashMap {
+public:
+    class Entry{
+        public:
+        K key;
+        V value;
+
+        Entry() {}
+        Entry(const K &k, const V &v): key(k), value(v) {}
+
+        K getKey() const {
+            return key;
+        }
+
+        V getValue() const {
+            return value;
+        }
+    };
+    class Iterator;
+
+private:
+    static const int Default_segments = 16;
+    static const int Default_capacity = 16;
+
+    struct Node {
+        const K key;
+        const V value;
+        const unsigned int hash;
+        std::atomic<Node *> next;
+        Node(const K &k, const V &v, unsigned int h, Node *n): key(k), value(v), hash(h), next(n) {}
+    };
+
+    /*
+     * The buckets follow the Table in the same block of memory (see newTable)
+     */
+    struct Table {
+        std::atomic<Node *> *head;
+        int save_size;
+        unsigned int mask;
+
+        Table(int c): save_size(c), mask(c - 1) {
+            head = (std::atomic<Node *> *) (this + 1);
+            for (int i = 0; i < c; ++i)
+                new (head + i) std::atomic<Node *>(NULL);
+        }
+
+        ~Table() {
+            for (int i = 0; i < save_size; ++i)
+                for (Node *x, *k = head[i].load(std::memory_order_relaxed); k != NULL; k = x) {
+                    x = k->next.load(std::memory_order_relaxed);
+                    delete k;
+                }
+        }
+    };
+
+    /*
+     * A table and its c buckets are one block from operator new, and only
+     * deleteTable gives it back, with operator delete; Epoch::retire() is given
+     * deleteTable too. Nothing can throw between the two, so the block always
+     * goes back the way it came.
+     */
+    static Table *newTable(int c) {
+        void *p = ::operator new(sizeof(Table) + (size_t) c * sizeof(std::atomic<Node *>));
+        return new (p) Table(c);
+    }
+
+    static void deleteTable(void *p) {
+        ((Table *) p)->~Table();
+        ::operator delete(p);
+    }
+
+    /*
+     * @var used the number of pairs in the segment, only changed under lock
+     * @var pad keeps the next segment off this cache line, so writers of
+     *  different segments do not share one
+     */
+    struct Segment {
+        std::mutex lock;
+        std::atomic<Table *> table;
+        std::atomic<int> used;
+        char pad[64];
+    };
+
+    Segment *seg;
+    int seg_count;
+    unsigned int seg_shift;
+
+    H func;
+
+    inline unsigned int get_hash(const K &key) const {
+        return mix_hash((unsigned int) func.hashCode(key));
+    }
+
+    /*
+     * The high bits of the hash choose the segment, the low bits the bucket.
+     */
+    Segment &segmentOf(unsigned int h) const {
+        return seg[seg_count == 1 ? 0 : h >> seg_shift];
+    }
+
+    void init(int segments) {
+        seg_count = 1;
+        seg_shift = 32;
+        while (seg_count < segments) seg_count *= 2, --seg_shift;
+        seg = new Segment[seg_count];
+        for (int i = 0; i < seg_count; ++i) {
+            seg[i].table.store(newTable(Default_capacity));
+            seg[i].used.store(0);
+        }
+        func = H();
+    }
+
+    void destroy() {
+        for (int i = 0; i < seg_count; ++i)
+            deleteTable(seg[i].table.load());
+        delete[] seg;
+    }
+
+    /*
+     * Double the table of a locked segment. The old nodes stay readable until
+     * the readers which may still walk the old table are done.
+     */
+    void grow(Segment &s) {
+        Table *t = s.table.load(std::memory_order_relaxed);
+        Table *nt = newTable(t->save_size * 2);
+        for (int i = 0; i < t->save_size; ++i)
+            for (Node *k = t->head[i].load(std::memory_order_relaxed); k != NULL;
+                    k = k->next.load(std::memory_order_relaxed)) {
+                std::atomic<Node *> &h = nt->head[k->hash & nt->mask];
+                h.store(new Node(k->key, k->value, k->hash, h.load(std::memory_order_relaxed)),
+                        std::memory_order_relaxed);
+            }
+        s.table.store(nt, std::memory_order_release);
+        Epoch::retire(t, &deleteTable);
+    }
+
+    /*
+     * Call f(node) for every node, under a guard
+     */
+    template <class F>
+    void forEach(F &f) const {
+        Epoch::Guard g;
+        for (int i = 0; i < seg_count; ++i) {
+            Table *t = seg[i].table.load(std::memory_order_acquire);
+            for (int j = 0; j < t->save_size; ++j)
+                for (Node *k = t->head[j].load(std::memory_order_acquire); k != NULL;
+                        k = k->next.load(std::memory_order_acquire))
+                    if (f(k)) return;
+        }
+    }
+
+    struct PutAll {
+        ConcurrentHashMap *to;
+        bool operator()(const Node *k) { to->put(k->key, k->value); return false; }
+    };
+
+    struct Collect {
+        ArrayList<Entry> *to;
+        bool operator()(const Node *k) { to->add(Entry(k->key, k->value)); return false; }
+    };
+
+    struct FindValue {
+        const V *value;
+        bool found;
+        bool operator()(const Node *k) { return found = (k->value == *value); }
+    };
+
+public:
+
+    /**
+     * Constructs an empty map with Default_segments segments.
+     */
+    ConcurrentHashMap() {
+        init(Default_segments);
+    }
+
+    /**
+     * Constructs an empty map with at least the given number of segments.
+     * More segments let more writers work at once.
+     */
+    explicit ConcurrentHashMap(int segments) {
+        init(segments);
+    }
+
+    /**
+     * Destructor
+     * No other thread may use the map any more.
+     */
+    ~ConcurrentHashMap() {
+        destroy();
+    }
+
+    /**
+     * Copy-constructor
+     * Copies a snapshot of x, as the iterator sees it.
+     */
+    ConcurrentHashMap(const ConcurrentHashMap &x) {
+        init(x.seg_count);
+        PutAll f = {this};
+        x.forEach(f);
+    }
+
+    /**
+     * Assignment operator
+     * No other thread may use this map during the assignment.
+     */
+    ConcurrentHashMap &operator=(const ConcurrentHashMap &x) {
+        if (this != &x) {
+            clear();
+            PutAll f = {this};
+            x.forEach(f);
+        }
+        return *this;
+    }
+
+    /**
+     * Returns an iterator over a snapshot of the pairs in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        for (int i = 0; i < seg_count; ++i) {
+            std::lock_guard<std::mutex> l(seg[i].lock);
+            Table *t = seg[i].table.load(std::memory_order_relaxed);
+            seg[i].table.store(newTable(Default_capacity), std::memory_order_release);
+            seg[i].used.store(0, std::memory_order_relaxed);
+            Epoch::retire(t, &deleteTable);
+        }
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        unsigned int h = get_hash(key);
+        Epoch::Guard g;
+        Table *t = segmentOf(h).table.load(std::memory_order_acquire);
+        for (Node *k = t->head[h & t->mask].load(std::memory_order_acquire); k != NULL;
+                k = k->next.load(std::memory_order_acquire))
+            if (k->hash == h && k->key == key) return true;
+        return false;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        FindValue f = {&value, false};
+        forEach(f);
+        return f.found;
+    }
+
+    /**
+     * Returns a copy of the value to which the specified key is mapped.
+     * If the key is not present in this map, this function should throw ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    V get(const K &key) const {
+        unsigned int h = get_hash(key);
+        Epoch::Guard g;
+        Table *t = segmentOf(h).table.load(std::memory_order_acquire);
+        for (Node *k = t->head[h & t->mask].load(std::memory_order_acquire); k != NULL;
+                k = k->next.load(std::memory_order_acquire))
+            if (k->hash == h && k->key == key) return k->value;
+        throw ElementNotExist();
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        unsigned int h = get_hash(key);
+        Segment &s = segmentOf(h);
+        std::lock_guard<std::mutex> l(s.lock);
+        Table *t = s.table.load(std::memory_order_relaxed);
+        std::atomic<Node *> &head = t->head[h & t->mask];
+        for (std::atomic<Node *> *p = &head; ; ) {
+            Node *k = p->load(std::memory_order_relaxed);
+            if (k == NULL) break;
+            if (k->hash == h && k->key == key) {
+                p->store(new Node(key, value, h, k->next.load(std::memory_order_relaxed)),
+                        std::memory_order_release);
+                Epoch::retire(k);
+                return;
+            }
+            p = &k->next;
+        }
+        head.store(new Node(key, value, h, head.load(std::memory_order_relaxed)),
+                std::memory_order_release);
+        int n = s.used.load(std::memory_order_relaxed) + 1;
+        s.used.store(n, std::memory_order_relaxed);
+        if (n > t->save_size) grow(s);
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map if present.
+     * If there is no mapping for the specified key, throws ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        unsigned int h = get_hash(key);
+        Segment &s = segmentOf(h);
+        std::lock_guard<std::mutex> l(s.lock);
+        Table *t = s.table.load(std::memory_order_relaxed);
+        for (std::atomic<Node *> *p = &t->head[h & t->mask]; ; ) {
+            Node *k = p->load(std::memory_order_relaxed);
+            if (k == NULL) break;
+            if (k->hash == h && k->key == key) {
+                p->store(k->next.load(std::memory_order_relaxed), std::memory_order_release);
+                s.used.store(s.used.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+                Epoch::retire(k);
+                return;
+            }
+            p = &k->next;
+        }
+        throw ElementNotExist();
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     * While other threads write, the count may be a little out of date.
+     */
+    int size() const {
+        int n = 0;
+        for (int i = 0; i < seg_count; ++i)
+            n += seg[i].used.load(std::memory_order_relaxed);
+        return n;
+    }
+};
+
+template <class K, class V, class H>
+class ConcurrentHashMap<K, V, H>::Iterator {
+    private:
+        ArrayList<Entry> snapshot;
+        int index;
+
+    public:
+        Iterator(): index(-1) {}
+        Iterator(const ConcurrentHashMap *c): index(-1) {
+            Collect f = {&snapshot};
+            c->forEach(f);
+        }
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return index + 1 < snapshot.size();
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            if (!hasNext()) throw ElementNotExist();
+            return snapshot.get(++index);
+        }
+    };
+
+#endif
@@ -0,0 +1,353 @@
+/** @file */
+#ifndef __CONCURRENTQUEUE_H
+#define __CONCURRENTQUEUE_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Bounded lock-free FIFO queues for passing elements between threads.
+ *
+ * SpscQueue allows one pushing thread and one popping thread at a time,
+ * MpmcQueue any number of each. Both keep the elements like Deque does: a
+ * power-of-two ring of raw slots, indexed with a mask, in which only the queued
+ * elements are constructed. The capacity is fixed when the queue is made.
+ *
+ * tryPush() and tryPop() never wait: they return false when the queue is full or
+ * empty. push() and pop() wait (spinning, then yielding the processor) until
+ * they succeed.
+ * @code
+ *      SpscQueue<Task> q(1024);
+ *      // producer                 // consumer
+ *      q.push(task);               Task t = q.pop();
+ * @endcode
+ * The counters written by the two sides are kept Line bytes apart, so that the
+ * producer and the consumer do not fight over one cache line.
+ *
+ * QueueWait holds what both queues share: the cache line size and the way
+ * they wait.
+ */
+class QueueWait {
+public:
+    static const int Line = 64;
+
+    /*
+     * Called by push() and pop() after the n-th failed try
+     */
+    static void backoff(int n) {
+        if (n > 64) std::this_thread::yield();
+    }
+};
+
+/**
+ * Single-producer single-consumer queue.
+ * The producer owns tail and the consumer owns head; each also keeps the last
+ * value it saw of the other's counter, and only reads the shared one again when
+ * the cached value says the queue is full (or empty).
+ */
+template <class T>
+class SpscQueue {
+    /*
+     * @var head_cache the producer's copy of head
+     * @var tail_cache the consumer's copy of tail
+     */
+    T *data;
+    int save_size;
+    unsigned long mask;
+    char pad0[QueueWait::Line];
+    std::atomic<unsigned long> head;
+    unsigned long tail_cache;
+    char pad1[QueueWait::Line];
+    std::atomic<unsigned long> tail;
+    unsigned long head_cache;
+    char pad2[QueueWait::Line];
+
+    SpscQueue(const SpscQueue &);
+    SpscQueue &operator=(const SpscQueue &);
+
+public:
+    /**
+     * Constructs an empty queue which holds at least c elements.
+     */
+    explicit SpscQueue(int c) {
+        save_size = 2;
+        while (save_size < c) save_size *= 2;
+        mask = save_size - 1;
+        data = (T *) std::malloc(save_size * sizeof(T));
+        if (data == NULL) throw std::bad_alloc();
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        head_cache = tail_cache = 0;
+    }
+
+    /**
+     * Destructor
+     * No other thread may use the queue any more.
+     */
+    ~SpscQueue() {
+        unsigned long t = tail.load(std::memory_order_relaxed);
+        for (unsigned long h = head.load(std::memory_order_relaxed); h != t; ++h)
+            data[h & mask].~T();
+        std::free(data);
+    }
+
+    /**
+     * Appends an element made from args if the queue is not full.
+     * Only the producer may call it. Returns false if the queue is full.
+     */
+    template <class... Args>
+    bool tryEmplace(Args&&... args) {
+        unsigned long t = tail.load(std::memory_order_relaxed);
+        if (t - head_cache == (unsigned long) save_size) {
+            head_cache = head.load(std::memory_order_acquire);
+            if (t - head_cache == (unsigned long) save_size) return false;
+        }
+        new (data + (t & mask)) T(std::forward<Args>(args)...);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T &e) {
+        return tryEmplace(e);
+    }
+
+    bool tryPush(T &&e) {
+        return tryEmplace(std::move(e));
+    }
+
+    /**
+     * Appends e, waiting while the queue is full.
+     */
+    void push(const T &e) {
+        for (int n = 0; !tryPush(e); ++n) QueueWait::backoff(n);
+    }
+
+    void push(T &&e) {
+        for (int n = 0; !tryPush(std::move(e)); ++n) QueueWait::backoff(n);
+    }
+
+    /**
+     * Moves the first element into e and removes it, if the queue is not empty.
+     * Only the consumer may call it. Returns false if the queue is empty.
+     */
+    bool tryPop(T &e) {
+        unsigned long h = head.load(std::memory_order_relaxed);
+        if (h == tail_cache) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) return false;
+        }
+        T &x = data[h & mask];
+        e = std::move(x);
+        x.~T();
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes and returns the first element, waiting while the queue is empty.
+     */
+    T pop() {
+        unsigned long h = head.load(std::memory_order_relaxed);
+        for (int n = 0; h == tail_cache; ++n) {
+            tail_cache = tail.load(std::memory_order_acquire);
+            if (h == tail_cache) QueueWait::backoff(n);
+        }
+        T &x = data[h & mask];
+        T e(std::move(x));
+        x.~T();
+        head.store(h + 1, std::memory_order_release);
+        return e;
+    }
+
+    /**
+     * Returns the number of elements in the queue. While the other side works,
+     * it may be out of date as soon as it returns.
+     */
+    int size() const {
+        unsigned long h = head.load(std::memory_order_acquire);
+        return (int) (tail.load(std::memory_order_acquire) - h);
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the number of elements the queue holds when full.
+     */
+    int capacity() const {
+        return save_size;
+    }
+};
+
+/**
+ * Multi-producer multi-consumer queue (D. Vyukov's bounded queue).
+ * Every slot has a sequence number telling whose turn it is: a slot at
+ * position p may be written when its sequence is p, and read when it is p + 1;
+ * reading sets it to p + capacity, the position of the next lap. A thread claims
+ * a position with a compare-and-swap on tail (or head), so threads only contend
+ * on those counters and on the slots they use.
+ */
+template <class T>
+class MpmcQueue {
+    struct Cell {
+        std::atomic<unsigned long> seq;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type value;
+    };
+
+    Cell *cell;
+    int save_size;
+    unsigned long mask;
+    char pad0[QueueWait::Line];
+    std::atomic<unsigned long> tail;
+    char pad1[QueueWait::Line];
+    std::atomic<unsigned long> head;
+    char pad2[QueueWait::Line];
+
+    MpmcQueue(const MpmcQueue &);
+    MpmcQueue &operator=(const MpmcQueue &);
+
+    /*
+     * Claim the slot of the next push; NULL if the queue is full
+     */
+    Cell *claimPush(unsigned long &pos) {
+        pos = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell *c = &cell[pos & mask];
+            long d = (long) (c->seq.load(std::memory_order_acquire) - pos);
+            if (d == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return c;
+            } else if (d < 0) return NULL;
+            else pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * Claim the slot of the next pop; NULL if the queue is empty
+     */
+    Cell *claimPop(unsigned long &pos) {
+        pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell *c = &cell[pos & mask];
+            long d = (long) (c->seq.load(std::memory_order_acquire) - (pos + 1));
+            if (d == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return c;
+            } else if (d < 0) return NULL;
+            else pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+public:
+    /**
+     * Constructs an empty queue which holds at least c elements.
+     */
+    explicit MpmcQueue(int c) {
+        save_size = 2;
+        while (save_size < c) save_size *= 2;
+        mask = save_size - 1;
+        cell = new Cell[save_size];
+        for (int i = 0; i < save_size; ++i)
+            cell[i].seq.store(i, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        head.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Destructor
+     * No other thread may use the queue any more.
+     */
+    ~MpmcQueue() {
+        unsigned long t = tail.load(std::memory_order_relaxed);
+        for (unsigned long h = head.load(std::memory_order_relaxed); h != t; ++h)
+            ((T *) &cell[h & mask].value)->~T();
+        delete[] cell;
+    }
+
+    /**
+     * Appends an element made from args if the queue is not full.
+     * Returns false if the queue is full.
+     */
+    template <class... Args>
+    bool tryEmplace(Args&&... args) {
+        unsigned long pos;
+        Cell *c = claimPush(pos);
+        if (c == NULL) return false;
+        new (&c->value) T(std::forward<Args>(args)...);
+        c->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T &e) {
+        return tryEmplace(e);
+    }
+
+    bool tryPush(T &&e) {
+        return tryEmplace(std::move(e));
+    }
+
+    /**
+     * Appends e, waiting while the queue is full.
+     */
+    void push(const T &e) {
+        for (int n = 0; !tryPush(e); ++n) QueueWait::backoff(n);
+    }
+
+    void push(T &&e) {
+        for (int n = 0; !tryPush(std::move(e)); ++n) QueueWait::backoff(n);
+    }
+
+    /**
+     * Moves the first element into e and removes it, if the queue is not empty.
+     * Returns false if the queue is empty.
+     */
+    bool tryPop(T &e) {
+        unsigned long pos;
+        Cell *c = claimPop(pos);
+        if (c == NULL) return false;
+        T *x = (T *) &c->value;
+        e = std::move(*x);
+        x->~T();
+        c->seq.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Removes and returns the first element, waiting while the queue is empty.
+     */
+    T pop() {
+        unsigned long pos;
+        Cell *c;
+        for (int n = 0; (c = claimPop(pos)) == NULL; ++n) QueueWait::backoff(n);
+        T *x = (T *) &c->value;
+        T e(std::move(*x));
+        x->~T();
+        c->seq.store(pos + mask + 1, std::memory_order_release);
+        return e;
+    }
+
+    /**
+     * Returns the number of elements in the queue; only a hint while other
+     * threads work.
+     */
+    int size() const {
+        long n = (long) (tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+        return n < 0 ? 0 : (int) n;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the number of elements the queue holds when full.
+     */
+    int capacity() const {
+        return save_size;
+    }
+};
+
+#endif
@@ -4,56 +4,146 @@
 
 #include "ElementNotExist.h"
 #include "IndexOutOfBound.h"
+#include "Search.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /**
  * An deque is a linear collection that supports element insertion and removal at both ends.
  * The name deque is short for "double ended queue" and is usually pronounced "deck".
  * Remember: all functions but "contains" and "clear" should be finished in O(1) time.
+ * add(index, e) and removeIndex(index) move the elements on the shorter side of
+ * index, so they take O(min(index, size - index)) time.
+ *
+ * The elements live in a circular buffer whose length is a power of two: the i-th
+ * element is data[(head + i) & mask], and either end may wrap around. The buffer
+ * only grows when it is full, so a queue (addLast + removeFirst) whose size stays
+ * bounded never grows. Like ArrayList, the buffer is raw memory and only the slots
+ * of the elements hold constructed T.
  *
- * You need to implement both iterators in proper sequential order and ones in reverse sequential order. 
+ * Template argument P chooses the layout. The default, RingBuffer, is the circular
+ * buffer above. BlockMap (see DequeBlocks.h) keeps the elements in fixed-size blocks
+ * reached through a map of block pointers, so growing never moves an element:
+ * @code
+ *      Deque<int, BlockMap> deque;
+ * @endcode
+ *
+ * You need to implement both iterators in proper sequential order and ones in reverse sequential order.
  */
-template <class T>
+class RingBuffer {};
+class BlockMap {};
+
+template <class T, class P = RingBuffer>
 class Deque
 {
+    static const int Min_capacity = 4;
+    static const bool Trivial = std::is_trivially_copyable<T>::value;
 
-    int Size, head, tail;
-    int save_size;
+    /*
+     * @var save_size the length of data, 0 or a power of two
+     * @var mask save_size - 1
+     */
+    int Size, head;
+    int save_size, mask;
     T *data;
 
+    inline T &at(int i) const {
+        return data[(head + i) & mask];
+    }
+
+    /*
+     * Move the elements, in order, to the front of a new buffer of length n (a power of two >= Size)
+     */
+    void reallocate(int n) {
+        T *new_data = NULL;
+        if (n > 0) {
+            new_data = (T *) std::malloc((size_t) n * sizeof(T));
+            if (new_data == NULL) throw std::bad_alloc();
+        }
+        int first = Size < save_size - head ? Size : save_size - head;
+        relocate(new_data, data + head, first);
+        relocate(new_data + first, data, Size - first);
+        std::free(data);
+        data = new_data;
+        save_size = n;
+        mask = n - 1;
+        head = 0;
+    }
+
+    static void relocate(T *to, T *from, int n) {
+        if (Trivial) {
+            if (n > 0) std::memcpy((void *) to, (const void *) from, (size_t) n * sizeof(T));
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            new (to + i) T(std::move(from[i]));
+            from[i].~T();
+        }
+    }
+
 /*
- * double the space of data 
- * The mid between head and tail ( mid = (head + tail) / 2 ) would be save_size / 2.
+ * double the space of data
+ * A deque which has been moved from has no space at all.
  */
-
     void doubleSpace() {
-        save_size *= 2;
-        T *new_data = new T[save_size];
-        int new_head = save_size / 2 - Size / 2;
-        int new_tail = new_head + Size - 1;
-        for (int i = head, j = new_head; i <= tail; ++i, ++j)
-            new_data[j] = data[i];
-        head = new_head;
-        tail = new_tail;
-        delete[] (data);
-        data = new_data; 
-    }
-
-    void removeIndex(int direction, int Index) {
+        reallocate(save_size == 0 ? Min_capacity : save_size * 2);
+    }
+
+    void destroyAll() {
+        if (!std::is_trivially_destructible<T>::value)
+            for (int i = 0; i < Size; ++i)
+                at(i).~T();
+    }
+
+    void copy(const Deque& x) {
+        Size = 0, head = 0;
+        save_size = 0, mask = -1;
+        data = NULL;
+        if (x.Size > 0) reallocate(capacityFor(x.Size));
+        for (; Size < x.Size; ++Size)
+            new (data + Size) T(x.at(Size));
+    }
+
+    /*
+     * The smallest power of two which holds n elements
+     */
+    static int capacityFor(int n) {
+        int c = Min_capacity;
+        while (c < n) c *= 2;
+        return c;
+    }
+
+    /*
+     * Remove the first or the last element
+     */
+    void popFront() {
+        data[head].~T();
+        head = (head + 1) & mask;
         --Size;
-        if (direction == 0) {
-            --tail;
-            for (int i = Index; i <= tail; ++i)
-                data[i] = data[i + 1];
-        } else {
-            ++head;
-            for (int i = Index; i >= head; --i)
-                data[i] = data[i - 1];
-        }
+    }
+
+    void popBack() {
+        at(Size - 1).~T();
+        --Size;
+    }
+
+    /*
+     * The number of elements from head to the end of data; the rest wrap around to data[0]
+     */
+    int firstPiece() const {
+        return Size < save_size - head ? Size : save_size - head;
     }
 
 public:
     class Iterator
     {
+        /*
+         * index is the position of the last returned element: -1 or size() before the first next()
+         */
         int index;
         int direction;
         Deque *container;
@@ -62,15 +152,15 @@ public:
 
         Iterator() {}
         Iterator(Deque *con, int x): dead(false), container(con), direction(x){
-            if (x == 0) index = container->head - 1; else index = container->tail + 1;
+            if (x == 0) index = -1; else index = container->Size;
         }
 
         /**
          * TODO Returns true if the iteration has more elements.
          */
         bool hasNext() {
-            if (direction == 0) return index <= container->tail - 1 && index >= container->head - 1;
-        	else return index >= container->head + 1 && index <= container->tail + 1;
+            if (direction == 0) return index + 1 < container->Size;
+        	else return index - 1 >= 0;
         }
 
         /**
@@ -80,8 +170,8 @@ public:
         const T &next() {
             if (!hasNext()) throw ElementNotExist();
             if (dead) dead = false;
-            if (direction == 0) return container->data[++index];
-            return container->data[--index];
+            if (direction == 0) return container->at(++index);
+            return container->at(--index);
         }
 
         /**
@@ -93,48 +183,37 @@ public:
          * @throw ElementNotExist
          */
         void remove() {
-            if (index < container->head || container->tail < index || dead) throw ElementNotExist();
+            if (index < 0 || container->Size <= index || dead) throw ElementNotExist();
             dead = true;
             if (direction == 0) {
-                container->removeIndex(0, index--);
-            } else container->removeIndex(1, index++);
+                container->removeIndex(index--);
+            } else container->removeIndex(index);
 
         }
     };
 
     /**
      * TODO Constructs an empty deque.
+     * No memory is taken before the first element is added.
      */
-    Deque() { 
-        save_size = 4;
-        Size = 0;
-        data = new T[save_size];
-        head = save_size / 2;
-        tail = head - 1;
-    }
+    Deque(): Size(0), head(0), save_size(0), mask(-1), data(NULL) {}
 
     /**
      * TODO Destructor
      */
-    ~Deque() { 
-        delete[] (data);
+    ~Deque() {
+        destroyAll();
+        std::free(data);
     }
 
     /**
      * TODO Assignment operator
      */
-    Deque& operator=(const Deque& x) { 
+    Deque& operator=(const Deque& x) {
         if (this != &x) {
-            if (save_size != x.save_size) {
-                delete [] (data);
-                save_size = x.save_size;
-                data = new T[save_size];
-            }
-
-            Size = x.Size;
-            head = x.head, tail = x.tail;
-            for (int i = head; i <= tail; ++i)
-                data[i] = x.data[i];
+            destroyAll();
+            std::free(data);
+            copy(x);
         }
         return (*this);
     }
@@ -143,54 +222,163 @@ public:
      * TODO Copy-constructor
      */
     Deque(const Deque& x) {
-        save_size = x.save_size;
-        Size = x.Size;
-        data = new T[save_size];
-        head = x.head, tail = x.tail;
-        for (int i = head; i <= tail; ++i)
-            data[i] = x.data[i];
-    }
-	
+        copy(x);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    Deque(Deque&& x): Size(x.Size), head(x.head), save_size(x.save_size), mask(x.mask), data(x.data) {
+        x.data = NULL;
+        x.save_size = x.Size = x.head = 0;
+        x.mask = -1;
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    Deque& operator=(Deque&& x) {
+        if (this != &x) {
+            destroyAll();
+            std::free(data);
+            Size = x.Size, head = x.head;
+            save_size = x.save_size, mask = x.mask, data = x.data;
+            x.data = NULL;
+            x.save_size = x.Size = x.head = 0;
+            x.mask = -1;
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this deque and x.
+     */
+    void swap(Deque& x) {
+        std::swap(Size, x.Size);
+        std::swap(head, x.head);
+        std::swap(save_size, x.save_size);
+        std::swap(mask, x.mask);
+        std::swap(data, x.data);
+    }
+
+    /**
+     * Shrinks the buffer to the smallest power of two which holds the elements,
+     * or gives it back if the deque is empty.
+     */
+    void shrinkToFit() {
+        int n = Size == 0 ? 0 : capacityFor(Size);
+        if (n < save_size) reallocate(n);
+    }
+
+    /**
+     * Returns the number of elements this deque holds before it has to grow.
+     */
+    int capacity() const {
+        return save_size;
+    }
+
 	/**
-	 * TODO Inserts the specified element at the front of this deque. 
+	 * TODO Inserts the specified element at the front of this deque.
 	 */
-	void addFirst(const T& e) { 
-        if (head == 0) doubleSpace();
+	void addFirst(const T& e) {
+        emplaceFirst(e);
+    }
+
+	void addFirst(T&& e) {
+        emplaceFirst(std::move(e));
+    }
+
+	/**
+	 * Inserts an element made from args at the front of this deque, built in place.
+	 */
+	template <class... Args>
+	void emplaceFirst(Args&&... args) {
+        if (Size == save_size) {
+            T e(std::forward<Args>(args)...);
+            doubleSpace();
+            new (data + ((head - 1) & mask)) T(std::move(e));
+        } else new (data + ((head - 1) & mask)) T(std::forward<Args>(args)...);
+        head = (head - 1) & mask;
         ++Size;
-        data[--head] = e;
     }
 
 	/**
 	 * TODO Inserts the specified element at the end of this deque.
 	 */
-	void addLast(const T& e) { 
-        if (tail == save_size - 1) doubleSpace();
+	void addLast(const T& e) {
+        emplaceLast(e);
+    }
+
+	void addLast(T&& e) {
+        emplaceLast(std::move(e));
+    }
+
+	/**
+	 * Inserts an element made from args at the end of this deque, built in place.
+	 */
+	template <class... Args>
+	void emplaceLast(Args&&... args) {
+        if (Size == save_size) {
+            T e(std::forward<Args>(args)...);
+            doubleSpace();
+            new (&at(Size)) T(std::move(e));
+        } else new (&at(Size)) T(std::forward<Args>(args)...);
         ++Size;
-        data[++tail] = e;
     }
 
 	/**
 	 * TODO Returns true if this deque contains the specified element.
 	 */
-	bool contains(const T& e) const { 
-        for (int i = head; i <= tail; ++i)
-            if (data[i] == e) return true;
-        return false;
+	bool contains(const T& e) const {
+        return indexOf(e) >= 0;
+    }
+
+	/**
+	 * Returns the index of the first occurrence of the specified element, or -1.
+	 */
+	int indexOf(const T& e) const {
+        int n = firstPiece();
+        int i = Search<T>::indexOf(data + head, n, e);
+        if (i >= 0 || n == Size) return i;
+        i = Search<T>::indexOf(data, Size - n, e);
+        return i < 0 ? -1 : n + i;
+    }
+
+	/**
+	 * Returns the index of the last occurrence of the specified element, or -1.
+	 */
+	int lastIndexOf(const T& e) const {
+        int n = firstPiece();
+        if (n < Size) {
+            int i = Search<T>::lastIndexOf(data, Size - n, e);
+            if (i >= 0) return n + i;
+        }
+        return Search<T>::lastIndexOf(data + head, n, e);
+    }
+
+	/**
+	 * Returns the number of occurrences of the specified element in this deque.
+	 */
+	int count(const T& e) const {
+        int n = firstPiece();
+        return Search<T>::count(data + head, n, e) + Search<T>::count(data, Size - n, e);
     }
 
 	/**
 	 * TODO Removes all of the elements from this deque.
 	 */
-	 void clear() { 
+	 void clear() {
+        destroyAll();
         Size = 0;
-        head = save_size / 2;
-        tail = head - 1;
+        head = 0;
      }
 
 	 /**
 	  * TODO Returns true if this deque contains no elements.
 	  */
-	bool isEmpty() const { 
+	bool isEmpty() const {
         return Size == 0;
     }
 
@@ -198,7 +386,7 @@ public:
 	 * TODO Retrieves, but does not remove, the first element of this deque.
 	 * @throw ElementNotExist
 	 */
-	 const T& getFirst() { 
+	 const T& getFirst() {
         if (Size == 0) throw ElementNotExist();
         return data[head];
      }
@@ -207,27 +395,79 @@ public:
 	  * TODO Retrieves, but does not remove, the last element of this deque.
 	  * @throw ElementNotExist
 	  */
-	 const T& getLast() { 
+	 const T& getLast() {
         if (Size == 0) throw ElementNotExist();
-        return data[tail];
+        return at(Size - 1);
      }
 
 	 /**
 	  * TODO Removes the first element of this deque.
 	  * @throw ElementNotExist
 	  */
-	void removeFirst() { 
+	void removeFirst() {
         if (Size == 0) throw ElementNotExist();
-        ++head, --Size;
+        popFront();
     }
 
 	/**
 	 * TODO Removes the last element of this deque.
 	 * @throw ElementNotExist
 	 */
-	void removeLast() { 
+	void removeLast() {
         if (Size == 0) throw ElementNotExist();
-        --tail, --Size;
+        popBack();
+    }
+
+	/**
+	 * Inserts the specified element at the specified position in this deque.
+	 * The range of index parameter is [0, size]. The elements before or after
+	 * index, whichever are fewer, move one slot.
+	 * @throw IndexOutOfBound
+	 */
+	void add(int index, const T& e) {
+        T x(e);
+        add(index, std::move(x));
+    }
+
+	void add(int index, T&& e) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        if (index < Size - index) {
+            if (index == 0) {
+                emplaceFirst(std::move(e));
+                return;
+            }
+            emplaceFirst(std::move(at(0)));
+            for (int i = 1; i < index; ++i)
+                at(i) = std::move(at(i + 1));
+        } else {
+            if (index == Size) {
+                emplaceLast(std::move(e));
+                return;
+            }
+            emplaceLast(std::move(at(Size - 1)));
+            for (int i = Size - 2; i > index; --i)
+                at(i) = std::move(at(i - 1));
+        }
+        at(index) = std::move(e);
+    }
+
+	/**
+	 * Removes the element at the specified position in this deque.
+	 * The index is zero-based, with range [0, size). The elements before or
+	 * after index, whichever are fewer, move one slot.
+	 * @throw IndexOutOfBound
+	 */
+	void removeIndex(int index) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        if (index < Size - 1 - index) {
+            for (int i = index; i > 0; --i)
+                at(i) = std::move(at(i - 1));
+            popFront();
+        } else {
+            for (int i = index; i < Size - 1; ++i)
+                at(i) = std::move(at(i + 1));
+            popBack();
+        }
     }
 
 	/**
@@ -235,11 +475,11 @@ public:
 	 * The index is zero-based, with range [0, size).
 	 * @throw IndexOutOfBound
 	 */
-	const T& get(int index) const { 
+	const T& get(int index) const {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
-        return data[head + index];
+        return at(index);
     }
-	
+
 	/**
 	 * TODO Replaces the element at the specified position in this deque with the specified element.
 	 * The index is zero-based, with range [0, size).
@@ -247,29 +487,36 @@ public:
 	 */
 	void set(int index, const T& e) {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
-        data[head + index] = e;
+        at(index) = e;
+    }
+
+	void set(int index, T&& e) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        at(index) = std::move(e);
     }
 
 	/**
 	 * TODO Returns the number of elements in this deque.
 	 */
-	 int size() const { 
+	 int size() const {
         return Size;
      }
 
 	 /**
 	  * TODO Returns an iterator over the elements in this deque in proper sequence.
 	  */
-	 Iterator iterator() { 
+	 Iterator iterator() {
         return Iterator(this, 0);
      }
 
 	 /**
 	  * TODO Returns an iterator over the elements in this deque in reverse sequential order.
 	  */
-	 Iterator descendingIterator() { 
+	 Iterator descendingIterator() {
         return Iterator(this, 1);
      }
 };
 
+#include "DequeBlocks.h"
+
 #endif
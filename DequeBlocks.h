@@ -0,0 +1,565 @@
+/** @file */
+#ifndef __DEQUE_BLOCKS_H
+#define __DEQUE_BLOCKS_H
+
+#include "Deque.h"
+
+/**
+ * Deque with the BlockMap policy: the elements live in blocks of Block slots each,
+ * and map is a circular array of pointers to the blocks in use.
+ *
+ * The i-th element is in slot (off + i) % Block of the ((off + i) / Block)-th block,
+ * where off is the slot of the first element in the first block. addFirst() and
+ * addLast() take a new block when the end block is full, and the map doubles when
+ * it runs out of pointers, which copies pointers only. So no element ever moves
+ * while the deque grows at either end, and references to the elements stay valid
+ * until those elements are removed.
+ *
+ * One emptied block is kept as a spare, so a queue which keeps crossing a block
+ * boundary does not allocate each time.
+ */
+template <class T>
+class Deque<T, BlockMap>
+{
+    static const int Block = sizeof(T) <= 8 ? 512 : sizeof(T) <= 64 ? 64 : 16;
+    static const int Min_map = 8;
+
+    /*
+     * @var map_size the length of map, 0 or a power of two; map_mask = map_size - 1
+     * @var map_head the place in map of the first block
+     * @var blocks the number of blocks in use
+     * @var off the slot of the first element in the first block
+     */
+    T **map;
+    int map_size, map_mask, map_head;
+    int blocks, off;
+    int Size;
+    T *spare;
+
+    inline T *block(int k) const {
+        return map[(map_head + k) & map_mask];
+    }
+
+    inline T &at(int i) const {
+        unsigned int p = off + i;
+        return block(p / Block)[p % Block];
+    }
+
+    T *newBlock() {
+        T *b = spare;
+        if (b != NULL) spare = NULL;
+        else {
+            b = (T *) std::malloc(Block * sizeof(T));
+            if (b == NULL) throw std::bad_alloc();
+        }
+        return b;
+    }
+
+    void dropBlock(T *b) {
+        if (spare == NULL) spare = b;
+        else std::free(b);
+    }
+
+    /*
+     * Move the block pointers to the front of a new map of length n >= blocks
+     */
+    void resizeMap(int n) {
+        T **new_map = NULL;
+        if (n > 0) {
+            new_map = (T **) std::malloc(n * sizeof(T *));
+            if (new_map == NULL) throw std::bad_alloc();
+        }
+        for (int k = 0; k < blocks; ++k)
+            new_map[k] = block(k);
+        std::free(map);
+        map = new_map;
+        map_size = n;
+        map_mask = n - 1;
+        map_head = 0;
+    }
+
+    /*
+     * The smallest power of two which holds n block pointers
+     */
+    static int mapFor(int n) {
+        int c = Min_map;
+        while (c < n) c *= 2;
+        return c;
+    }
+
+    void destroyAll() {
+        if (!std::is_trivially_destructible<T>::value)
+            for (int i = 0; i < Size; ++i)
+                at(i).~T();
+    }
+
+    /*
+     * Give back the blocks of an empty deque
+     */
+    void dropAll() {
+        for (int k = 0; k < blocks; ++k)
+            dropBlock(block(k));
+        blocks = off = map_head = Size = 0;
+    }
+
+    /*
+     * Remove the first or the last element, giving back its block if it empties
+     */
+    void popFront() {
+        at(0).~T();
+        ++off, --Size;
+        if (Size == 0) dropAll();
+        else if (off == Block) {
+            dropBlock(block(0));
+            map_head = (map_head + 1) & map_mask;
+            --blocks;
+            off = 0;
+        }
+    }
+
+    void popBack() {
+        at(Size - 1).~T();
+        --Size;
+        if (Size == 0) dropAll();
+        else if (off + Size == (blocks - 1) * Block) {
+            dropBlock(block(blocks - 1));
+            --blocks;
+        }
+    }
+
+    void init() {
+        map = NULL;
+        map_size = map_head = 0;
+        map_mask = -1;
+        blocks = off = Size = 0;
+        spare = NULL;
+    }
+
+    /*
+     * Call f(p, n, base) for each block's run of n elements at p, base being the
+     * index of p[0]; stop when f returns true
+     */
+    template <class F>
+    void forEachRun(F &f) const {
+        for (int k = 0, base = 0; base < Size; ++k) {
+            int from = k == 0 ? off : 0;
+            int n = Block - from < Size - base ? Block - from : Size - base;
+            if (f(block(k) + from, n, base)) return;
+            base += n;
+        }
+    }
+
+    struct FindFirst {
+        const T *e;
+        int found;
+        bool operator()(const T *p, int n, int base) {
+            int i = Search<T>::indexOf(p, n, *e);
+            if (i >= 0) found = base + i;
+            return i >= 0;
+        }
+    };
+
+    struct FindLast {
+        const T *e;
+        int found;
+        bool operator()(const T *p, int n, int base) {
+            int i = Search<T>::lastIndexOf(p, n, *e);
+            if (i >= 0) found = base + i;
+            return false;
+        }
+    };
+
+    struct Count {
+        const T *e;
+        int found;
+        bool operator()(const T *p, int n, int) {
+            found += Search<T>::count(p, n, *e);
+            return false;
+        }
+    };
+
+public:
+    class Iterator
+    {
+        int index;
+        int direction;
+        Deque *container;
+        bool dead;
+    public:
+
+        Iterator() {}
+        Iterator(Deque *con, int x): index(x == 0 ? -1 : con->Size), direction(x), container(con), dead(false) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            if (direction == 0) return index + 1 < container->Size;
+            else return index - 1 >= 0;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if (!hasNext()) throw ElementNotExist();
+            if (dead) dead = false;
+            if (direction == 0) return container->at(++index);
+            return container->at(--index);
+        }
+
+        /**
+         * Removes from the underlying collection the last element
+         * returned by the iterator.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (index < 0 || container->Size <= index || dead) throw ElementNotExist();
+            dead = true;
+            if (direction == 0) container->removeIndex(index--);
+            else container->removeIndex(index);
+        }
+    };
+
+    /**
+     * Constructs an empty deque.
+     * No memory is taken before the first element is added.
+     */
+    Deque() {
+        init();
+    }
+
+    /**
+     * Destructor
+     */
+    ~Deque() {
+        clear();
+        std::free(spare);
+        std::free(map);
+    }
+
+    /**
+     * Assignment operator
+     */
+    Deque& operator=(const Deque& x) {
+        if (this != &x) {
+            clear();
+            for (int i = 0; i < x.Size; ++i)
+                addLast(x.at(i));
+        }
+        return (*this);
+    }
+
+    /**
+     * Copy-constructor
+     */
+    Deque(const Deque& x) {
+        init();
+        for (int i = 0; i < x.Size; ++i)
+            addLast(x.at(i));
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    Deque(Deque&& x) {
+        init();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    Deque& operator=(Deque&& x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this deque and x.
+     */
+    void swap(Deque& x) {
+        std::swap(map, x.map);
+        std::swap(map_size, x.map_size);
+        std::swap(map_mask, x.map_mask);
+        std::swap(map_head, x.map_head);
+        std::swap(blocks, x.blocks);
+        std::swap(off, x.off);
+        std::swap(Size, x.Size);
+        std::swap(spare, x.spare);
+    }
+
+    /**
+     * Gives back the spare block and the unused part of the map.
+     */
+    void shrinkToFit() {
+        std::free(spare);
+        spare = NULL;
+        int n = blocks == 0 ? 0 : mapFor(blocks);
+        if (n < map_size) resizeMap(n);
+    }
+
+    /**
+     * Returns the number of slots in the blocks in use.
+     */
+    int capacity() const {
+        return blocks * Block;
+    }
+
+    /**
+     * Inserts the specified element at the front of this deque.
+     */
+    void addFirst(const T& e) {
+        emplaceFirst(e);
+    }
+
+    void addFirst(T&& e) {
+        emplaceFirst(std::move(e));
+    }
+
+    /**
+     * Inserts an element made from args at the front of this deque, built in place.
+     */
+    template <class... Args>
+    void emplaceFirst(Args&&... args) {
+        if (off > 0) {
+            new (block(0) + off - 1) T(std::forward<Args>(args)...);
+            --off;
+        } else {
+            if (blocks == map_size) resizeMap(mapFor(blocks + 1));
+            T *b = newBlock();
+            try {
+                new (b + Block - 1) T(std::forward<Args>(args)...);
+            } catch (...) {
+                dropBlock(b);
+                throw;
+            }
+            map_head = (map_head - 1) & map_mask;
+            map[map_head] = b;
+            ++blocks;
+            off = Block - 1;
+        }
+        ++Size;
+    }
+
+    /**
+     * Inserts the specified element at the end of this deque.
+     */
+    void addLast(const T& e) {
+        emplaceLast(e);
+    }
+
+    void addLast(T&& e) {
+        emplaceLast(std::move(e));
+    }
+
+    /**
+     * Inserts an element made from args at the end of this deque, built in place.
+     */
+    template <class... Args>
+    void emplaceLast(Args&&... args) {
+        int p = off + Size;
+        if (p < blocks * Block) new (block(p / Block) + p % Block) T(std::forward<Args>(args)...);
+        else {
+            if (blocks == map_size) resizeMap(mapFor(blocks + 1));
+            T *b = newBlock();
+            try {
+                new (b) T(std::forward<Args>(args)...);
+            } catch (...) {
+                dropBlock(b);
+                throw;
+            }
+            map[(map_head + blocks) & map_mask] = b;
+            ++blocks;
+        }
+        ++Size;
+    }
+
+    /**
+     * Returns true if this deque contains the specified element.
+     */
+    bool contains(const T& e) const {
+        return indexOf(e) >= 0;
+    }
+
+    /**
+     * Returns the index of the first occurrence of the specified element, or -1.
+     */
+    int indexOf(const T& e) const {
+        FindFirst f = {&e, -1};
+        forEachRun(f);
+        return f.found;
+    }
+
+    /**
+     * Returns the index of the last occurrence of the specified element, or -1.
+     */
+    int lastIndexOf(const T& e) const {
+        FindLast f = {&e, -1};
+        forEachRun(f);
+        return f.found;
+    }
+
+    /**
+     * Returns the number of occurrences of the specified element in this deque.
+     */
+    int count(const T& e) const {
+        Count f = {&e, 0};
+        forEachRun(f);
+        return f.found;
+    }
+
+    /**
+     * Removes all of the elements from this deque.
+     * One block is kept as the spare.
+     */
+    void clear() {
+        destroyAll();
+        dropAll();
+    }
+
+    /**
+     * Returns true if this deque contains no elements.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Retrieves, but does not remove, the first element of this deque.
+     * @throw ElementNotExist
+     */
+    const T& getFirst() {
+        if (Size == 0) throw ElementNotExist();
+        return at(0);
+    }
+
+    /**
+     * Retrieves, but does not remove, the last element of this deque.
+     * @throw ElementNotExist
+     */
+    const T& getLast() {
+        if (Size == 0) throw ElementNotExist();
+        return at(Size - 1);
+    }
+
+    /**
+     * Removes the first element of this deque.
+     * @throw ElementNotExist
+     */
+    void removeFirst() {
+        if (Size == 0) throw ElementNotExist();
+        popFront();
+    }
+
+    /**
+     * Removes the last element of this deque.
+     * @throw ElementNotExist
+     */
+    void removeLast() {
+        if (Size == 0) throw ElementNotExist();
+        popBack();
+    }
+
+    /**
+     * Inserts the specified element at the specified position in this deque,
+     * moving the elements on the shorter side of index (see Deque).
+     * @throw IndexOutOfBound
+     */
+    void add(int index, const T& e) {
+        T x(e);
+        add(index, std::move(x));
+    }
+
+    void add(int index, T&& e) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        if (index < Size - index) {
+            if (index == 0) {
+                emplaceFirst(std::move(e));
+                return;
+            }
+            emplaceFirst(std::move(at(0)));
+            for (int i = 1; i < index; ++i)
+                at(i) = std::move(at(i + 1));
+        } else {
+            if (index == Size) {
+                emplaceLast(std::move(e));
+                return;
+            }
+            emplaceLast(std::move(at(Size - 1)));
+            for (int i = Size - 2; i > index; --i)
+                at(i) = std::move(at(i - 1));
+        }
+        at(index) = std::move(e);
+    }
+
+    /**
+     * Removes the element at the specified position in this deque, moving the
+     * elements on the shorter side of index.
+     * @throw IndexOutOfBound
+     */
+    void removeIndex(int index) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        if (index < Size - 1 - index) {
+            for (int i = index; i > 0; --i)
+                at(i) = std::move(at(i - 1));
+            popFront();
+        } else {
+            for (int i = index; i < Size - 1; ++i)
+                at(i) = std::move(at(i + 1));
+            popBack();
+        }
+    }
+
+    /**
+     * Returns a const reference to the element at the specified position in this deque.
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        return at(index);
+    }
+
+    /**
+     * Replaces the element at the specified position in this deque with the specified element.
+     * @throw IndexOutOfBound
+     */
+    void set(int index, const T& e) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        at(index) = e;
+    }
+
+    void set(int index, T&& e) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        at(index) = std::move(e);
+    }
+
+    /**
+     * Returns the number of elements in this deque.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns an iterator over the elements in this deque in proper sequence.
+     */
+    Iterator iterator() {
+        return Iterator(this, 0);
+    }
+
+    /**
+     * Returns an iterator over the elements in this deque in reverse sequential order.
+     */
+    Iterator descendingIterator() {
+        return Iterator(this, 1);
+    }
+};
+
+#endif
@@ -0,0 +1,17 @@
+/** @file ElementExist.h
+ * Thrown when an element is added where it already is
+ * For example, adding an object to an IntrusiveList while its hook is linked
+ */
+#include <string>
+
+#ifndef __ELEMENTEXIST_H
+#define __ELEMENTEXIST_H
+
+class ElementExist {
+public: ElementExist() {}
+    ElementExist(std::string msg) : msg(msg) {}
+    std::string getMessage() const { return msg; }
+private:
+    std::string msg;
+};
+#endif
\ No newline at end of file
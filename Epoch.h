@@ -0,0 +1,232 @@
+/** @file */
+#ifndef __EPOCH_H
+#define __EPOCH_H
+
+#include "ArrayList.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+/**
+ * Epoch-based reclamation, for containers whose readers take no lock.
+ *
+ * A reader holds an Epoch::Guard while it follows pointers which a writer may
+ * unlink at the same time. A writer which unlinks a node gives it to
+ * Epoch::retire() instead of deleting it, and the node is deleted once every
+ * guard which might still see it has been released:
+ * @code
+ *      {
+ *          Epoch::Guard g;
+ *          for (Node *n = head.load(); n != NULL; n = n->next.load()) ...
+ *      }
+ *      ...
+ *      prev->next.store(n->next.load());
+ *      Epoch::retire(n);
+ * @endcode
+ *
+ * There is one epoch for the whole process. Each thread which uses it takes one
+ * of Max_threads slots until it exits. While all of them are taken, another
+ * thread cannot hold a guard: Guard() throws std::runtime_error. It may still
+ * retire(); what it retires goes to the list of exited threads (see orphans).
+ */
+class Epoch {
+public:
+    static const int Max_threads = 1024;
+
+    /**
+     * While a Guard lives, nothing retired by other threads after its creation
+     * is deleted. Guards may be nested.
+     * @throw std::runtime_error if the thread has no slot and none is free
+     */
+    class Guard {
+        Guard(const Guard &);
+        Guard &operator=(const Guard &);
+    public:
+        Guard() { enter(); }
+        ~Guard() { leave(); }
+    };
+
+    /**
+     * Delete p (with delete) when no guard can see it any more.
+     */
+    template <class T>
+    static void retire(T *p) {
+        retire(p, &deleteObject<T>);
+    }
+
+    /**
+     * Call del(p) when no guard can see p any more.
+     */
+    static void retire(void *p, void (*del)(void *)) {
+        Slot *s = findSlot();
+        Retired r;
+        r.p = p;
+        r.del = del;
+        r.epoch = domain().global.load();
+        if (s == NULL) {
+            Domain &d = domain();
+            std::lock_guard<std::mutex> l(d.orphan_lock);
+            d.orphans.add(r);
+            return;
+        }
+        s->retired.add(r);
+        if (s->retired.size() >= Collect_every) collect(s->retired);
+    }
+
+private:
+    static const int Collect_every = 64;
+
+    struct Retired {
+        void *p;
+        void (*del)(void *);
+        unsigned long epoch;
+    };
+
+    /*
+     * @var local 0 if the thread holds no guard, otherwise the epoch it entered
+     * @var depth the number of guards the thread holds (only used by its owner)
+     * Each slot has its own cache line, so the threads do not share one.
+     */
+    struct alignas(64) Slot {
+        std::atomic<unsigned long> local;
+        std::atomic<bool> used;
+        int depth;
+        ArrayList<Retired> retired;
+    };
+
+    /*
+     * @var orphans what exited threads, or threads without a slot, retired but
+     *  could not delete yet
+     */
+    struct Domain {
+        std::atomic<unsigned long> global;
+        Slot slot[Max_threads];
+        std::mutex orphan_lock;
+        ArrayList<Retired> orphans;
+
+        Domain() {
+            global.store(1);
+            for (int i = 0; i < Max_threads; ++i) {
+                slot[i].local.store(0);
+                slot[i].used.store(false);
+                slot[i].depth = 0;
+            }
+        }
+
+        /*
+         * At exit no thread can hold a guard any more
+         */
+        ~Domain() {
+            for (int i = 0; i < orphans.size(); ++i)
+                orphans.get(i).del(orphans.get(i).p);
+        }
+    };
+
+    /*
+     * Registration gives the slot back when its thread exits.
+     */
+    struct Registration {
+        int index;
+        Registration(): index(-1) {}
+        ~Registration() {
+            if (index < 0) return;
+            Domain &d = domain();
+            Slot &s = d.slot[index];
+            collect(s.retired);
+            {
+                std::lock_guard<std::mutex> l(d.orphan_lock);
+                for (int i = 0; i < s.retired.size(); ++i)
+                    d.orphans.add(s.retired.get(i));
+            }
+            s.retired.clear();
+            s.used.store(false);
+        }
+    };
+
+    template <class T>
+    static void deleteObject(void *p) {
+        delete (T *) p;
+    }
+
+    static Domain &domain() {
+        static Domain d;
+        return d;
+    }
+
+    /*
+     * The slot of this thread, taking a free one the first time; NULL if the
+     * thread has none and every slot is taken (it tries again next time)
+     */
+    static Slot *findSlot() {
+        static thread_local Registration r;
+        Domain &d = domain();
+        for (int i = 0; i < Max_threads && r.index < 0; ++i) {
+            bool expect = false;
+            if (d.slot[i].used.compare_exchange_strong(expect, true)) r.index = i;
+        }
+        return r.index < 0 ? NULL : &d.slot[r.index];
+    }
+
+    static Slot &mySlot() {
+        Slot *s = findSlot();
+        if (s == NULL) throw std::runtime_error("Epoch: all Max_threads slots are taken");
+        return *s;
+    }
+
+    static void enter() {
+        Slot &s = mySlot();
+        if (s.depth++ == 0) {
+            s.local.store(domain().global.load());
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    static void leave() {
+        Slot &s = mySlot();
+        if (--s.depth == 0) s.local.store(0, std::memory_order_release);
+    }
+
+    /*
+     * The epoch moves on once every thread inside a guard has seen it.
+     */
+    static void tryAdvance() {
+        Domain &d = domain();
+        unsigned long e = d.global.load();
+        for (int i = 0; i < Max_threads; ++i) {
+            unsigned long l = d.slot[i].local.load();
+            if (l != 0 && l != e) return;
+        }
+        d.global.compare_exchange_strong(e, e + 1);
+    }
+
+    /*
+     * Delete what was retired two epochs ago or earlier: every guard which
+     * could see it has been released since.
+     */
+    static void collect(ArrayList<Retired> &list) {
+        tryAdvance();
+        Domain &d = domain();
+        unsigned long e = d.global.load();
+        int n = 0;
+        for (int i = 0; i < list.size(); ++i) {
+            Retired r = list.get(i);
+            if (r.epoch + 2 <= e) r.del(r.p);
+            else list.set(n++, r);
+        }
+        while (list.size() > n) list.removeIndex(list.size() - 1);
+
+        std::unique_lock<std::mutex> l(d.orphan_lock, std::try_to_lock);
+        if (l.owns_lock() && !d.orphans.isEmpty()) {
+            n = 0;
+            for (int i = 0; i < d.orphans.size(); ++i) {
+                Retired r = d.orphans.get(i);
+                if (r.epoch + 2 <= e) r.del(r.p);
+                else d.orphans.set(n++, r);
+            }
+            while (d.orphans.size() > n) d.orphans.removeIndex(d.orphans.size() - 1);
+        }
+    }
+};
+
+#endif
@@ -4,12 +4,27 @@
 #define __HASHMAP_H
 
 #include "ElementNotExist.h"
+#include "SlabAllocator.h"
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
 
 /**
  * HashMap is a map implemented by hashing. Also, the 'capacity' here means the
  * number of buckets in your internal implemention, not the current number of the
  * elements.
  *
+ * The capacity is a power of two, 16 by default, and doubles when the map holds
+ * as many elements as buckets.
+ *
+ * HashMap(c) means the same for every policy P: the map holds at least c
+ * elements before its first growth. The table it takes for that depends on the
+ * policy (more than c buckets for Chaining, which grows at a load factor of 1,
+ * at least c * 8 / 7 slots for the open-addressing tables); capacity() tells
+ * how many. The elements are moved
+ * to the larger table incrementally: each put() and remove() moves a few buckets
+ * (see setRehashBudget), so no single call pays for the whole move.
+ *
  * Template argument H are used to specify the hash function.
  * H should be a class with a static function named ``hashCode'',
  * which takes a parameter of type K and returns a value of type int.
@@ -33,6 +48,11 @@
  * the other direction: if the hash code of two keys are equal, the two keys could be
  * different.
  *
+ * The hash of every key is kept in its Entry, so a growth never calls H again,
+ * and a lookup only compares keys whose whole hashes are equal. If H declares
+ * is_transparent, containsKey(), get() and remove() also take any type which H
+ * can hash and K can be compared with, e.g. a const char * for std::string keys.
+ *
  * Note that the correctness of HashMap should not rely on the choice of hash function.
  * This is to say that, even the given hash function always returns the same hash code
  * for all keys (thus causing a serious collision), methods of HashMap should still
@@ -40,8 +60,41 @@
  *
  * The order of iteration could be arbitary in HashMap. But it should be guaranteed
  * that each (key, value) pair be iterated exactly once.
+ *
+ * Template argument P chooses the internal table. The default, Chaining, keeps a
+ * linked list of Entry in every bucket. RobinHood is an open-addressing table
+ * (see HashMapRobinHood.h) whose capacity is a power of two that grows with the
+ * load factor, so a small map only costs a small table:
+ * @code
+ *      HashMap<int, int, Hashint, RobinHood> hash(16);
+ * @endcode
+ * GroupProbing (see HashMapGroupProbe.h) is also open addressing, but keeps a
+ * byte of hash per slot and matches 16 of them at once with SSE2.
+ *
+ * Template argument A is the allocator of the Entry nodes of Chaining (see
+ * SlabAllocator.h). By default the nodes are cut from slabs owned by the map, so
+ * clear() and the destructor free whole slabs instead of every node; use
+ * NewAllocator to take each node from operator new. The open-addressing
+ * policies have no nodes and ignore A.
+ */
+class Chaining {};
+class RobinHood {};
+class GroupProbing {};
+
+/*
+ * Scramble the hash code, so that the low bits can be used directly as the
+ * index of a table whose size is a power of two.
  */
-template <class K, class V, class H>
+inline unsigned int mix_hash(unsigned int h) {
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+template <class K, class V, class H, class P = Chaining, template <class> class A = SlabAllocator>
 class HashMap {
 public:
     /*
@@ -51,20 +104,22 @@ public:
         public:
         K key;
         V value;
+        unsigned int hash;
         Entry *next;
-        Entry(K k, V v) {
-            key = k;
-            value = v;
-            next = NULL;
-        }
+        Entry(const K &k, const V &v): key(k), value(v), hash(0), next(NULL) {}
 
-        Entry(K k, V v, Entry *n): key(k), value(v), next(n){}
+        /*
+         * key is made from k and value from args, in place
+         */
+        template <class KK, class... Args>
+        Entry(unsigned int h, Entry *n, KK &&k, Args&&... args):
+            key(std::forward<KK>(k)), value(std::forward<Args>(args)...), hash(h), next(n) {}
 
-        K getKey() const {
+        const K &getKey() const {
             return key;
         }
 
-        V getValue() const {
+        const V &getValue() const {
             return value;
         }
 
@@ -74,35 +129,225 @@ public:
     };
     class Iterator;
 //private:
-/*
- * @var Hash_max The size of hash -> the prime  min(abs(x - 888888))
- */
-    static const int Hash_max = 888887;
-    Entry **head;
+    static const int Default_capacity = 16;
+    static const int Default_budget = 1;
+
+    /*
+     * Table is an array of buckets, its size is a power of two.
+     * @var used the number of entries in this table
+     */
+    struct Table {
+        Entry **head;
+        int save_size, used;
+        unsigned int mask;
+    };
+
+    /*
+     * The entries are in ht[0]. When ht[0] is full, the entries move to the twice
+     * larger ht[1] a few buckets at a time (see rehashStep), and new entries go
+     * to ht[1]. When ht[0] is empty, ht[1] becomes ht[0].
+     * @var rehash_idx the next bucket of ht[0] to move, -1 if there is only ht[0]
+     * @var rehash_budget the number of buckets moved by each put() and remove()
+     */
+    Table ht[2];
+    int rehash_idx, rehash_budget;
     int Size;
 
     H func;
+    A<Entry> alloc;
+
+    template <class Q>
+    inline unsigned int get_hash(const Q &key) const {
+        return mix_hash((unsigned int) func.hashCode(key));
+    }
+
+    template <class KK, class... Args>
+    Entry *newEntry(unsigned int h, Entry *next, KK &&key, Args&&... args) {
+        return new (alloc.allocate()) Entry(h, next, std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    void deleteEntry(Entry *k) {
+        k->~Entry();
+        alloc.deallocate(k);
+    }
+
     /*
-     * use Hash_max to Hash it again.
+     * calloc takes a large table from fresh zeroed pages, so a growth does not
+     * stall to clear the whole new table.
      */
-    inline unsigned int get_hash(const K &key) const {
-        return (unsigned int) func.hashCode(key) % Hash_max;
+    void makeTable(Table &t, int c) {
+        t.save_size = c;
+        t.mask = c - 1;
+        t.used = 0;
+        t.head = (Entry **) calloc(c, sizeof(Entry *));
+    }
+
+    bool isRehashing() const {
+        return rehash_idx >= 0;
     }
 
     /*
-     * Clear the hash table
+     * Move n non-empty buckets of ht[0] into ht[1], visiting at most 10 * n
+     * empty buckets on the way. n <= 0 moves all of them. The limit is a long
+     * long, since 10 * n overflows an int for a table of 2^28 buckets or a
+     * budget that large.
      */
-    void removeAll() {
-        for (int i = 0; i < Hash_max; ++i)
-            for (Entry *x, *k = head[i]; k != NULL; k = x) {
+    void rehashStep(int n) {
+        if (!isRehashing()) return;
+        if (n <= 0) n = ht[0].save_size;
+        long long empty_visits = (long long) n * 10;
+        while (n-- > 0 && ht[0].used != 0) {
+            while (ht[0].head[rehash_idx] == NULL) {
+                ++rehash_idx;
+                if (--empty_visits == 0) return;
+            }
+            for (Entry *x, *k = ht[0].head[rehash_idx]; k != NULL; k = x) {
                 x = k->next;
-                delete k;
+                unsigned int t = k->hash & ht[1].mask;
+                k->next = ht[1].head[t];
+                ht[1].head[t] = k;
+                --ht[0].used;
+                ++ht[1].used;
             }
+            ht[0].head[rehash_idx++] = NULL;
+        }
+        if (ht[0].used == 0) {
+            free(ht[0].head);
+            ht[0] = ht[1];
+            ht[1].head = NULL;
+            rehash_idx = -1;
+        }
+    }
+
+    /*
+     * Start to move into a twice larger table when the load factor reaches 1.
+     * A budget of 0 or less moves everything at once.
+     */
+    void expandIfNeeded() {
+        if (isRehashing() || Size < ht[0].save_size) return;
+        makeTable(ht[1], ht[0].save_size * 2);
+        rehash_idx = 0;
+        if (rehash_budget <= 0) rehashStep(0);
+    }
+
+    /*
+     * Return the entry of key, or NULL if key is not in the map
+     * The keys are only compared when the whole hashes are equal.
+     */
+    template <class Q>
+    Entry *findEntry(const Q &key) const {
+        unsigned int h = get_hash(key);
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); ++t)
+            for (Entry *k = ht[t].head[h & ht[t].mask]; k != NULL; k = k->next)
+                if (k->hash == h && k->key == key) return k;
+        return NULL;
     }
 
-    void clear_head() {
-        for (int i = 0; i < Hash_max; ++i)
-            head[i] = NULL;
+    /*
+     * Put a value made from args; a present value is assigned, an absent one
+     * is built in place.
+     */
+    template <class KK, class... Args>
+    void putValue(KK &&key, Args&&... args) {
+        rehashStep(rehash_budget);
+        unsigned int h = get_hash(key);
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); ++t)
+            for (Entry *k = ht[t].head[h & ht[t].mask]; k != NULL; k = k->next)
+                if (k->hash == h && k->key == key) {
+                    assignValue(k->value, std::forward<Args>(args)...);
+                    return;
+                }
+        ++Size;
+        expandIfNeeded();
+        Table &w = ht[isRehashing() ? 1 : 0];
+        unsigned int t = h & w.mask;
+        w.head[t] = newEntry(h, w.head[t], std::forward<KK>(key), std::forward<Args>(args)...);
+        ++w.used;
+    }
+
+    /*
+     * A V is assigned as it is; anything else, as in putEmplace(key, args),
+     * makes a V to assign, so args need not be assignable to V
+     */
+    template <class U>
+    static typename std::enable_if<std::is_same<typename std::decay<U>::type, V>::value>::type
+    assignValue(V &v, U &&u) {
+        v = std::forward<U>(u);
+    }
+
+    template <class... Args>
+    static void assignValue(V &v, Args&&... args) {
+        v = V(std::forward<Args>(args)...);
+    }
+
+    template <class Q>
+    void removeKey(const Q &key) {
+        rehashStep(rehash_budget);
+        unsigned int h = get_hash(key);
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); ++t)
+            for (Entry **p = &ht[t].head[h & ht[t].mask]; *p != NULL; p = &(*p)->next)
+                if ((*p)->hash == h && (*p)->key == key) {
+                    Entry *q = (*p)->next;
+                    deleteEntry(*p);
+                    *p = q;
+                    --ht[t].used;
+                    --Size;
+                    return;
+                }
+        throw ElementNotExist();
+    }
+
+    /*
+     * Clear the hash table
+     * The nodes are only visited when they need a destructor or the allocator
+     * cannot free them all at once.
+     */
+    void removeAll() {
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); ++t) {
+            if (!A<Entry>::Releases_all || !std::is_trivially_destructible<Entry>::value)
+                for (int i = 0; i < ht[t].save_size; ++i)
+                    for (Entry *x, *k = ht[t].head[i]; k != NULL; k = x) {
+                        x = k->next;
+                        deleteEntry(k);
+                    }
+            free(ht[t].head);
+        }
+        alloc.releaseAll();
+        rehash_idx = -1;
+        Size = 0;
+    }
+
+    /*
+     * Make this map a copy of x, with every entry in ht[0]
+     */
+    void copy(const HashMap &x) {
+        func = x.func;
+        rehash_budget = x.rehash_budget;
+        rehash_idx = -1;
+        makeTable(ht[0], x.ht[x.isRehashing() ? 1 : 0].save_size);
+        ht[1].head = NULL;
+        ht[1].save_size = ht[1].used = 0;
+        ht[1].mask = 0;
+        for (int t = 0; t <= (x.isRehashing() ? 1 : 0); ++t)
+            for (int i = 0; i < x.ht[t].save_size; ++i)
+                for (Entry *k = x.ht[t].head[i]; k != NULL; k = k->next) {
+                    unsigned int j = k->hash & ht[0].mask;
+                    ht[0].head[j] = newEntry(k->hash, ht[0].head[j], k->key, k->value);
+                }
+        Size = ht[0].used = x.Size;
+    }
+
+    void init(int c) {
+        int n = 1;
+        while (n < c) n *= 2;
+        makeTable(ht[0], n);
+        ht[1].head = NULL;
+        ht[1].save_size = ht[1].used = 0;
+        ht[1].mask = 0;
+        rehash_idx = -1;
+        rehash_budget = Default_budget;
+        Size = 0;
+        func = H();
     }
 
 public:
@@ -111,10 +356,17 @@ public:
      * TODO Constructs an empty hash map.
      */
     HashMap() { 
-        Size = 0;
-        head = new Entry*[Hash_max];
-        clear_head();
-        func = H();
+        init(Default_capacity);
+    }
+
+    /**
+     * Constructs an empty hash map which holds at least c elements
+     * before its first growth, as with the other policies.
+     */
+    explicit HashMap(int c) {
+        int n = 1;
+        while (n <= c) n *= 2;
+        init(n);
     }
 
     /**
@@ -122,7 +374,6 @@ public:
      */
     ~HashMap() { 
         removeAll();
-        delete[] head;
     }
 
     /**
@@ -131,14 +382,7 @@ public:
     HashMap &operator=(const HashMap &x) { 
         if (this != &x) {
             removeAll();
-            clear_head();
-            Size = x.Size;
-            func = x.func;
-            for (int i = 0; i < Hash_max; ++i)
-                for (Entry *k = x.head[i]; k != NULL; k = k->next) {
-                    Entry *tmp = new Entry(k->getKey(), k->getValue(), head[i]);
-                    head[i] = tmp;
-                }
+            copy(x);
         }
         return *this;
     }
@@ -147,15 +391,58 @@ public:
      * TODO Copy-constructor
      */
     HashMap(const HashMap &x) { 
-        head = new Entry*[Hash_max];
-        clear_head();
-        Size = x.Size;
-        func = x.func;
-        for (int i = 0; i < Hash_max; ++i)
-                for (Entry *k = x.head[i]; k != NULL; k = k->next) {
-                    Entry *tmp = new Entry(k->getKey(), k->getValue(), head[i]);
-                    head[i] = tmp;
-                }
+        copy(x);
+    }
+
+    /**
+     * Move-constructor
+     * The entries of x are taken over; x is left empty.
+     */
+    HashMap(HashMap &&x) {
+        init(Default_capacity);
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    HashMap &operator=(HashMap &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the mappings of this map and x.
+     */
+    void swap(HashMap &x) {
+        std::swap(ht[0], x.ht[0]);
+        std::swap(ht[1], x.ht[1]);
+        std::swap(rehash_idx, x.rehash_idx);
+        std::swap(rehash_budget, x.rehash_budget);
+        std::swap(Size, x.Size);
+        std::swap(func, x.func);
+        alloc.swap(x.alloc);
+    }
+
+    /**
+     * Sets the number of buckets moved by each put() and remove() while the
+     * map grows. A budget of 0 or less makes the map grow at once, and
+     * finishes any growth in progress.
+     */
+    void setRehashBudget(int n) {
+        rehash_budget = n;
+        if (n <= 0) rehashStep(0);
+    }
+
+    /**
+     * Returns the number of buckets, counting the table being grown into.
+     */
+    int capacity() const {
+        return ht[isRehashing() ? 1 : 0].save_size;
     }
 
     /**
@@ -169,28 +456,26 @@ public:
      * TODO Removes all of the mappings from this map.
      */
     void clear() {
+        int c = ht[0].save_size;
         removeAll();
-        clear_head();
-        Size = 0;
+        makeTable(ht[0], c);
     }
 
     /**
      * TODO Returns true if this map contains a mapping for the specified key.
      */
     bool containsKey(const K &key) const {
-        int t = get_hash(key);
-        for (Entry *k = head[t]; k != NULL; k = k->next)
-            if (k->key == key) return true;
-        return false;
+        return findEntry(key) != NULL;
     }
 
     /**
      * TODO Returns true if this map maps one or more keys to the specified value.
      */
     bool containsValue(const V &value) const {
-        for (int i = 0; i < Hash_max; ++i)
-            for (Entry *k = head[i]; k != NULL; k = k->next)
-                if (k->value == value) return true;
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); ++t)
+            for (int i = 0; i < ht[t].save_size; ++i)
+                for (Entry *k = ht[t].head[i]; k != NULL; k = k->next)
+                    if (k->value == value) return true;
         return false;
     }
 
@@ -200,10 +485,9 @@ public:
      * @throw ElementNotExist
      */
     const V &get(const K &key) const {
-        int t = get_hash(key);
-        for (Entry *k = head[t]; k != NULL; k = k->next)
-            if (k->key == key) return k->value;
-        throw ElementNotExist();
+        Entry *k = findEntry(key);
+        if (k == NULL) throw ElementNotExist();
+        return k->value;
     }
 
     /**
@@ -217,15 +501,29 @@ public:
      * TODO Associates the specified value with the specified key in this map.
      */
     void put(const K &key, const V &value) {
-        int t = get_hash(key);
-        for (Entry *k = head[t]; k != NULL; k = k->next)
-            if (k ->getKey() == key) {
-                k->changeValue(value);
-                return;
-            }
-        Entry *tmp = new Entry(key, value, head[t]);
-        head[t] = tmp;
-        ++Size;
+        putValue(key, value);
+    }
+
+    void put(const K &key, V &&value) {
+        putValue(key, std::move(value));
+    }
+
+    void put(K &&key, V &&value) {
+        putValue(std::move(key), std::move(value));
+    }
+
+    /**
+     * Associates a value made from args with the specified key. If the key is
+     * not present, the value is built in place in the new entry.
+     */
+    template <class... Args>
+    void putEmplace(const K &key, Args&&... args) {
+        putValue(key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    void putEmplace(K &&key, Args&&... args) {
+        putValue(std::move(key), std::forward<Args>(args)...);
     }
 
     /**
@@ -234,23 +532,40 @@ public:
      * @throw ElementNotExist
      */
     void remove(const K &key) {
-        int t = get_hash(key);
-        if (head[t] != NULL && head[t]->key == key) {
-            --Size;
-            Entry *q = head[t]->next;
-            delete head[t];
-            head[t] = q;
-            return;   
-        }
-        for (Entry *k = head[t]; k->next != NULL; k = k->next)
-            if (k->next->key == key) {
-                --Size;
-                Entry *q = k->next->next;
-                delete k->next;
-                k->next = q;
-                return;
-            }
-        throw ElementNotExist();
+        removeKey(key);
+    }
+
+    /**
+     * Lookups by any type Q which H can hash and K can be compared with
+     * (key == q), without making a K. They are only there if H declares
+     * is_transparent, for example:
+     * @code
+     *      class HashString {
+     *      public:
+     *          typedef void is_transparent;
+     *          static int hashCode(const std::string &s) { return hashCode(s.c_str()); }
+     *          static int hashCode(const char *s) { ... }
+     *      };
+     *      HashMap<std::string, int, HashString> map;
+     *      map.containsKey("key");
+     * @endcode
+     * H must give equal hash codes to a K and a Q which are equal.
+     */
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    bool containsKey(const Q &key) const {
+        return findEntry(key) != NULL;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    const V &get(const Q &key) const {
+        Entry *k = findEntry(key);
+        if (k == NULL) throw ElementNotExist();
+        return k->value;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    void remove(const Q &key) {
+        removeKey(key);
     }
 
     /**
@@ -261,26 +576,39 @@ public:
     }
 };
 
-template<class K, class V, class H>
-class HashMap<K, V, H>::Iterator{
+/*
+ * The buckets of ht[0] are visited before those of ht[1]; bucket i is
+ * ht[0].head[i] if i < ht[0].save_size, otherwise ht[1].head[i - ht[0].save_size].
+ */
+template<class K, class V, class H, class P, template <class> class A>
+class HashMap<K, V, H, P, A>::Iterator{
     private:
         int now_i;
         Entry *nowEntry;
         const HashMap *container;
 
+        int buckets() const {
+            int n = container->ht[0].save_size;
+            if (container->isRehashing()) n += container->ht[1].save_size;
+            return n;
+        }
+
+        Entry *bucket(int i) const {
+            int n = container->ht[0].save_size;
+            return i < n ? container->ht[0].head[i] : container->ht[1].head[i - n];
+        }
+
         /**
          * return true if the iteration has more elements
          * and the next Iterator is transfer by next_i & nextEntry
          */
         bool try_next(int &next_i, Entry* &nextEntry) {
             next_i = now_i; nextEntry = nowEntry;
-            if (next_i < 0) {
-                next_i = 0;
-                nextEntry = container->head[0];
-            } else nextEntry = nextEntry->next;
+            if (nextEntry != NULL) nextEntry = nextEntry->next;
             if (nextEntry == NULL) {
-                for (++next_i; container->head[next_i] == NULL && next_i < HashMap::Hash_max; ++next_i);
-                if (next_i < HashMap::Hash_max) nextEntry = container->head[next_i];
+                int n = buckets();
+                for (++next_i; next_i < n && bucket(next_i) == NULL; ++next_i);
+                if (next_i < n) nextEntry = bucket(next_i);
             }
             return nextEntry != NULL;
         }
@@ -312,5 +640,7 @@ class HashMap<K, V, H>::Iterator{
         }
     };
 
+#include "HashMapRobinHood.h"
+#include "HashMapGroupProbe.h"
 
 #endif
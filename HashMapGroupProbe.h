@@ -0,0 +1,548 @@
+/** @file */
+#ifndef __HASHMAP_GROUPPROBE_H
+#define __HASHMAP_GROUPPROBE_H
+
+#include "HashMap.h"
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ * Group is a run of Width control bytes. A control byte is Empty, Deleted or,
+ * for a used slot, the low 7 bits of the hash (so it is never negative).
+ * Each match function returns a bitmask, bit i is set if byte i matches.
+ */
+struct Group {
+    static const int Width = 16;
+    static const signed char Empty = -128;
+    static const signed char Deleted = -2;
+
+#ifdef __SSE2__
+    static unsigned int match(const signed char *g, signed char h) {
+        __m128i ctrl = _mm_loadu_si128((const __m128i *) g);
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h)));
+    }
+
+    static unsigned int matchEmpty(const signed char *g) {
+        return match(g, Empty);
+    }
+
+    /*
+     * Empty and Deleted are the only negative control bytes
+     */
+    static unsigned int matchFree(const signed char *g) {
+        return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) g));
+    }
+#else
+    static unsigned int match(const signed char *g, signed char h) {
+        unsigned int m = 0;
+        for (int i = 0; i < Width; ++i)
+            if (g[i] == h) m |= 1u << i;
+        return m;
+    }
+
+    static unsigned int matchEmpty(const signed char *g) {
+        return match(g, Empty);
+    }
+
+    static unsigned int matchFree(const signed char *g) {
+        unsigned int m = 0;
+        for (int i = 0; i < Width; ++i)
+            if (g[i] < 0) m |= 1u << i;
+        return m;
+    }
+#endif
+
+    /*
+     * The index of the lowest set bit of a non-zero mask
+     */
+    static int lowest(unsigned int m) {
+#ifdef __GNUC__
+        return __builtin_ctz(m);
+#else
+        int i = 0;
+        while (!(m & 1)) m >>= 1, ++i;
+        return i;
+#endif
+    }
+};
+
+/**
+ * HashMap with the GroupProbing policy: an open-addressing table in the style of
+ * SwissTable.
+ *
+ * The slots are split into groups of Group::Width. Beside the slots there is one
+ * control byte per slot, holding 7 bits of the hash of its key. A lookup compares
+ * the 7 bits with a whole group of control bytes at once (one SSE2 compare, or a
+ * plain loop without SSE2), and only compares keys for the slots which match, so
+ * most misses never touch a key at all. Groups are probed in triangular order
+ * until a group with an empty slot is met.
+ *
+ * Removal leaves a Deleted mark unless the group still has an empty slot. The
+ * table is rebuilt when the used and deleted slots reach 7/8 of the capacity.
+ */
+template <class K, class V, class H, template <class> class A>
+class HashMap<K, V, H, GroupProbing, A> {
+public:
+    /*
+     * Entry is the slot of the table.
+     */
+    class Entry{
+        public:
+        K key;
+        V value;
+        unsigned int hash;
+
+        /*
+         * key is made from k and value from args, in place
+         */
+        template <class KK, class... Args>
+        Entry(unsigned int h, KK &&k, Args&&... args):
+            key(std::forward<KK>(k)), value(std::forward<Args>(args)...), hash(h) {}
+
+        const K &getKey() const {
+            return key;
+        }
+
+        const V &getValue() const {
+            return value;
+        }
+    };
+    class Iterator;
+
+private:
+    static const int Default_capacity = 16;
+    static const int Load_num = 7, Load_den = 8;
+
+    /*
+     * slot is raw storage; slot[i] is only constructed while ctrl[i] >= 0.
+     */
+    Entry *slot;
+    signed char *ctrl;
+    int Size, save_size;
+    /*
+     * @var growth_left the number of empty slots which can still be filled before a rebuild
+     */
+    int growth_left;
+    unsigned int group_mask;
+
+    H func;
+
+    template <class Q>
+    inline unsigned int get_hash(const Q &key) const {
+        return mix_hash((unsigned int) func.hashCode(key));
+    }
+
+    /*
+     * Allocate an empty table of capacity c (a power of two, at least Group::Width)
+     */
+    void makeTable(int c) {
+        save_size = c;
+        group_mask = c / Group::Width - 1;
+        slot = (Entry *) std::malloc((size_t) c * sizeof(Entry));
+        if (slot == NULL) throw std::bad_alloc();
+        ctrl = new signed char[c];
+        resetCtrl();
+    }
+
+    /*
+     * Destroy the elements, leaving every slot empty
+     */
+    void destroyAll() {
+        if (!std::is_trivially_destructible<Entry>::value)
+            for (int i = 0; i < save_size; ++i)
+                if (ctrl[i] >= 0) slot[i].~Entry();
+        resetCtrl();
+    }
+
+    void freeTable() {
+        destroyAll();
+        std::free(slot);
+        delete[] ctrl;
+    }
+
+    void resetCtrl() {
+        for (int i = 0; i < save_size; ++i)
+            ctrl[i] = Group::Empty;
+        growth_left = (long long) save_size * Load_num / Load_den;
+    }
+
+    /*
+     * Return the slot of key, or -1 if key is not in the table
+     */
+    template <class Q>
+    int find(const Q &key) const {
+        return find(key, get_hash(key));
+    }
+
+    template <class Q>
+    int find(const Q &key, unsigned int h) const {
+        signed char h2 = h & 0x7F;
+        unsigned int g = (h >> 7) & group_mask;
+        for (unsigned int step = 1; ; g = (g + step++) & group_mask) {
+            const signed char *c = ctrl + g * Group::Width;
+            for (unsigned int m = Group::match(c, h2); m != 0; m &= m - 1) {
+                int i = g * Group::Width + Group::lowest(m);
+                if (slot[i].hash == h && slot[i].key == key) return i;
+            }
+            if (Group::matchEmpty(c) != 0) return -1;
+        }
+    }
+
+    /*
+     * Return the first free slot on the probe sequence of hash h
+     */
+    int findFree(unsigned int h) const {
+        unsigned int g = (h >> 7) & group_mask;
+        for (unsigned int step = 1; ; g = (g + step++) & group_mask) {
+            unsigned int m = Group::matchFree(ctrl + g * Group::Width);
+            if (m != 0) return g * Group::Width + Group::lowest(m);
+        }
+    }
+
+    /*
+     * Put an element which is known not to be in the table
+     */
+    void insert(Entry &&e) {
+        int i = findFree(e.hash);
+        if (ctrl[i] == Group::Empty) --growth_left;
+        ctrl[i] = e.hash & 0x7F;
+        new (slot + i) Entry(std::move(e));
+    }
+
+    /*
+     * Rebuild the table with capacity c, dropping every Deleted mark
+     */
+    void rehash(int c) {
+        Entry *old_slot = slot;
+        signed char *old_ctrl = ctrl;
+        int old_size = save_size;
+        makeTable(c);
+        for (int i = 0; i < old_size; ++i)
+            if (old_ctrl[i] >= 0) {
+                insert(std::move(old_slot[i]));
+                old_slot[i].~Entry();
+            }
+        std::free(old_slot);
+        delete[] old_ctrl;
+    }
+
+    /*
+     * Remove the element in slot t
+     * @throw ElementNotExist if t < 0
+     */
+    void removeAt(int t) {
+        if (t < 0) throw ElementNotExist();
+        slot[t].~Entry();
+        /*
+         * A probe which reaches a group with an empty slot stops there, so the
+         * slot can become Empty again if its group still has one.
+         */
+        if (Group::matchEmpty(ctrl + t / Group::Width * Group::Width) != 0) {
+            ctrl[t] = Group::Empty;
+            ++growth_left;
+        } else ctrl[t] = Group::Deleted;
+        --Size;
+    }
+
+    /*
+     * Put a value made from args; a present value is assigned, an absent one
+     * is built with its key and moved into a slot.
+     */
+    template <class KK, class... Args>
+    void putValue(KK &&key, Args&&... args) {
+        unsigned int h = get_hash(key);
+        int t = find(key, h);
+        if (t >= 0) {
+            assignValue(slot[t].value, std::forward<Args>(args)...);
+            return;
+        }
+        if (growth_left == 0) {
+            /*
+             * Mostly Deleted marks: rebuild in place, otherwise double
+             */
+            if ((long long) Size * 2 * Load_den <= (long long) save_size * Load_num)
+                rehash(save_size);
+            else rehash(save_size * 2);
+        }
+        insert(Entry(h, std::forward<KK>(key), std::forward<Args>(args)...));
+        ++Size;
+    }
+
+    /*
+     * A V is assigned as it is; anything else, as in putEmplace(key, args),
+     * makes a V to assign, so args need not be assignable to V
+     */
+    template <class U>
+    static typename std::enable_if<std::is_same<typename std::decay<U>::type, V>::value>::type
+    assignValue(V &v, U &&u) {
+        v = std::forward<U>(u);
+    }
+
+    template <class... Args>
+    static void assignValue(V &v, Args&&... args) {
+        v = V(std::forward<Args>(args)...);
+    }
+
+    void copy(const HashMap &x) {
+        Size = x.Size;
+        func = x.func;
+        makeTable(x.save_size);
+        growth_left = x.growth_left;
+        for (int i = 0; i < save_size; ++i)
+            if (x.ctrl[i] >= 0) {
+                new (slot + i) Entry(x.slot[i]);
+                ctrl[i] = x.ctrl[i];
+            } else if (x.ctrl[i] == Group::Deleted) ctrl[i] = Group::Deleted;
+    }
+
+public:
+
+    /**
+     * Constructs an empty hash map.
+     */
+    HashMap() {
+        Size = 0;
+        makeTable(Default_capacity);
+        func = H();
+    }
+
+    /**
+     * Constructs an empty hash map which holds at least c elements
+     * before its first growth.
+     */
+    explicit HashMap(int c) {
+        int n = Group::Width;
+        while ((long long) n * Load_num < (long long) c * Load_den) n *= 2;
+        Size = 0;
+        makeTable(n);
+        func = H();
+    }
+
+    /**
+     * Destructor
+     */
+    ~HashMap() {
+        freeTable();
+    }
+
+    /**
+     * Assignment operator
+     */
+    HashMap &operator=(const HashMap &x) {
+        if (this != &x) {
+            freeTable();
+            copy(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Copy-constructor
+     */
+    HashMap(const HashMap &x) {
+        copy(x);
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        Size = 0;
+        destroyAll();
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return find(key) >= 0;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for (int i = 0; i < save_size; ++i)
+            if (ctrl[i] >= 0 && slot[i].value == value) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * If the key is not present in this map, this function should throw ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        int t = find(key);
+        if (t < 0) throw ElementNotExist();
+        return slot[t].value;
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        putValue(key, value);
+    }
+
+    void put(const K &key, V &&value) {
+        putValue(key, std::move(value));
+    }
+
+    void put(K &&key, V &&value) {
+        putValue(std::move(key), std::move(value));
+    }
+
+    /**
+     * Associates a value made from args with the specified key.
+     */
+    template <class... Args>
+    void putEmplace(const K &key, Args&&... args) {
+        putValue(key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    void putEmplace(K &&key, Args&&... args) {
+        putValue(std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    HashMap(HashMap &&x) {
+        Size = 0;
+        makeTable(Default_capacity);
+        func = H();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    HashMap &operator=(HashMap &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the mappings of this map and x.
+     */
+    void swap(HashMap &x) {
+        std::swap(slot, x.slot);
+        std::swap(ctrl, x.ctrl);
+        std::swap(Size, x.Size);
+        std::swap(save_size, x.save_size);
+        std::swap(growth_left, x.growth_left);
+        std::swap(group_mask, x.group_mask);
+        std::swap(func, x.func);
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map if present.
+     * If there is no mapping for the specified key, throws ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        removeAt(find(key));
+    }
+
+    /**
+     * Lookups by any type Q which H can hash and K can be compared with,
+     * only there if H declares is_transparent (see HashMap).
+     */
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    bool containsKey(const Q &key) const {
+        return find(key) >= 0;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    const V &get(const Q &key) const {
+        int t = find(key);
+        if (t < 0) throw ElementNotExist();
+        return slot[t].value;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    void remove(const Q &key) {
+        removeAt(find(key));
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns the number of slots in the table.
+     */
+    int capacity() const {
+        return save_size;
+    }
+};
+
+template<class K, class V, class H, template <class> class A>
+class HashMap<K, V, H, GroupProbing, A>::Iterator{
+    private:
+        int now_i;
+        const HashMap *container;
+
+        /*
+         * Return the first used slot after slot i, or save_size if there is none
+         */
+        int try_next(int i) const {
+            for (++i; i < container->save_size && container->ctrl[i] < 0; ++i);
+            return i;
+        }
+
+    public:
+        Iterator() {}
+        Iterator(const HashMap *c): now_i(-1), container(c) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return try_next(now_i) < container->save_size;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            int next_i = try_next(now_i);
+            if (next_i >= container->save_size) throw ElementNotExist();
+            now_i = next_i;
+            return container->slot[now_i];
+        }
+    };
+
+#endif
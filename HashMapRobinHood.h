@@ -0,0 +1,456 @@
+/** @file */
+#ifndef __HASHMAP_ROBINHOOD_H
+#define __HASHMAP_ROBINHOOD_H
+
+#include "HashMap.h"
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * HashMap with the RobinHood policy: an open-addressing table with linear probing.
+ *
+ * When an element is inserted, it takes the slot of any element which is closer
+ * to its own home bucket ("rob the rich"), so the probe lengths stay short and even.
+ * Removal shifts the following elements one slot backward instead of leaving a
+ * tombstone.
+ *
+ * The capacity is always a power of two. It starts from the capacity given to the
+ * constructor and doubles whenever the load factor would exceed Load_num / Load_den.
+ */
+template <class K, class V, class H, template <class> class A>
+class HashMap<K, V, H, RobinHood, A> {
+public:
+    /*
+     * Entry is the slot of the table.
+     */
+    class Entry{
+        public:
+        K key;
+        V value;
+        unsigned int hash;
+
+        /*
+         * key is made from k and value from args, in place
+         */
+        template <class KK, class... Args>
+        Entry(unsigned int h, KK &&k, Args&&... args):
+            key(std::forward<KK>(k)), value(std::forward<Args>(args)...), hash(h) {}
+
+        const K &getKey() const {
+            return key;
+        }
+
+        const V &getValue() const {
+            return value;
+        }
+    };
+    class Iterator;
+
+private:
+    static const int Default_capacity = 16;
+    static const int Load_num = 7, Load_den = 8;
+
+    /*
+     * slot is raw storage; slot[i] is only constructed while dist[i] != 0.
+     * @var dist dist[i] = 0 if slot i is empty, otherwise
+     *  1 + (the distance from slot i to the home bucket of slot[i])
+     */
+    Entry *slot;
+    int *dist;
+    int Size, save_size;
+    unsigned int mask;
+
+    H func;
+
+    template <class Q>
+    inline unsigned int get_hash(const Q &key) const {
+        return mix_hash((unsigned int) func.hashCode(key));
+    }
+
+    /*
+     * Allocate an empty table of capacity c (a power of two)
+     */
+    void makeTable(int c) {
+        save_size = c;
+        mask = c - 1;
+        slot = (Entry *) std::malloc((size_t) c * sizeof(Entry));
+        if (slot == NULL) throw std::bad_alloc();
+        dist = new int[c];
+        for (int i = 0; i < c; ++i)
+            dist[i] = 0;
+    }
+
+    /*
+     * Destroy the elements, leaving every slot empty
+     */
+    void destroyAll() {
+        for (int i = 0; i < save_size; ++i)
+            if (dist[i] != 0) {
+                if (!std::is_trivially_destructible<Entry>::value) slot[i].~Entry();
+                dist[i] = 0;
+            }
+    }
+
+    void freeTable() {
+        destroyAll();
+        std::free(slot);
+        delete[] dist;
+    }
+
+    /*
+     * Return the slot of key, or -1 if key is not in the table
+     */
+    template <class Q>
+    int find(const Q &key) const {
+        return find(key, get_hash(key));
+    }
+
+    template <class Q>
+    int find(const Q &key, unsigned int h) const {
+        unsigned int i = h & mask;
+        for (int d = 1; dist[i] >= d; ++d, i = (i + 1) & mask)
+            if (slot[i].hash == h && slot[i].key == key) return i;
+        return -1;
+    }
+
+    /*
+     * Remove the element in slot t, shifting the following elements backward
+     * @throw ElementNotExist if t < 0
+     */
+    void removeAt(int t) {
+        if (t < 0) throw ElementNotExist();
+        unsigned int i = t, j = (i + 1) & mask;
+        slot[i].~Entry();
+        for (; dist[j] > 1; i = j, j = (j + 1) & mask) {
+            new (slot + i) Entry(std::move(slot[j]));
+            slot[j].~Entry();
+            dist[i] = dist[j] - 1;
+        }
+        dist[i] = 0;
+        --Size;
+    }
+
+    /*
+     * Put an element which is known not to be in the table
+     */
+    void insert(Entry e) {
+        unsigned int i = e.hash & mask;
+        for (int d = 1; ; ++d, i = (i + 1) & mask) {
+            if (dist[i] == 0) {
+                new (slot + i) Entry(std::move(e));
+                dist[i] = d;
+                return;
+            }
+            if (dist[i] < d) {
+                std::swap(slot[i], e);
+                std::swap(dist[i], d);
+            }
+        }
+    }
+
+    /*
+     * double the capacity and insert every element again
+     */
+    void doubleSpace() {
+        Entry *old_slot = slot;
+        int *old_dist = dist;
+        int old_size = save_size;
+        makeTable(save_size * 2);
+        for (int i = 0; i < old_size; ++i)
+            if (old_dist[i] != 0) {
+                insert(std::move(old_slot[i]));
+                old_slot[i].~Entry();
+            }
+        std::free(old_slot);
+        delete[] old_dist;
+    }
+
+    /*
+     * Put a value made from args; a present value is assigned, an absent one
+     * is built with its key and moved into a slot.
+     */
+    template <class KK, class... Args>
+    void putValue(KK &&key, Args&&... args) {
+        unsigned int h = get_hash(key);
+        int t = find(key, h);
+        if (t >= 0) {
+            assignValue(slot[t].value, std::forward<Args>(args)...);
+            return;
+        }
+        if ((long long) (Size + 1) * Load_den > (long long) save_size * Load_num) doubleSpace();
+        insert(Entry(h, std::forward<KK>(key), std::forward<Args>(args)...));
+        ++Size;
+    }
+
+    /*
+     * A V is assigned as it is; anything else, as in putEmplace(key, args),
+     * makes a V to assign, so args need not be assignable to V
+     */
+    template <class U>
+    static typename std::enable_if<std::is_same<typename std::decay<U>::type, V>::value>::type
+    assignValue(V &v, U &&u) {
+        v = std::forward<U>(u);
+    }
+
+    template <class... Args>
+    static void assignValue(V &v, Args&&... args) {
+        v = V(std::forward<Args>(args)...);
+    }
+
+    void copy(const HashMap &x) {
+        Size = x.Size;
+        func = x.func;
+        makeTable(x.save_size);
+        for (int i = 0; i < save_size; ++i)
+            if (x.dist[i] != 0) {
+                new (slot + i) Entry(x.slot[i]);
+                dist[i] = x.dist[i];
+            }
+    }
+
+public:
+
+    /**
+     * Constructs an empty hash map.
+     */
+    HashMap() {
+        Size = 0;
+        makeTable(Default_capacity);
+        func = H();
+    }
+
+    /**
+     * Constructs an empty hash map which holds at least c elements
+     * before its first growth.
+     */
+    explicit HashMap(int c) {
+        int n = 2;
+        while ((long long) n * Load_num < (long long) c * Load_den) n *= 2;
+        Size = 0;
+        makeTable(n);
+        func = H();
+    }
+
+    /**
+     * Destructor
+     */
+    ~HashMap() {
+        freeTable();
+    }
+
+    /**
+     * Assignment operator
+     */
+    HashMap &operator=(const HashMap &x) {
+        if (this != &x) {
+            freeTable();
+            copy(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Copy-constructor
+     */
+    HashMap(const HashMap &x) {
+        copy(x);
+    }
+
+    /**
+     * Returns an iterator over the elements in this map.
+     */
+    Iterator iterator() const {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the mappings from this map.
+     */
+    void clear() {
+        destroyAll();
+        Size = 0;
+    }
+
+    /**
+     * Returns true if this map contains a mapping for the specified key.
+     */
+    bool containsKey(const K &key) const {
+        return find(key) >= 0;
+    }
+
+    /**
+     * Returns true if this map maps one or more keys to the specified value.
+     */
+    bool containsValue(const V &value) const {
+        for (int i = 0; i < save_size; ++i)
+            if (dist[i] != 0 && slot[i].value == value) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the value to which the specified key is mapped.
+     * If the key is not present in this map, this function should throw ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    const V &get(const K &key) const {
+        int t = find(key);
+        if (t < 0) throw ElementNotExist();
+        return slot[t].value;
+    }
+
+    /**
+     * Returns true if this map contains no key-value mappings.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Associates the specified value with the specified key in this map.
+     */
+    void put(const K &key, const V &value) {
+        putValue(key, value);
+    }
+
+    void put(const K &key, V &&value) {
+        putValue(key, std::move(value));
+    }
+
+    void put(K &&key, V &&value) {
+        putValue(std::move(key), std::move(value));
+    }
+
+    /**
+     * Associates a value made from args with the specified key.
+     */
+    template <class... Args>
+    void putEmplace(const K &key, Args&&... args) {
+        putValue(key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    void putEmplace(K &&key, Args&&... args) {
+        putValue(std::move(key), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    HashMap(HashMap &&x) {
+        Size = 0;
+        makeTable(Default_capacity);
+        func = H();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    HashMap &operator=(HashMap &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the mappings of this map and x.
+     */
+    void swap(HashMap &x) {
+        std::swap(slot, x.slot);
+        std::swap(dist, x.dist);
+        std::swap(Size, x.Size);
+        std::swap(save_size, x.save_size);
+        std::swap(mask, x.mask);
+        std::swap(func, x.func);
+    }
+
+    /**
+     * Removes the mapping for the specified key from this map if present.
+     * If there is no mapping for the specified key, throws ElementNotExist exception.
+     * @throw ElementNotExist
+     */
+    void remove(const K &key) {
+        removeAt(find(key));
+    }
+
+    /**
+     * Lookups by any type Q which H can hash and K can be compared with,
+     * only there if H declares is_transparent (see HashMap).
+     */
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    bool containsKey(const Q &key) const {
+        return find(key) >= 0;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    const V &get(const Q &key) const {
+        int t = find(key);
+        if (t < 0) throw ElementNotExist();
+        return slot[t].value;
+    }
+
+    template <class Q, class G = H, class T = typename G::is_transparent>
+    void remove(const Q &key) {
+        removeAt(find(key));
+    }
+
+    /**
+     * Returns the number of key-value mappings in this map.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns the number of slots in the table.
+     */
+    int capacity() const {
+        return save_size;
+    }
+};
+
+template<class K, class V, class H, template <class> class A>
+class HashMap<K, V, H, RobinHood, A>::Iterator{
+    private:
+        int now_i;
+        const HashMap *container;
+
+        /*
+         * Return the first used slot after slot i, or save_size if there is none
+         */
+        int try_next(int i) const {
+            for (++i; i < container->save_size && container->dist[i] == 0; ++i);
+            return i;
+        }
+
+    public:
+        Iterator() {}
+        Iterator(const HashMap *c): now_i(-1), container(c) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return try_next(now_i) < container->save_size;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const Entry &next() {
+            int next_i = try_next(now_i);
+            if (next_i >= container->save_size) throw ElementNotExist();
+            now_i = next_i;
+            return container->slot[now_i];
+        }
+    };
+
+#endif
@@ -0,0 +1,373 @@
+/** @file */
+#ifndef __INTRUSIVELIST_H
+#define __INTRUSIVELIST_H
+
+#include "ElementExist.h"
+#include "ElementNotExist.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/**
+ * An intrusive linked list: the links live in the elements themselves.
+ *
+ * LinkedList copies each element into a node of its own. IntrusiveList instead
+ * links the caller's objects through a ListHook inside them, so adding and
+ * removing never allocate, an object is removed in O(1) given only a reference
+ * to it, and one object can be in as many lists as it has hooks.
+ *
+ * The hook is a base class, told apart by a tag when there are several of them,
+ * or a data member:
+ * @code
+ *      struct ByAge {};
+ *      struct Person: ListHook<>, ListHook<ByAge> {
+ *          ListHook<> room;
+ *          ...
+ *      };
+ *      IntrusiveList<Person> all;                                  // ListHook<>
+ *      IntrusiveList<Person, BaseHook<Person, ByAge> > by_age;      // ListHook<ByAge>
+ *      IntrusiveList<Person, MemberHook<Person, &Person::room> > in_room;
+ *      all.add(p); by_age.add(p); in_room.add(p);
+ *      in_room.remove(p);                                          // O(1)
+ * @endcode
+ * The list never owns its elements: it neither copies nor destroys them. An
+ * object must stay alive, and must not be moved, while it is in a list; a hook
+ * can be in only one list at a time, and adding an object whose hook is linked
+ * throws ElementExist. A copied object starts outside every list. remove(e),
+ * insertBefore and insertAfter only check that the element is linked, not
+ * that it is in this list (see remove).
+ */
+template <class Tag = void>
+class ListHook {
+    template <class, class> friend class IntrusiveList;
+
+    ListHook *succ, *prec;
+
+public:
+    ListHook(): succ(NULL), prec(NULL) {}
+    ListHook(const ListHook &): succ(NULL), prec(NULL) {}
+
+    ListHook &operator=(const ListHook &) {
+        return *this;
+    }
+
+    /**
+     * Returns true if the object is in a list through this hook.
+     */
+    bool isLinked() const {
+        return succ != NULL;
+    }
+};
+
+/**
+ * Finds the hook of T in its base class ListHook<Tag>.
+ */
+template <class T, class Tag = void>
+class BaseHook {
+public:
+    typedef ListHook<Tag> Hook;
+
+    static Hook &hook(T &e) {
+        return static_cast<Hook &>(e);
+    }
+
+    static T &object(Hook &h) {
+        return static_cast<T &>(h);
+    }
+};
+
+/**
+ * Finds the hook of T in its data member M.
+ */
+template <class T, ListHook<> T::*M>
+class MemberHook {
+    /*
+     * The distance from the start of a T to its member M
+     */
+    static std::ptrdiff_t offset() {
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type s;
+        T *p = reinterpret_cast<T *>(&s);
+        return reinterpret_cast<char *>(&(p->*M)) - reinterpret_cast<char *>(p);
+    }
+
+public:
+    typedef ListHook<> Hook;
+
+    static Hook &hook(T &e) {
+        return e.*M;
+    }
+
+    static T &object(Hook &h) {
+        return *reinterpret_cast<T *>(reinterpret_cast<char *>(&h) - offset());
+    }
+};
+
+template <class T, class H = BaseHook<T> >
+class IntrusiveList {
+    typedef typename H::Hook Hook;
+
+    /*
+     * @var start the sentinel: start.succ is the first element, start.prec the last
+     */
+    Hook start;
+    int Size;
+
+    IntrusiveList(const IntrusiveList &);
+    IntrusiveList &operator=(const IntrusiveList &);
+
+    /*
+     * Link h after p
+     * @throw ElementExist if h is linked already
+     */
+    void link(Hook *p, Hook *h) {
+        if (h->isLinked()) throw ElementExist();
+        h->prec = p;
+        h->succ = p->succ;
+        p->succ->prec = h;
+        p->succ = h;
+        ++Size;
+    }
+
+    void unlink(Hook *h) {
+        h->prec->succ = h->succ;
+        h->succ->prec = h->prec;
+        h->succ = h->prec = NULL;
+        --Size;
+    }
+
+    /*
+     * Point the first and the last element back at start, after start was swapped
+     */
+    void relink() {
+        if (Size == 0) start.succ = start.prec = &start;
+        else start.succ->prec = start.prec->succ = &start;
+    }
+
+public:
+    class Iterator;
+
+    /**
+     * Constructs an empty list
+     */
+    IntrusiveList(): Size(0) {
+        start.succ = start.prec = &start;
+    }
+
+    /**
+     * Move constructor
+     * The elements of c are taken over, c is left empty.
+     */
+    IntrusiveList(IntrusiveList &&c): Size(0) {
+        start.succ = start.prec = &start;
+        swap(c);
+    }
+
+    /**
+     * Move assignment operator
+     * The elements of this list are unlinked, c is left empty.
+     */
+    IntrusiveList &operator=(IntrusiveList &&c) {
+        if (this != &c) {
+            clear();
+            swap(c);
+        }
+        return *this;
+    }
+
+    /**
+     * Destructor
+     * Unlinks the elements, which may then be added to another list.
+     */
+    ~IntrusiveList() {
+        clear();
+    }
+
+    /**
+     * Exchanges the elements of this list and c.
+     */
+    void swap(IntrusiveList &c) {
+        std::swap(start.succ, c.start.succ);
+        std::swap(start.prec, c.start.prec);
+        std::swap(Size, c.Size);
+        relink();
+        c.relink();
+    }
+
+    /**
+     * Appends e to the end of this list. Always returns true.
+     * @throw ElementExist if e is in a list through this hook already
+     */
+    bool add(T &e) {
+        link(start.prec, &H::hook(e));
+        return true;
+    }
+
+    /**
+     * Inserts e at the beginning of this list.
+     * @throw ElementExist
+     */
+    void addFirst(T &e) {
+        link(&start, &H::hook(e));
+    }
+
+    /**
+     * Inserts e at the end of this list.
+     * @throw ElementExist
+     */
+    void addLast(T &e) {
+        link(start.prec, &H::hook(e));
+    }
+
+    /**
+     * Inserts e just before pos, which is in this list.
+     * Only isLinked() is checked: pos must be in this list, not in another
+     * list of the same hook type, or e joins that list while the size of this
+     * one grows (finding out would take a walk of the list).
+     * @throw ElementNotExist if pos is in no list through this hook
+     * @throw ElementExist if e is in one already
+     */
+    void insertBefore(T &pos, T &e) {
+        if (!H::hook(pos).isLinked()) throw ElementNotExist();
+        link(H::hook(pos).prec, &H::hook(e));
+    }
+
+    /**
+     * Inserts e just after pos, which is in this list.
+     * As with insertBefore, pos must be in this list and not just linked.
+     * @throw ElementNotExist if pos is in no list through this hook
+     * @throw ElementExist if e is in one already
+     */
+    void insertAfter(T &pos, T &e) {
+        if (!H::hook(pos).isLinked()) throw ElementNotExist();
+        link(&H::hook(pos), &H::hook(e));
+    }
+
+    /**
+     * Unlinks all of the elements from this list.
+     */
+    void clear() {
+        for (Hook *x = start.succ, *y; x != &start; x = y) {
+            y = x->succ;
+            x->succ = x->prec = NULL;
+        }
+        start.succ = start.prec = &start;
+        Size = 0;
+    }
+
+    /**
+     * Returns a reference to the first element.
+     * @throw ElementNotExist
+     */
+    T &getFirst() const {
+        if (Size == 0) throw ElementNotExist();
+        return H::object(*start.succ);
+    }
+
+    /**
+     * Returns a reference to the last element.
+     * @throw ElementNotExist
+     */
+    T &getLast() const {
+        if (Size == 0) throw ElementNotExist();
+        return H::object(*start.prec);
+    }
+
+    /**
+     * Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Removes e, which is in this list, in O(1).
+     * Only isLinked() is checked: e must be in this list, not in another list
+     * of the same hook type, or it leaves that list while the size of this one
+     * drops, and both sizes are wrong from then on.
+     * @throw ElementNotExist if e is in no list through this hook
+     */
+    void remove(T &e) {
+        Hook &h = H::hook(e);
+        if (!h.isLinked()) throw ElementNotExist();
+        unlink(&h);
+    }
+
+    /**
+     * Removes the first element from this list.
+     * @throw ElementNotExist
+     */
+    void removeFirst() {
+        if (Size == 0) throw ElementNotExist();
+        unlink(start.succ);
+    }
+
+    /**
+     * Removes the last element from this list.
+     * @throw ElementNotExist
+     */
+    void removeLast() {
+        if (Size == 0) throw ElementNotExist();
+        unlink(start.prec);
+    }
+
+    /**
+     * Returns the number of elements in this list.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    class Iterator {
+        /*
+         * @var pos the element next() returned last (start before the first call)
+         */
+        Hook *pos;
+        IntrusiveList *container;
+        bool dead;
+    public:
+
+        Iterator() {}
+        Iterator(IntrusiveList *con): pos(&con->start), container(con), dead(false) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pos->succ != &container->start;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        T &next() {
+            if (!hasNext()) throw ElementNotExist();
+            dead = false;
+            pos = pos->succ;
+            return H::object(*pos);
+        }
+
+        /**
+         * Unlinks from the underlying list the last element returned by the
+         * iterator.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (pos == &container->start || dead) throw ElementNotExist();
+            dead = true;
+            Hook *p = pos->prec;
+            container->unlink(pos);
+            pos = p;
+        }
+    };
+};
+
+#endif
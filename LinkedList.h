@@ -4,13 +4,41 @@
 
 #include "IndexOutOfBound.h"
 #include "ElementNotExist.h"
+#include "SlabAllocator.h"
+
+#include <cstdlib>
+#include <functional>
+#include <type_traits>
+#include <utility>
 
 /**
  * A linked list.
  *
  * The iterator iterates in the order of the elements being loaded into this list.
+ *
+ * Template argument P chooses the layout. NodePerElement, the default, keeps one
+ * node per element. Unrolled (see LinkedListUnrolled.h) keeps a small array of
+ * elements in each node, so walking the list touches far fewer nodes:
+ * @code
+ *      LinkedList<int, Unrolled> list;
+ * @endcode
+ * SkipIndexed (see LinkedListSkip.h) is an indexable skip list: get, set,
+ * add(index) and removeIndex take O(log n) instead of a walk along the list.
+ * Template argument A is the allocator of the nodes (see SlabAllocator.h). By
+ * default they are cut from slabs owned by the list and reused through its free
+ * list, so adding an element rarely calls operator new, and clear() frees whole
+ * slabs; use NewAllocator to take each node from operator new.
+ *
+ * Threads: get() is const, but it moves the finger (the position the list
+ * remembers, see get), as set, add(index) and removeIndex do. So a list, even a
+ * const one, must not be read by get() from two threads at once: lock around
+ * it, or give each reader its own copy. SkipIndexed keeps no finger.
  */
-template <class T>
+class NodePerElement {};
+class Unrolled {};
+class SkipIndexed {};
+
+template <class T, class P = NodePerElement, template <class> class A = SlabAllocator>
 class LinkedList {
 private:
     struct Node {
@@ -19,6 +47,11 @@ private:
         Node() {
             succ = NULL, prec = NULL;
         }
+        /*
+         * data is made from args in place
+         */
+        template <class... Args>
+        Node(Node *s, Node *p, Args&&... args): data(std::forward<Args>(args)...), succ(s), prec(p) {}
         ~Node(){}
     };
 
@@ -30,30 +63,53 @@ private:
      */
     Node *start;
     int Size;
+    A<Node> alloc;
+
+    /*
+     * @var finger the node reached by the last positional access, NULL if unknown
+     * @var finger_index its index
+     * Edits at either end keep it right; other structural edits forget it.
+     */
+    mutable Node *finger;
+    mutable int finger_index;
 
     /*
      * Clear the LinkedList
+     * The nodes are only visited when they need a destructor or the allocator
+     * cannot free them all at once.
      */
     void makeEmpty() {
         Size = 0;
         Node *p, *q;
         p = start->succ;
         start->succ = start->prec = start;
-        while (p !=  start) {
-            q = p->succ; delete p; p = q;
-        }
+        finger = NULL;
+        if (!A<Node>::Releases_all || !std::is_trivially_destructible<T>::value)
+            while (p !=  start) {
+                q = p->succ; deleteNode(p); p = q;
+            }
+        alloc.releaseAll();
+    }
+
+    void deleteNode(Node *p) {
+        p->~Node();
+        alloc.deallocate(p);
     }
 
     /*
      * TODO insert an element behind the element : e
      * All insert operation is based addAll
+     * The new element is made from args, so it is copied, moved or
+     * built in place as the caller asks.
      */
-    void addAll(Node *Pre, const T& e) {
+    template <class... Args>
+    void addAll(Node *Pre, Args&&... args) {
+        if (Pre == start) ++finger_index;
+        else if (Pre != start->prec) finger = NULL;
         Node *Suc = Pre->succ;
-        Node *p = new Node;
-        p->data = e;
-        p->succ = Suc; Suc->prec = p;
-        p->prec = Pre; Pre->succ = p;
+        Node *p = new (alloc.allocate()) Node(Suc, Pre, std::forward<Args>(args)...);
+        Suc->prec = p;
+        Pre->succ = p;
         ++Size;
     }
 
@@ -61,18 +117,127 @@ private:
      * TODO delete the element : p
      * All delete operation is based removeAll
      */
-    void removeAll(const Node *p) {
+    void removeAll(Node *p) {
+        if (p == finger) finger = NULL;
+        else if (p == start->succ) --finger_index;
+        else if (p != start->prec) finger = NULL;
         Node *Suc = p->succ;
         Node *Pre = p->prec;
         Pre->succ = Suc; Suc->prec = Pre;
-        delete p;
+        deleteNode(p);
         --Size;
     }
 
+    /*
+     * The node at position index in [0, Size), walked to from the nearest of
+     * the two ends and the finger; it becomes the finger
+     */
+    Node *nodeAt(int index) const {
+        // start stands before the first node and after the last
+        Node *p = start;
+        int at = index + 1 <= Size - index ? -1 : Size;
+        if (finger != NULL && std::abs(index - finger_index) < std::abs(index - at)) {
+            p = finger;
+            at = finger_index;
+        }
+        for (; at < index; ++at) p = p->succ;
+        for (; at > index; --at) p = p->prec;
+        finger = p;
+        finger_index = index;
+        return p;
+    }
+
+    /*
+     * The node before position index (start for 0)
+     */
+    Node *before(int index) const {
+        return index == 0 ? start : nodeAt(index - 1);
+    }
+
+    /*
+     * Unlink the nodes first .. last and link them behind Pre
+     */
+    static void transfer(Node *Pre, Node *first, Node *last) {
+        first->prec->succ = last->succ;
+        last->succ->prec = first->prec;
+        Node *Suc = Pre->succ;
+        Pre->succ = first; first->prec = Pre;
+        last->succ = Suc; Suc->prec = last;
+    }
+
+    typedef std::integral_constant<bool, std::is_nothrow_move_constructible<T>::value> Nothrow_move;
+
+    /*
+     * Move the k nodes first .. last of c behind Pre, which is not among them.
+     * Between two lists whose allocators do not share their memory, up to
+     * Move_limit elements are moved into new nodes, so that the lists stay apart;
+     * more are relinked, which joins the allocators (see SlabAllocator::join).
+     */
+    void moveNodes(Node *Pre, LinkedList &c, Node *first, Node *last, int k) {
+        if (&c == this) {
+            if (Pre != last && Pre->succ != first) transfer(Pre, first, last);
+        } else if (alloc.joined(c.alloc)
+                || !(k <= Move_limit && moveElements(Pre, c, first, last, Nothrow_move()))) {
+            alloc.join(c.alloc);
+            transfer(Pre, first, last);
+            Size += k;
+            c.Size -= k;
+        }
+        finger = c.finger = NULL;
+    }
+
+    /*
+     * Move the elements first .. last of c into new nodes behind Pre, and give
+     * the old nodes back to c. Only a T which moves without throwing is taken, so
+     * that a failed allocation leaves both lists whole.
+     */
+    bool moveElements(Node *Pre, LinkedList &c, Node *first, Node *last, std::true_type) {
+        Node *end = last->succ;
+        for (Node *p = first; p != end; ) {
+            Node *q = p->succ;
+            addAll(Pre, std::move(p->data));
+            Pre = Pre->succ;
+            c.removeAll(p);
+            p = q;
+        }
+        return true;
+    }
+
+    bool moveElements(Node *, LinkedList &, Node *, Node *, std::false_type) {
+        return false;
+    }
+
+    /*
+     * Merge two sorted runs ending in NULL; on ties the nodes of a come first.
+     * The prec links are kept inside a run, and head->prec is its last node.
+     */
+    template <class Less>
+    static Node *mergeRuns(Node *a, Node *b, Less &less) {
+        Node *a_last = a->prec, *b_last = b->prec;
+        Node *head, *t = NULL, **link = &head;
+        while (a != NULL && b != NULL) {
+            Node *x;
+            if (less(b->data, a->data)) { x = b; b = b->succ; }
+            else { x = a; a = a->succ; }
+            *link = x; x->prec = t;
+            t = x; link = &x->succ;
+        }
+        Node *rest = a != NULL ? a : b;
+        *link = rest; rest->prec = t;
+        head->prec = a != NULL ? a_last : b_last;
+        return head;
+    }
+
 public:
 
     class Iterator;
 
+    /**
+     * A splice of up to Move_limit elements from a list whose allocator does not
+     * share its memory with this one moves them into new nodes (see splice).
+     */
+    static const int Move_limit = 16;
+
     /**
      * TODO Constructs an empty linked list
      */
@@ -80,15 +245,19 @@ public:
         start = new Node;
         start->succ = start->prec = start;
         Size = 0;
+        finger = NULL;
+        finger_index = 0;
     }
 
     /**
      * TODO Copy constructor
      */
-    LinkedList(const LinkedList<T> &c) {
+    LinkedList(const LinkedList &c) {
         Size = 0;
         start = new Node;
         start->succ = start->prec = start;
+        finger = NULL;
+        finger_index = 0;
         for (Node *k = c.start->succ; k != c.start; k = k->succ)
             addAll(start->prec, k->data);
     }
@@ -96,12 +265,50 @@ public:
     /**
      * TODO Assignment operator
      */
-    LinkedList<T>& operator=(const LinkedList<T> &c) {
+    LinkedList& operator=(const LinkedList &c) {
+        if (this == &c) return *this;
         makeEmpty();
         Size = 0;
         start->succ = start->prec = start;
         for (Node *k = c.start->succ; k != c.start; k = k->succ)
             addAll(start->prec, k->data);    
+        return *this;
+    }
+
+    /**
+     * Move constructor
+     * The nodes of c are taken over, c is left empty.
+     */
+    LinkedList(LinkedList &&c) {
+        start = new Node;
+        start->succ = start->prec = start;
+        Size = 0;
+        finger = NULL;
+        finger_index = 0;
+        swap(c);
+    }
+
+    /**
+     * Move assignment operator
+     * c is left empty.
+     */
+    LinkedList& operator=(LinkedList &&c) {
+        if (this != &c) {
+            makeEmpty();
+            swap(c);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the elements of this list and c.
+     */
+    void swap(LinkedList &c) {
+        std::swap(start, c.start);
+        std::swap(Size, c.Size);
+        std::swap(finger, c.finger);
+        std::swap(finger_index, c.finger_index);
+        alloc.swap(c.alloc);
     }
 
     /**
@@ -121,6 +328,20 @@ public:
         return true;
     }
 
+    bool add(T&& e) {
+        addAll(start->prec, std::move(e));
+        return true;
+    }
+
+    /**
+     * Appends an element made from args to the end of this list.
+     * Equivalent to emplaceLast.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        addAll(start->prec, std::forward<Args>(args)...);
+    }
+
     /**
      * TODO Inserts the specified element to the beginning of this list.
      */
@@ -128,6 +349,18 @@ public:
         addAll(start, elem);
     }
 
+    void addFirst(T&& elem) {
+        addAll(start, std::move(elem));
+    }
+
+    /**
+     * Inserts an element made from args to the beginning of this list.
+     */
+    template <class... Args>
+    void emplaceFirst(Args&&... args) {
+        addAll(start, std::forward<Args>(args)...);
+    }
+
     /**
      * TODO Insert the specified element to the end of this list.
      * Equivalent to add.
@@ -136,6 +369,18 @@ public:
         addAll(start->prec, elem);
     }
 
+    void addLast(T &&elem) {
+        addAll(start->prec, std::move(elem));
+    }
+
+    /**
+     * Inserts an element made from args to the end of this list.
+     */
+    template <class... Args>
+    void emplaceLast(Args&&... args) {
+        addAll(start->prec, std::forward<Args>(args)...);
+    }
+
     /**
      * TODO Inserts the specified element to the specified position in this list.
      * The range of index parameter is [0, Size], where index=0 means inserting to the head,
@@ -144,9 +389,18 @@ public:
      */
     void add(int index, const T& element) {
         if (index < 0 || index > Size) throw IndexOutOfBound();
-        Node *p = start;
-        while (index--) p = p->succ;
+        Node *p = before(index);
         addAll(p, element);
+        finger = p->succ;
+        finger_index = index;
+    }
+
+    void add(int index, T&& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        Node *p = before(index);
+        addAll(p, std::move(element));
+        finger = p->succ;
+        finger_index = index;
     }
 
     /**
@@ -168,13 +422,15 @@ public:
     /**
      * TODO Returns a const reference to the element at the specified position in this list.
      * The index is zero-based, with range [0, Size).
+     * Like set, add(index) and removeIndex, it walks from the nearest end or
+     * from the position used last (the finger), so going through the indices
+     * in order costs O(1) a step. It moves the finger, so it must not be called
+     * from two threads at once, although it is const.
      * @throw IndexOutOfBound
      */
     const T& get(int index) const {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
-        Node *p = start->succ;
-        while (index--) p = p->succ;
-        return p->data;
+        return nodeAt(index)->data;
     }
 
     /**
@@ -209,9 +465,13 @@ public:
      */
     void removeIndex(int index) {
         if (index < 0 || index >= Size) throw IndexOutOfBound();
-        Node *p = start->succ;
-        while (index--) p = p->succ;
-        removeAll(p);   
+        Node *p = nodeAt(index);
+        Node *Pre = p->prec;
+        removeAll(p);
+        if (Pre != start) {
+            finger = Pre;
+            finger_index = index - 1;
+        }
     }
 
     /**
@@ -252,9 +512,12 @@ public:
      */
     void set(int index, const T &element) {
         if (index < 0 || index >= Size)  throw IndexOutOfBound();
-        Node *p = start->succ;
-        while (index--) p = p->succ;
-        p->data = element;
+        nodeAt(index)->data = element;
+    }
+
+    void set(int index, T &&element) {
+        if (index < 0 || index >= Size)  throw IndexOutOfBound();
+        nodeAt(index)->data = std::move(element);
     }
 
     /**
@@ -264,6 +527,165 @@ public:
         return Size;
     }
 
+    /**
+     * Moves all the elements of c to position index of this list, in their
+     * order, and leaves c empty. The nodes are relinked, not copied; the memory
+     * of c's allocator goes with them. The range of index is [0, Size].
+     * @throw IndexOutOfBound
+     */
+    void splice(int index, LinkedList &c) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        if (&c == this || c.Size == 0) return;
+        transfer(before(index), c.start->succ, c.start->prec);
+        Size += c.Size;
+        c.Size = 0;
+        finger = c.finger = NULL;
+        alloc.adopt(c.alloc);
+    }
+
+    /**
+     * Moves the element at position from of c to position index of this list.
+     * c may be this list; index is then counted before the element is taken out.
+     * @throw IndexOutOfBound
+     */
+    void splice(int index, LinkedList &c, int from) {
+        if (from < 0 || from >= c.Size) throw IndexOutOfBound();
+        splice(index, c, from, from + 1);
+    }
+
+    /**
+     * Moves the elements at positions [from, to) of c to position index of this
+     * list, in their order. c may be this list, if index is not inside (from, to);
+     * index is then counted before the elements are taken out.
+     *
+     * This walks to the three positions; the forms taking iterators below do not.
+     * The nodes are relinked, so the elements keep their addresses, with one
+     * exception. Relinking nodes of another list joins the two allocators (see
+     * SlabAllocator::join): from then on neither list frees its slabs before
+     * both, and every list joined with them, have let go of theirs. To keep the
+     * lists apart, up to Move_limit elements taken from a list not joined yet are
+     * moved into new nodes instead, if T moves without throwing.
+     * @throw IndexOutOfBound
+     */
+    void splice(int index, LinkedList &c, int from, int to) {
+        if (index < 0 || index > Size || from < 0 || to > c.Size || from > to) throw IndexOutOfBound();
+        if (&c == this && index > from && index < to) throw IndexOutOfBound();
+        if (from == to || (&c == this && (index == from || index == to))) return;
+        Node *Pre = before(index);
+        Node *first = c.before(from)->succ;
+        Node *last = c.before(to);
+        moveNodes(Pre, c, first, last, to - from);
+    }
+
+    /**
+     * Moves the element it returned last from c to the position of where, an
+     * iterator of this list: behind the element where returned last (at the
+     * front if none), so that where.next() returns it. c may be this list.
+     * it is left as after it.remove(). This takes O(1) time; the nodes are
+     * relinked as by splice(index, c, from, to).
+     * @throw ElementNotExist if it has returned no element, or the iterators
+     *  are not those of this list and c
+     */
+    void splice(const Iterator &where, LinkedList &c, Iterator &it) {
+        if (where.container != this || it.container != &c || it.pos == c.start || it.dead)
+            throw ElementNotExist();
+        Node *p = it.pos;
+        it.pos = p->prec;
+        it.dead = true;
+        moveNodes(where.pos, c, p, p, 1);
+    }
+
+    /**
+     * Moves the elements of c which last has returned but first has not, in
+     * their order, to the position of where, as above. n is their number; if it
+     * is given the call takes O(1) time, otherwise they are counted, unless c is
+     * this list. where must not be among them. first keeps its place; last is
+     * left at it, as if it had removed them.
+     * @throw ElementNotExist if the iterators are not those of this list and c
+     */
+    void splice(const Iterator &where, LinkedList &c, const Iterator &first, Iterator &last, int n = -1) {
+        if (where.container != this || first.container != &c || last.container != &c)
+            throw ElementNotExist();
+        if (first.pos == last.pos) return;
+        if (n < 0 && &c != this) {
+            n = 0;
+            for (Node *p = first.pos; p != last.pos; p = p->succ) ++n;
+        }
+        Node *from = first.pos->succ, *to = last.pos;
+        last.pos = first.pos;
+        last.dead = true;
+        moveNodes(where.pos, c, from, to, n);
+    }
+
+    /**
+     * Sorts this list by less (by operator< if omitted), keeping equal elements in
+     * their order. This is a bottom-up merge sort on the links: no element is
+     * copied or moved, and it needs no memory besides 64 run heads.
+     */
+    template <class Less>
+    void sort(Less less) {
+        if (Size < 2) return;
+        finger = NULL;
+        Node *bin[64];
+        int fill = 0;
+        start->prec->succ = NULL;
+        for (Node *p = start->succ; p != NULL; ) {
+            Node *run = p;
+            p = p->succ;
+            run->succ = NULL;
+            run->prec = run;
+            int k = 0;
+            for (; k < fill && bin[k] != NULL; ++k) {
+                run = mergeRuns(bin[k], run, less);
+                bin[k] = NULL;
+            }
+            if (k == fill) ++fill;
+            bin[k] = run;
+        }
+        Node *run = NULL;
+        for (int k = 0; k < fill; ++k)
+            if (bin[k] != NULL) run = run == NULL ? bin[k] : mergeRuns(bin[k], run, less);
+        Node *last = run->prec;
+        start->succ = run; run->prec = start;
+        last->succ = start; start->prec = last;
+    }
+
+    void sort() {
+        sort(std::less<T>());
+    }
+
+    /**
+     * Merges c, sorted by less, into this list, sorted the same way, and leaves c
+     * empty. Equal elements of this list come before those of c. The nodes are
+     * relinked as by splice(index, c).
+     */
+    template <class Less>
+    void merge(LinkedList &c, Less less) {
+        if (&c == this || c.Size == 0) return;
+        Node *p = start->succ;
+        Node *q = c.start->succ;
+        while (q != c.start) {
+            if (p != start && !less(q->data, p->data)) {
+                p = p->succ;
+                continue;
+            }
+            Node *last = q;
+            while (last->succ != c.start && (p == start || less(last->succ->data, p->data)))
+                last = last->succ;
+            Node *next = last->succ;
+            transfer(p->prec, q, last);
+            q = next;
+        }
+        Size += c.Size;
+        c.Size = 0;
+        finger = c.finger = NULL;
+        alloc.adopt(c.alloc);
+    }
+
+    void merge(LinkedList &c) {
+        merge(c, std::less<T>());
+    }
+
     /**
      * TODO Returns an iterator over the elements in this list.
      */
@@ -272,8 +694,9 @@ public:
     }
 };
 
-template <class T>
-class LinkedList<T>::Iterator {
+template <class T, class P, template <class> class A>
+class LinkedList<T, P, A>::Iterator {
+    friend class LinkedList;
     private:
         Node *pos;
         LinkedList *container;
@@ -318,5 +741,7 @@ class LinkedList<T>::Iterator {
         }
     };
 
+#include "LinkedListUnrolled.h"
+#include "LinkedListSkip.h"
 
 #endif
@@ -0,0 +1,480 @@
+/** @file */
+#ifndef __LINKEDLIST_SKIP_H
+#define __LINKEDLIST_SKIP_H
+
+#include "LinkedList.h"
+
+#include <new>
+
+/**
+ * LinkedList with the SkipIndexed policy: an indexable skip list.
+ *
+ * Level 0 is the doubly linked list of the elements. Each node also has a tower
+ * of height h, with probability 4^-(h-1), and on level l it links to the next node
+ * whose tower reaches l, together with the width of that link: the number of
+ * level-0 steps it skips. Walking down from the top level and summing widths
+ * finds any index in O(log n) expected steps, so get, set, add(index) and
+ * removeIndex all cost O(log n). Iteration walks level 0, like the plain list.
+ *
+ * The towers make the nodes of different sizes, so they come from operator new
+ * and template argument A is ignored.
+ */
+template <class T, template <class> class A>
+class LinkedList<T, SkipIndexed, A>
+{
+    static const int Max_level = 16;
+
+    struct Node;
+
+    /*
+     * @var width the number of elements from this node to next; with next NULL,
+     * to one past the last element
+     */
+    struct Link {
+        Node *next;
+        int width;
+    };
+
+    /*
+     * data is only constructed in the element nodes, not in head
+     */
+    struct Node {
+        T data;
+        Node *prec;
+        int height;
+        Link lv[1];
+    };
+
+    /*
+     * @var head stands before the first element, with a tower of Max_level
+     * @var tail is the last element (head if there is none)
+     */
+    Node *head, *tail;
+    int Size;
+    unsigned int seed;
+
+    static Node *allocate(int h) {
+        return (Node *) ::operator new(sizeof(Node) + (h - 1) * sizeof(Link));
+    }
+
+    int randomHeight() {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        int h = 1;
+        for (unsigned int r = seed; (r & 3) == 0 && h < Max_level; r >>= 2) ++h;
+        return h;
+    }
+
+    /*
+     * Fill up[l] with the last node on level l before position index, and
+     * at[l] with its position (-1 for head)
+     */
+    void search(int index, Node **up, int *at) const {
+        Node *x = head;
+        int pos = -1;
+        for (int l = Max_level - 1; l >= 0; --l) {
+            while (x->lv[l].next != NULL && pos + x->lv[l].width < index) {
+                pos += x->lv[l].width;
+                x = x->lv[l].next;
+            }
+            up[l] = x;
+            at[l] = pos;
+        }
+    }
+
+    Node *nodeAt(int index) const {
+        Node *x = head;
+        int pos = -1;
+        for (int l = Max_level - 1; l >= 0; --l)
+            while (x->lv[l].next != NULL && pos + x->lv[l].width <= index) {
+                pos += x->lv[l].width;
+                x = x->lv[l].next;
+            }
+        return x;
+    }
+
+    template <class... Args>
+    void insertAt(int index, Args&&... args) {
+        Node *up[Max_level];
+        int at[Max_level];
+        search(index, up, at);
+        int h = randomHeight();
+        Node *n = allocate(h);
+        try {
+            new (&n->data) T(std::forward<Args>(args)...);
+        } catch (...) {
+            ::operator delete(n);
+            throw;
+        }
+        n->height = h;
+        for (int l = 0; l < Max_level; ++l) {
+            Link &u = up[l]->lv[l];
+            if (l < h) {
+                n->lv[l].next = u.next;
+                n->lv[l].width = at[l] + u.width + 1 - index;
+                u.next = n;
+                u.width = index - at[l];
+            } else ++u.width;
+        }
+        Node *s = n->lv[0].next;
+        n->prec = up[0];
+        if (s != NULL) s->prec = n;
+        else tail = n;
+        ++Size;
+    }
+
+    void eraseAt(int index) {
+        Node *up[Max_level];
+        int at[Max_level];
+        search(index, up, at);
+        Node *x = up[0]->lv[0].next;
+        for (int l = 0; l < Max_level; ++l) {
+            Link &u = up[l]->lv[l];
+            if (l < x->height) {
+                u.next = x->lv[l].next;
+                u.width += x->lv[l].width - 1;
+            } else --u.width;
+        }
+        Node *s = x->lv[0].next;
+        if (s != NULL) s->prec = x->prec;
+        else tail = x->prec;
+        x->data.~T();
+        ::operator delete(x);
+        --Size;
+    }
+
+    void makeEmpty() {
+        for (Node *x = head->lv[0].next, *y; x != NULL; x = y) {
+            y = x->lv[0].next;
+            x->data.~T();
+            ::operator delete(x);
+        }
+        for (int l = 0; l < Max_level; ++l) {
+            head->lv[l].next = NULL;
+            head->lv[l].width = 1;
+        }
+        tail = head;
+        Size = 0;
+    }
+
+    void init() {
+        head = allocate(Max_level);
+        head->prec = NULL;
+        head->height = Max_level;
+        head->lv[0].next = NULL;
+        seed = 2463534242u;
+        makeEmpty();
+    }
+
+    void copy(const LinkedList &c) {
+        for (Node *x = c.head->lv[0].next; x != NULL; x = x->lv[0].next)
+            insertAt(Size, x->data);
+    }
+
+public:
+    class Iterator;
+
+    /**
+     * Constructs an empty linked list
+     */
+    LinkedList() {
+        init();
+    }
+
+    /**
+     * Copy constructor
+     */
+    LinkedList(const LinkedList &c) {
+        init();
+        copy(c);
+    }
+
+    /**
+     * Assignment operator
+     */
+    LinkedList& operator=(const LinkedList &c) {
+        if (this == &c) return *this;
+        makeEmpty();
+        copy(c);
+        return *this;
+    }
+
+    /**
+     * Move constructor
+     * The nodes of c are taken over, c is left empty.
+     */
+    LinkedList(LinkedList &&c) {
+        init();
+        swap(c);
+    }
+
+    /**
+     * Move assignment operator
+     * c is left empty.
+     */
+    LinkedList& operator=(LinkedList &&c) {
+        if (this != &c) {
+            makeEmpty();
+            swap(c);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the elements of this list and c.
+     */
+    void swap(LinkedList &c) {
+        std::swap(head, c.head);
+        std::swap(tail, c.tail);
+        std::swap(Size, c.Size);
+        std::swap(seed, c.seed);
+    }
+
+    /**
+     * Destructor
+     */
+    ~LinkedList() {
+        makeEmpty();
+        ::operator delete(head);
+    }
+
+    /**
+     * Appends the specified element to the end of this list.
+     * Always returns true.
+     */
+    bool add(const T& e) {
+        insertAt(Size, e);
+        return true;
+    }
+
+    bool add(T&& e) {
+        insertAt(Size, std::move(e));
+        return true;
+    }
+
+    /**
+     * Appends an element made from args to the end of this list.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        insertAt(Size, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Inserts the specified element to the beginning of this list.
+     */
+    void addFirst(const T& elem) {
+        insertAt(0, elem);
+    }
+
+    void addFirst(T&& elem) {
+        insertAt(0, std::move(elem));
+    }
+
+    template <class... Args>
+    void emplaceFirst(Args&&... args) {
+        insertAt(0, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Insert the specified element to the end of this list.
+     */
+    void addLast(const T &elem) {
+        insertAt(Size, elem);
+    }
+
+    void addLast(T &&elem) {
+        insertAt(Size, std::move(elem));
+    }
+
+    template <class... Args>
+    void emplaceLast(Args&&... args) {
+        insertAt(Size, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Inserts the specified element to the specified position in this list.
+     * The range of index parameter is [0, Size].
+     * @throw IndexOutOfBound
+     */
+    void add(int index, const T& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        insertAt(index, element);
+    }
+
+    void add(int index, T&& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        insertAt(index, std::move(element));
+    }
+
+    /**
+     * Removes all of the elements from this list.
+     */
+    void clear() {
+        makeEmpty();
+    }
+
+    /**
+     * Returns true if this list contains the specified element.
+     */
+    bool contains(const T& e) const {
+        for (Node *x = head->lv[0].next; x != NULL; x = x->lv[0].next)
+            if (x->data == e) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the element at the specified position in this list.
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        return nodeAt(index)->data;
+    }
+
+    /**
+     * Returns a const reference to the first element.
+     * @throw ElementNotExist
+     */
+    const T& getFirst() const {
+        if (Size == 0) throw ElementNotExist();
+        return head->lv[0].next->data;
+    }
+
+    /**
+     * Returns a const reference to the last element.
+     * @throw ElementNotExist
+     */
+    const T& getLast() const {
+        if (Size == 0) throw ElementNotExist();
+        return tail->data;
+    }
+
+    /**
+     * Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Removes the element at the specified position in this list.
+     * @throw IndexOutOfBound
+     */
+    void removeIndex(int index) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        eraseAt(index);
+    }
+
+    /**
+     * Removes the first occurrence of the specified element from this list, if it is present.
+     * Returns true if it was present in the list, otherwise false.
+     */
+    bool remove(const T &e) {
+        int i = 0;
+        for (Node *x = head->lv[0].next; x != NULL; x = x->lv[0].next, ++i)
+            if (x->data == e) {
+                eraseAt(i);
+                return true;
+            }
+        return false;
+    }
+
+    /**
+     * Removes the first element from this list.
+     * @throw ElementNotExist
+     */
+    void removeFirst() {
+        if (Size == 0) throw ElementNotExist();
+        eraseAt(0);
+    }
+
+    /**
+     * Removes the last element from this list.
+     * @throw ElementNotExist
+     */
+    void removeLast() {
+        if (Size == 0) throw ElementNotExist();
+        eraseAt(Size - 1);
+    }
+
+    /**
+     * Replaces the element at the specified position in this list with the specified element.
+     * @throw IndexOutOfBound
+     */
+    void set(int index, const T &element) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        nodeAt(index)->data = element;
+    }
+
+    void set(int index, T &&element) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        nodeAt(index)->data = std::move(element);
+    }
+
+    /**
+     * Returns the number of elements in this list.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    class Iterator
+    {
+        /*
+         * @var pos the element next() returned last (head before the first call)
+         * @var index its position
+         */
+        Node *pos;
+        int index;
+        LinkedList *container;
+        bool dead;
+    public:
+
+        Iterator() {}
+        Iterator(LinkedList *con): pos(con->head), index(-1), container(con), dead(false) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pos->lv[0].next != NULL;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if (!hasNext()) throw ElementNotExist();
+            dead = false;
+            pos = pos->lv[0].next;
+            ++index;
+            return pos->data;
+        }
+
+        /**
+         * Removes from the underlying collection the last element
+         * returned by the iterator; O(log n).
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (pos == container->head || dead) throw ElementNotExist();
+            dead = true;
+            Node *p = pos->prec;
+            container->eraseAt(index);
+            pos = p;
+            --index;
+        }
+    };
+};
+
+#endif
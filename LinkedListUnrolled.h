@@ -0,0 +1,564 @@
+/** @file */
+#ifndef __LINKEDLIST_UNROLLED_H
+#define __LINKEDLIST_UNROLLED_H
+
+#include "LinkedList.h"
+#include "Search.h"
+
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * LinkedList with the Unrolled policy: each node (a chunk) holds up to Capacity
+ * elements in an array, and the chunks form the same cycle through start as the
+ * nodes of the plain list.
+ *
+ * Walking the list follows one pointer per chunk instead of one per element, and
+ * the elements of a chunk sit next to each other in memory. Inserting into a full
+ * chunk splits it in two halves; removing merges two neighbouring chunks whose
+ * elements fit in half a chunk, so the chunks stay at least a quarter full on
+ * average. Insertion and Iterator::remove still cost O(1): at most one chunk of
+ * elements moves.
+ *
+ * Unlike the plain list, elements move between slots, so references to them are
+ * only valid until the next insertion or removal.
+ */
+template <class T, template <class> class A>
+class LinkedList<T, Unrolled, A>
+{
+    static const int Capacity = sizeof(T) >= 64 ? 4 : 256 / sizeof(T);
+
+    struct Chunk {
+        Chunk *succ, *prec;
+        int count;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type slot[Capacity];
+
+        T &at(int i) { return *(T *) &slot[i]; }
+    };
+
+    static const bool Trivial = std::is_trivially_copyable<T>::value;
+
+    /*
+     * &var start is the sentinel chunk, which holds no elements
+     * start->succ = first chunk, start->prec = last chunk
+     */
+    Chunk *start;
+    int Size;
+    A<Chunk> alloc;
+
+    /*
+     * @var finger the chunk reached by the last positional access, NULL if unknown
+     * @var finger_base the index of its first element
+     */
+    mutable Chunk *finger;
+    mutable int finger_base;
+
+    /*
+     * Link an empty chunk behind pre
+     */
+    Chunk *newChunk(Chunk *pre) {
+        Chunk *c = new (alloc.allocate()) Chunk;
+        c->count = 0;
+        c->prec = pre;
+        c->succ = pre->succ;
+        pre->succ->prec = c;
+        pre->succ = c;
+        return c;
+    }
+
+    void dropChunk(Chunk *c) {
+        c->prec->succ = c->succ;
+        c->succ->prec = c->prec;
+        alloc.deallocate(c);
+    }
+
+    /*
+     * Move n elements from from to to; the ranges may overlap
+     */
+    static void relocate(T *to, T *from, int n) {
+        if (n <= 0 || to == from) return;
+        if (Trivial) std::memmove((void *) to, (const void *) from, n * sizeof(T));
+        else if (to < from)
+            for (int k = 0; k < n; ++k) {
+                new (to + k) T(std::move(from[k]));
+                from[k].~T();
+            }
+        else
+            for (int k = n - 1; k >= 0; --k) {
+                new (to + k) T(std::move(from[k]));
+                from[k].~T();
+            }
+    }
+
+    void makeEmpty() {
+        Chunk *p = start->succ;
+        start->succ = start->prec = start;
+        Size = 0;
+        finger = NULL;
+        if (!A<Chunk>::Releases_all || !std::is_trivially_destructible<T>::value)
+            for (Chunk *q; p != start; p = q) {
+                q = p->succ;
+                for (int k = 0; k < p->count; ++k)
+                    p->at(k).~T();
+                alloc.deallocate(p);
+            }
+        alloc.releaseAll();
+    }
+
+    /*
+     * The chunk holding the index-th element, with index made relative to it;
+     * start if index == Size. The walk starts from the nearest of the two ends
+     * and the finger.
+     */
+    Chunk *locate(int &index) const {
+        if (index == Size) {
+            index = 0;
+            return start;
+        }
+        Chunk *c = start->succ;
+        int base = 0, d = index;
+        if (Size - index < d) {
+            c = start->prec;
+            base = Size - c->count;
+            d = Size - index;
+        }
+        if (finger != NULL && std::abs(index - finger_base) < d) {
+            c = finger;
+            base = finger_base;
+        }
+        while (index < base) {
+            c = c->prec;
+            base -= c->count;
+        }
+        while (index >= base + c->count) {
+            base += c->count;
+            c = c->succ;
+        }
+        finger = c;
+        finger_base = base;
+        index -= base;
+        return c;
+    }
+
+    /*
+     * Insert an element made from args before the i-th element of c, or at the
+     * end if c is start
+     */
+    template <class... Args>
+    void emplaceAt(Chunk *c, int i, Args&&... args) {
+        // appending leaves the finger right
+        if (c != start) finger = NULL;
+        if (c == start) {
+            c = start->prec;
+            i = c->count;
+        }
+        if (c != start && c->count < Capacity && i == c->count) {
+            new (&c->at(i)) T(std::forward<Args>(args)...);
+            ++c->count;
+            ++Size;
+            return;
+        }
+        // args may name an element which moves below
+        T e(std::forward<Args>(args)...);
+        if (c == start || (c->count == Capacity && i == c->count)) {
+            c = newChunk(c);
+            i = 0;
+        } else if (c->count == Capacity) {
+            if (i == 0 && c->prec != start && c->prec->count < Capacity) {
+                c = c->prec;
+                i = c->count;
+            } else {
+                Chunk *n = newChunk(c);
+                int h = Capacity / 2;
+                relocate(&n->at(0), &c->at(h), Capacity - h);
+                n->count = Capacity - h;
+                c->count = h;
+                if (i > h) {
+                    c = n;
+                    i -= h;
+                }
+            }
+        }
+        T *p = &c->at(i);
+        relocate(p + 1, p, c->count - i);
+        new (p) T(std::move(e));
+        ++c->count;
+        ++Size;
+    }
+
+    /*
+     * Remove the i-th element of c; c and i are left at the element which
+     * followed it (start if none)
+     */
+    void eraseAt(Chunk *&c, int &i) {
+        finger = NULL;
+        T *p = &c->at(i);
+        p->~T();
+        relocate(p, p + 1, c->count - i - 1);
+        --c->count;
+        --Size;
+        if (c->count == 0) {
+            Chunk *n = c->succ;
+            dropChunk(c);
+            c = n;
+            i = 0;
+            return;
+        }
+        Chunk *b = c->prec;
+        if (b != start && b->count + c->count <= Capacity / 2) {
+            relocate(&b->at(b->count), &c->at(0), c->count);
+            i += b->count;
+            b->count += c->count;
+            dropChunk(c);
+            c = b;
+        }
+        Chunk *n = c->succ;
+        if (n != start && c->count + n->count <= Capacity / 2) {
+            relocate(&c->at(c->count), &n->at(0), n->count);
+            c->count += n->count;
+            dropChunk(n);
+        }
+        if (i == c->count) {
+            c = c->succ;
+            i = 0;
+        }
+    }
+
+    void init() {
+        start = new Chunk;
+        start->succ = start->prec = start;
+        start->count = 0;
+        Size = 0;
+        finger = NULL;
+        finger_base = 0;
+    }
+
+    void copy(const LinkedList &c) {
+        for (Chunk *k = c.start->succ; k != c.start; k = k->succ)
+            for (int j = 0; j < k->count; ++j)
+                emplaceAt(start, 0, k->at(j));
+    }
+
+public:
+    class Iterator;
+
+    /**
+     * Constructs an empty linked list
+     */
+    LinkedList() {
+        init();
+    }
+
+    /**
+     * Copy constructor
+     */
+    LinkedList(const LinkedList &c) {
+        init();
+        copy(c);
+    }
+
+    /**
+     * Assignment operator
+     */
+    LinkedList& operator=(const LinkedList &c) {
+        if (this == &c) return *this;
+        makeEmpty();
+        copy(c);
+        return *this;
+    }
+
+    /**
+     * Move constructor
+     * The chunks of c are taken over, c is left empty.
+     */
+    LinkedList(LinkedList &&c) {
+        init();
+        swap(c);
+    }
+
+    /**
+     * Move assignment operator
+     * c is left empty.
+     */
+    LinkedList& operator=(LinkedList &&c) {
+        if (this != &c) {
+            makeEmpty();
+            swap(c);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the elements of this list and c.
+     */
+    void swap(LinkedList &c) {
+        std::swap(start, c.start);
+        std::swap(Size, c.Size);
+        std::swap(finger, c.finger);
+        std::swap(finger_base, c.finger_base);
+        alloc.swap(c.alloc);
+    }
+
+    /**
+     * Destructor
+     */
+    ~LinkedList() {
+        makeEmpty();
+        delete start;
+    }
+
+    /**
+     * Appends the specified element to the end of this list.
+     * Always returns true.
+     */
+    bool add(const T& e) {
+        emplaceAt(start, 0, e);
+        return true;
+    }
+
+    bool add(T&& e) {
+        emplaceAt(start, 0, std::move(e));
+        return true;
+    }
+
+    /**
+     * Appends an element made from args to the end of this list.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        emplaceAt(start, 0, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Inserts the specified element to the beginning of this list.
+     */
+    void addFirst(const T& elem) {
+        emplaceAt(start->succ, 0, elem);
+    }
+
+    void addFirst(T&& elem) {
+        emplaceAt(start->succ, 0, std::move(elem));
+    }
+
+    template <class... Args>
+    void emplaceFirst(Args&&... args) {
+        emplaceAt(start->succ, 0, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Insert the specified element to the end of this list.
+     */
+    void addLast(const T &elem) {
+        emplaceAt(start, 0, elem);
+    }
+
+    void addLast(T &&elem) {
+        emplaceAt(start, 0, std::move(elem));
+    }
+
+    template <class... Args>
+    void emplaceLast(Args&&... args) {
+        emplaceAt(start, 0, std::forward<Args>(args)...);
+    }
+
+    /**
+     * Inserts the specified element to the specified position in this list.
+     * The range of index parameter is [0, Size].
+     * @throw IndexOutOfBound
+     */
+    void add(int index, const T& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        emplaceAt(c, index, element);
+    }
+
+    void add(int index, T&& element) {
+        if (index < 0 || index > Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        emplaceAt(c, index, std::move(element));
+    }
+
+    /**
+     * Removes all of the elements from this list.
+     */
+    void clear() {
+        makeEmpty();
+    }
+
+    /**
+     * Returns true if this list contains the specified element.
+     */
+    bool contains(const T& e) const {
+        for (Chunk *c = start->succ; c != start; c = c->succ)
+            if (Search<T>::indexOf(&c->at(0), c->count, e) >= 0) return true;
+        return false;
+    }
+
+    /**
+     * Returns a const reference to the element at the specified position in this list.
+     * It moves the finger, as LinkedList::get does, so it must not be called
+     * from two threads at once.
+     * @throw IndexOutOfBound
+     */
+    const T& get(int index) const {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        return c->at(index);
+    }
+
+    /**
+     * Returns a const reference to the first element.
+     * @throw ElementNotExist
+     */
+    const T& getFirst() const {
+        if (Size == 0) throw ElementNotExist();
+        return start->succ->at(0);
+    }
+
+    /**
+     * Returns a const reference to the last element.
+     * @throw ElementNotExist
+     */
+    const T& getLast() const {
+        if (Size == 0) throw ElementNotExist();
+        return start->prec->at(start->prec->count - 1);
+    }
+
+    /**
+     * Returns true if this list contains no elements.
+     */
+    bool isEmpty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Removes the element at the specified position in this list.
+     * @throw IndexOutOfBound
+     */
+    void removeIndex(int index) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        eraseAt(c, index);
+    }
+
+    /**
+     * Removes the first occurrence of the specified element from this list, if it is present.
+     * Returns true if it was present in the list, otherwise false.
+     */
+    bool remove(const T &e) {
+        for (Chunk *c = start->succ; c != start; c = c->succ) {
+            int i = Search<T>::indexOf(&c->at(0), c->count, e);
+            if (i >= 0) {
+                eraseAt(c, i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * Removes the first element from this list.
+     * @throw ElementNotExist
+     */
+    void removeFirst() {
+        if (Size == 0) throw ElementNotExist();
+        Chunk *c = start->succ;
+        int i = 0;
+        eraseAt(c, i);
+    }
+
+    /**
+     * Removes the last element from this list.
+     * @throw ElementNotExist
+     */
+    void removeLast() {
+        if (Size == 0) throw ElementNotExist();
+        Chunk *c = start->prec;
+        int i = c->count - 1;
+        eraseAt(c, i);
+    }
+
+    /**
+     * Replaces the element at the specified position in this list with the specified element.
+     * @throw IndexOutOfBound
+     */
+    void set(int index, const T &element) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        c->at(index) = element;
+    }
+
+    void set(int index, T &&element) {
+        if (index < 0 || index >= Size) throw IndexOutOfBound();
+        Chunk *c = locate(index);
+        c->at(index) = std::move(element);
+    }
+
+    /**
+     * Returns the number of elements in this list.
+     */
+    int size() const {
+        return Size;
+    }
+
+    /**
+     * Returns an iterator over the elements in this list.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    class Iterator
+    {
+        /*
+         * @var c, i the element next() returns next (c is start at the end)
+         * @var last, last_i the element next() returned last (last is NULL before the first call)
+         */
+        Chunk *c, *last;
+        int i, last_i;
+        LinkedList *container;
+        bool dead;
+    public:
+
+        Iterator() {}
+        Iterator(LinkedList *con): c(con->start->succ), last(NULL), i(0), last_i(0), container(con), dead(false) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return c != container->start;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const T &next() {
+            if (!hasNext()) throw ElementNotExist();
+            dead = false;
+            last = c;
+            last_i = i;
+            if (++i == c->count) {
+                c = c->succ;
+                i = 0;
+            }
+            return last->at(last_i);
+        }
+
+        /**
+         * Removes from the underlying collection the last element
+         * returned by the iterator.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (last == NULL || dead) throw ElementNotExist();
+            dead = true;
+            container->eraseAt(last, last_i);
+            c = last;
+            i = last_i;
+        }
+    };
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include "ArrayList.h"
 #include "ElementNotExist.h"
 
+#include <utility>
+
 /**
  * This is a priority queue based on a priority priority queue. The
  * elements of the priority queue are ordered according to their 
@@ -15,6 +17,33 @@
  * The iterator does not return the elements in any particular order.
  * But it is required that the iterator will eventually return every
  * element in this queue (even if removals are performed).
+ *
+ * With the default layout, push() returns a Handle to the new element, which stays
+ * valid until the element leaves the queue (by pop, erase, Iterator::remove or
+ * clear) and follows it when the queue is moved or swapped. update, decreaseKey,
+ * increaseKey and erase reach the element through its handle in O(log n):
+ * @code
+ *      PriorityQueue<int>::Handle h = queue.push(10);
+ *      queue.decreaseKey(h, 3);
+ * @endcode
+ *
+ * meld(std::move(other)) moves all the elements of another queue into this one,
+ * without copying them, and the constructor from a range of queues melds them all.
+ * PairingHeap melds in O(1); the array heaps append and heapify in O(n).
+ * pushAll adds a batch of elements, heapifying them with the rest when there are
+ * many; topK(k) copies and popK(k, out) removes the k least elements in order.
+ *
+ * Template argument P chooses the layout. NodeHeap, the default, is a binary heap
+ * of pointers to nodes, one node per element, which are also linked in a list for
+ * the iterator. DaryHeap<D> (see PriorityQueueDary.h) is an implicit D-ary heap
+ * (4-ary by default) which keeps the elements themselves in one array, so push and
+ * pop touch only contiguous memory:
+ * @code
+ *      PriorityQueue<int, Less<int>, DaryHeap<> > queue;
+ * @endcode
+ * PairingHeap (see PriorityQueuePairing.h) is a pairing heap, with O(1) push,
+ * decreaseKey and meld; it returns handles like NodeHeap. RadixHeap (see PriorityQueueRadix.h)
+ * holds unsigned integers which are popped in increasing order, as a radix heap.
  */
 
 /*----------------------------------------------------------------------*/
@@ -63,7 +92,32 @@ public:
 
 /*----------------------------------------------------------------------*/
 
-template <class V, class C = Less<V> >
+/*
+ * A place in a heap, with the element found there: topK walks the top of a heap
+ * with a small queue of these, ordered by their elements (SlotLess)
+ */
+template <class V, class X>
+struct HeapSlot {
+    const V *v;
+    X at;
+    HeapSlot() {}
+    HeapSlot(const V *v, X at): v(v), at(at) {}
+};
+
+template <class S, class C>
+class SlotLess
+{
+    C cmp;
+public:
+    bool operator()(const S &a, const S &b) { return cmp(*a.v, *b.v); }
+};
+
+class NodeHeap {};
+template <int D = 4> class DaryHeap {};
+class PairingHeap {};
+class RadixHeap {};
+
+template <class V, class C = Less<V>, class P = NodeHeap>
 class PriorityQueue
 {
 private:
@@ -77,7 +131,8 @@ private:
         V v;
         int to;
         Node():prev(NULL), succ(NULL) {}
-        Node(V _v, int t):v(_v), prev(NULL), succ(NULL), to(t) {}
+        template <class... Args>
+        Node(int t, Args&&... args):prev(NULL), succ(NULL), v(std::forward<Args>(args)...), to(t) {}
     };
     
     C cmp;
@@ -190,7 +245,111 @@ private:
         heapdown(Index);
     }
 
+    /*
+     * Move the nodes of x to the end of the heap, without ordering them; x is left empty
+     */
+    void take(PriorityQueue &x) {
+        if (&x == this || x.Size == 0) return;
+        while (save_size <= Size + x.Size) doubleSpace();
+        for (int i = 1; i <= x.Size; ++i) {
+            data[++Size] = x.data[i];
+            data[Size]->to = Size;
+        }
+        Node *first = x.begin->succ, *last = x.begin->prev, *Suc = begin->succ;
+        begin->succ = first; first->prev = begin;
+        last->succ = Suc; Suc->prev = last;
+        x.begin->succ = x.begin->prev = x.begin;
+        x.Size = 0;
+    }
+
+    /*
+     * Order data[from..Size], the heap before them being in order: one heapup
+     * each if they are fewer than the nodes before them, else the O(n) bottom-up
+     * heapify
+     */
+    void restore(int from) {
+        if (2 * (Size - from + 1) < Size) {
+            for (int i = from; i <= Size; ++i)
+                heapup(i);
+        } else {
+            for (int i = Size/2; i > 0; --i)
+                heapdown(i);
+        }
+    }
+
+    /*
+     * Delete data[1] bottom-up: the hole goes down along the least children to a
+     * leaf, and the last node fills it and moves up. When the queue is being
+     * drained the last node is seldom small, so this saves comparing it with the
+     * children at every level.
+     */
+    void removeFront() {
+        Node *now = data[1], *last = data[Size];
+        now->prev->succ = now->succ;
+        now->succ->prev = now->prev;
+        data[Size--] = NULL;
+        if (Size > 0) {
+            int x = 1;
+            for (int w; (w = x << 1) <= Size; x = w) {
+                if (w + 1 <= Size && cmp(data[w + 1]->v, data[w]->v)) ++w;
+                data[x] = data[w];
+                data[x]->to = x;
+            }
+            if (last != now) {
+                data[x] = last;
+                last->to = x;
+                heapup(x);
+            }
+        }
+        delete now;
+    }
+
+    /*
+     * Add a node made from args at the end of the heap, without ordering it
+     */
+    template <class... Args>
+    Node *append(Args&&... args) {
+        if (save_size <= Size + 1) doubleSpace();
+        Node *x = new Node(Size + 1, std::forward<Args>(args)...);
+        data[++Size] = x;
+        Node *Pre = begin, *Suc = begin->succ;
+        x->prev = Pre; Pre->succ = x;
+        x->succ = Suc; Suc->prev = x;
+        return x;
+    }
+
+    /*
+     * Put the heap positions of the k least elements into at, least first. Only
+     * the top of the heap is walked, through a queue of the children of the
+     * positions taken so far, in O(k log k) time.
+     */
+    void least(int k, ArrayList<int> &at) const {
+        typedef HeapSlot<V, int> S;
+        PriorityQueue<S, SlotLess<S, C>, DaryHeap<> > q;
+        if (k > 0 && Size > 0) q.push(S(&data[1]->v, 1));
+        while (at.size() < k && !q.empty()) {
+            int i = q.front().at;
+            q.pop();
+            at.add(i);
+            for (int c = 2 * i; c <= 2 * i + 1 && c <= Size; ++c)
+                q.push(S(&data[c]->v, c));
+        }
+    }
+
 public:
+    /**
+     * Names one element of the queue; a default-constructed Handle names none.
+     */
+    class Handle {
+        friend class PriorityQueue;
+        Node *node;
+        Handle(Node *x): node(x) {}
+    public:
+        Handle(): node(NULL) {}
+        bool operator==(const Handle &x) const { return node == x.node; }
+        bool operator!=(const Handle &x) const { return node != x.node; }
+    };
+
     class Iterator {
 
     PriorityQueue *container;
@@ -263,6 +422,7 @@ public:
      */
     PriorityQueue &operator=(const PriorityQueue &x) { 
         if (this != &x) {
+            removeAll();
             if (save_size != x.save_size) {
                 delete[] (data);
                 data = new Node*[save_size = x.save_size];
@@ -270,7 +430,7 @@ public:
            
             Size = x.Size; 
             for (int i = 1; i <= Size; ++i)
-                data[i] = new Node(x.data[i]->v, i);
+                data[i] = new Node(i, x.data[i]->v);
 
             SortedLink();
             cmp = x.cmp;
@@ -285,7 +445,7 @@ public:
         data = new Node*[save_size = x.save_size];
         Size = x.Size;
         for (int i = 1; i <= Size; ++i)
-            data[i] = new Node(x.data[i]->v, i);
+            data[i] = new Node(i, x.data[i]->v);
         begin = new Node;
         SortedLink();
         cmp = x.cmp;
@@ -303,7 +463,7 @@ public:
         while (save_size < Size + 1)save_size *= 2; 
         data = new Node*[save_size];
         for (int i = 1; i <= Size; ++i)
-            data[i] = new Node(x.get(i - 1), i);
+            data[i] = new Node(i, x.get(i - 1));
         begin = new Node;
         SortedLink();
 
@@ -311,6 +471,59 @@ public:
             heapdown(i);
     }
 
+    /**
+     * Constructs a priority queue over the elements of the queues in [first, last),
+     * which are left empty. The nodes move over (handles stay valid) and are
+     * heapified once, in O(n) time.
+     */
+    template <class It>
+    PriorityQueue(It first, It last) {
+        data = new Node*[save_size = 4];
+        Size = 0;
+        begin = new Node;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+        for (; first != last; ++first)
+            take(*first);
+        restore(1);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    PriorityQueue(PriorityQueue &&x) {
+        data = new Node*[save_size = 4];
+        Size = 0;
+        begin = new Node;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    PriorityQueue &operator=(PriorityQueue &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this priority queue and x.
+     */
+    void swap(PriorityQueue &x) {
+        std::swap(data, x.data);
+        std::swap(Size, x.Size);
+        std::swap(save_size, x.save_size);
+        std::swap(begin, x.begin);
+        std::swap(cmp, x.cmp);
+    }
+
     /**
      * TODO Returns an iterator over the elements in this priority queue.
      */
@@ -345,18 +558,101 @@ public:
 
     /**
      * TODO Add an element to the priority queue.
+     * Returns the handle of the new element.
      */
-    void push(const V &value) {
-        if (save_size <= Size + 1) doubleSpace();
-        ++Size;
-        data[Size] = new Node(value, Size);
-        /*
-        data[++Size] = new Node(value, Size);
-        */
-        Node *Pre = begin, *Suc = begin->succ;
-        data[Size]->prev = Pre; Pre->succ = data[Size];
-        data[Size]->succ = Suc; Suc->prev = data[Size];
+    Handle push(const V &value) {
+        return emplace(value);
+    }
+
+    Handle push(V &&value) {
+        return emplace(std::move(value));
+    }
+
+    /**
+     * Add an element made from args, built in place in its node.
+     */
+    template <class... Args>
+    Handle emplace(Args&&... args) {
+        Node *x = append(std::forward<Args>(args)...);
         heapup(Size);
+        return Handle(x);
+    }
+
+    /**
+     * Add the elements in [first, last). A batch at least as large as the heap
+     * already there is heapified with it in O(n) time, instead of one heapup per
+     * element.
+     */
+    template <class It>
+    void pushAll(It first, It last) {
+        int from = Size + 1;
+        for (; first != last; ++first)
+            append(*first);
+        restore(from);
+    }
+
+    /**
+     * Add the elements of x, as pushAll(first, last).
+     */
+    void pushAll(const ArrayList<V> &x) {
+        int from = Size + 1;
+        for (int i = 0; i < x.size(); ++i)
+            append(x.get(i));
+        restore(from);
+    }
+
+    /**
+     * Returns a const reference to the element named by h.
+     */
+    const V &get(Handle h) const {
+        return h.node->v;
+    }
+
+    /**
+     * Replace the element named by h with value, and move it up or down to its place.
+     */
+    void update(Handle h, const V &value) {
+        Node *x = h.node;
+        bool up = cmp(value, x->v);
+        x->v = value;
+        if (up) heapup(x->to);
+        else heapdown(x->to);
+    }
+
+    /**
+     * Replace the element named by h with value, which must not be greater than it.
+     * Only moves the element up.
+     */
+    void decreaseKey(Handle h, const V &value) {
+        h.node->v = value;
+        heapup(h.node->to);
+    }
+
+    /**
+     * Replace the element named by h with value, which must not be less than it.
+     * Only moves the element down.
+     */
+    void increaseKey(Handle h, const V &value) {
+        h.node->v = value;
+        heapdown(h.node->to);
+    }
+
+    /**
+     * Remove the element named by h; h is no longer valid.
+     */
+    void erase(Handle h) {
+        Delete(h.node->to);
+    }
+
+    /**
+     * Moves all the elements of x into this queue, and leaves x empty. The nodes
+     * move over, so the handles of x now name elements of this queue. Takes
+     * O(m log n) time for m elements of x if m is small, else O(n + m).
+     */
+    void meld(PriorityQueue &&x) {
+        int from = Size + 1;
+        take(x);
+        restore(from);
     }
 
     /**
@@ -369,6 +665,34 @@ public:
         Delete(1);
     }
 
+    /**
+     * Returns the k least elements (all of them if there are fewer), least
+     * first, in O(k log k) time.
+     */
+    ArrayList<V> topK(int k) const {
+        ArrayList<int> at;
+        least(k, at);
+        ArrayList<V> out;
+        out.reserve(at.size());
+        for (int i = 0; i < at.size(); ++i)
+            out.add(data[at.get(i)]->v);
+        return out;
+    }
+
+    /**
+     * Removes the k least elements (all of them if there are fewer) and adds
+     * them to out, least first. Each one is taken out bottom-up (see removeFront),
+     * with about half the comparisons of pop().
+     */
+    void popK(int k, ArrayList<V> &out) {
+        if (k > Size) k = Size;
+        out.reserve(out.size() + k);
+        for (int i = 0; i < k; ++i) {
+            out.add(std::move(data[1]->v));
+            removeFront();
+        }
+    }
+
     /**
      * TODO Returns the number of key-value mappings in this map.
      */
@@ -377,4 +701,8 @@ public:
     }
 };
 
+#include "PriorityQueueDary.h"
+#include "PriorityQueuePairing.h"
+#include "PriorityQueueRadix.h"
+
 #endif
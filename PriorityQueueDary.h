@@ -0,0 +1,524 @@
+/** @file */
+#ifndef __PRIORITYQUEUE_DARY_H
+#define __PRIORITYQUEUE_DARY_H
+
+#include "PriorityQueue.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+/**
+ * PriorityQueue with the DaryHeap<D> policy: an implicit D-ary heap.
+ *
+ * The elements live in one array, with no node per element: the children of
+ * data[i] are data[D * i + 1] .. data[D * i + D], and its parent is
+ * data[(i - 1) / D]. A wider node makes the heap shallower, so push compares less
+ * often, and pop scans the D children of each level, which sit side by side in
+ * memory. Like ArrayList, the array is raw memory and only the first size() slots
+ * hold constructed elements; the iterator walks the array itself.
+ *
+ * Iterator::remove() moves the last element into the hole and sifts it down, which
+ * only moves elements the iterator has not returned yet. If it belongs above the
+ * hole instead, the heap order is left broken there, and is restored in O(n) when
+ * the iterator reaches the end or is destroyed (or by the next push or pop). So
+ * front() and topK() only read the array, and a const queue may be shared
+ * between reader threads.
+ */
+template <class V, class C, int D>
+class PriorityQueue<V, C, DaryHeap<D> >
+{
+    static_assert(D >= 2, "a DaryHeap needs at least two children per node");
+
+    static const int Min_capacity = 4;
+    static const bool Trivial = std::is_trivially_copyable<V>::value;
+
+    C cmp;
+    V *data;
+    int Size, save_size;
+
+    /*
+     * Iterator::remove() broke the heap order (see heapify)
+     */
+    bool broken;
+
+    static void relocate(V *to, V *from, int n) {
+        if (Trivial) {
+            if (n > 0) std::memcpy((void *) to, (const void *) from, (size_t) n * sizeof(V));
+            return;
+        }
+        for (int i = 0; i < n; ++i) {
+            new (to + i) V(std::move(from[i]));
+            from[i].~V();
+        }
+    }
+
+    /*
+     * Change the length of data to n >= Size
+     */
+    void reallocate(int n) {
+        V *new_data = (V *) std::malloc((size_t) n * sizeof(V));
+        if (new_data == NULL) throw std::bad_alloc();
+        relocate(new_data, data, Size);
+        std::free(data);
+        data = new_data;
+        save_size = n;
+    }
+
+    void removeAll() {
+        if (!std::is_trivially_destructible<V>::value)
+            for (int i = 0; i < Size; ++i)
+                data[i].~V();
+        Size = 0;
+        broken = false;
+    }
+
+    /*
+     * Make this a copy of x, with no spare capacity
+     */
+    void copy(const PriorityQueue &x) {
+        Size = 0;
+        save_size = x.Size > Min_capacity ? x.Size : Min_capacity;
+        data = (V *) std::malloc((size_t) save_size * sizeof(V));
+        if (data == NULL) throw std::bad_alloc();
+        for (; Size < x.Size; ++Size)
+            new (data + Size) V(x.data[Size]);
+        broken = x.broken;
+        cmp = x.cmp;
+    }
+
+    /*
+     * Move data[i] up past its larger ancestors
+     */
+    void heapup(int i) {
+        if (i == 0) return;
+        V x(std::move(data[i]));
+        while (i > 0) {
+            int p = (i - 1) / D;
+            if (!cmp(x, data[p])) break;
+            data[i] = std::move(data[p]);
+            i = p;
+        }
+        data[i] = std::move(x);
+    }
+
+    /*
+     * Move data[i] down past its smaller descendants
+     */
+    void heapdown(int i) {
+        if (D * i + 1 >= Size) return;
+        V x(std::move(data[i]));
+        for (int c; (c = D * i + 1) < Size; ) {
+            int end = Size - c > D ? c + D : Size, w = c;
+            for (int k = c + 1; k < end; ++k)
+                if (cmp(data[k], data[w])) w = k;
+            if (!cmp(data[w], x)) break;
+            data[i] = std::move(data[w]);
+            i = w;
+        }
+        data[i] = std::move(x);
+    }
+
+    /*
+     * Delete data[0] bottom-up: the hole goes down along the least children to a
+     * leaf, and the last element fills it and moves up. When the queue is being
+     * drained the last element is seldom small, so this saves comparing it with
+     * the children at every level; pop() sifts down as usual, since after a push
+     * the last element is often near the top.
+     */
+    void removeFront() {
+        --Size;
+        int i = 0;
+        for (int c; (c = D * i + 1) < Size; ) {
+            int end = Size - c > D ? c + D : Size, w = c;
+            for (int k = c + 1; k < end; ++k)
+                if (cmp(data[k], data[w])) w = k;
+            data[i] = std::move(data[w]);
+            i = w;
+        }
+        if (i != Size) data[i] = std::move(data[Size]);
+        data[Size].~V();
+        if (i != Size) heapup(i);
+    }
+
+    /*
+     * Restore the heap order bottom-up, in O(n) time
+     */
+    void heapify() {
+        for (int i = (Size - 2) / D; i >= 0; --i)
+            heapdown(i);
+        broken = false;
+    }
+
+    void repair() {
+        if (broken) heapify();
+    }
+
+    /*
+     * Move the elements of x to the end of the array, without ordering them; x is
+     * left empty
+     */
+    void take(PriorityQueue &x) {
+        if (&x == this || x.Size == 0) return;
+        if (Size + x.Size > save_size) {
+            int n = save_size > Min_capacity ? save_size : Min_capacity;
+            while (n < Size + x.Size) n *= 2;
+            reallocate(n);
+        }
+        relocate(data + Size, x.data, x.Size);
+        Size += x.Size;
+        broken = broken || x.broken;
+        x.Size = 0;
+        x.broken = false;
+    }
+
+    /*
+     * Order data[from..Size-1], the heap before them being in order: one heapup
+     * each if they are fewer than the elements before them, else heapify
+     */
+    void restore(int from) {
+        if (!broken && 2 * (Size - from) < Size) {
+            for (int i = from; i < Size; ++i)
+                heapup(i);
+        } else {
+            heapify();
+        }
+    }
+
+    /*
+     * Add an element made from args at the end of the array, without ordering it.
+     * When the array is full the element is made before the others move, since
+     * args may refer to one of them.
+     */
+    template <class... Args>
+    void append(Args&&... args) {
+        if (Size == save_size) {
+            V e(std::forward<Args>(args)...);
+            reallocate(save_size * 2 > Min_capacity ? save_size * 2 : Min_capacity);
+            new (data + Size) V(std::move(e));
+        } else {
+            new (data + Size) V(std::forward<Args>(args)...);
+        }
+        ++Size;
+    }
+
+    /*
+     * Put the places of the k least elements into at, least first, walking only
+     * the top of the heap in O(k log k) time (the heap must be in order)
+     */
+    void least(int k, ArrayList<int> &at) const {
+        typedef HeapSlot<V, int> S;
+        PriorityQueue<S, SlotLess<S, C>, DaryHeap<> > q;
+        if (k > 0 && Size > 0) q.push(S(data, 0));
+        while (at.size() < k && !q.empty()) {
+            int i = q.front().at;
+            q.pop();
+            at.add(i);
+            for (int c = D * i + 1; c <= D * i + D && c < Size; ++c)
+                q.push(S(data + c, c));
+        }
+    }
+
+    /*
+     * Delete data[i] on behalf of Iterator::remove(): afterwards data[i] holds an
+     * element which has not been returned yet (or i == Size).
+     */
+    void removeAt(int i) {
+        --Size;
+        if (i != Size) data[i] = std::move(data[Size]);
+        data[Size].~V();
+        if (i == Size) return;
+        if (i > 0 && cmp(data[i], data[(i - 1) / D])) broken = true;
+        else heapdown(i);
+    }
+
+public:
+    class Iterator {
+
+    PriorityQueue *container;
+    int index;
+    bool dead;
+
+    /*
+     * remove() was called, so the heap may need repairing at the end
+     */
+    bool removed;
+
+    public:
+
+        Iterator(): container(NULL), removed(false) {}
+        Iterator(PriorityQueue *con): container(con), index(-1), dead(false), removed(false) {}
+
+        /**
+         * Restores the heap order if remove() broke it.
+         */
+        ~Iterator() {
+            if (removed) container->repair();
+        }
+
+        /**
+         * Returns true if the iteration has more elements. At the end, the heap
+         * order broken by remove() is restored.
+         */
+        bool hasNext() {
+            if (index + 1 < container->Size) return true;
+            if (removed) {
+                container->repair();
+                removed = false;
+            }
+            return false;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const V &next() {
+            if (!hasNext()) throw ElementNotExist();
+            if (dead) dead = false;
+            return container->data[++index];
+        }
+
+        /**
+         * Removes the last element returned by the iterator. The hole is filled
+         * from the end of the array as described above, so every element is
+         * still returned once. The queue must not be changed otherwise while
+         * the iteration is in progress, and until it ends front() and topK()
+         * may miss the least element.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (index < 0 || dead) throw ElementNotExist();
+            dead = true;
+            removed = true;
+            container->removeAt(index--);
+        }
+    };
+
+    /**
+     * Constructs an empty priority queue.
+     */
+    PriorityQueue(): data(NULL), Size(0), save_size(0), broken(false) {
+        cmp = C();
+    }
+
+    /**
+     * Destructor
+     */
+    ~PriorityQueue() {
+        removeAll();
+        std::free(data);
+    }
+
+    /**
+     * Assignment operator
+     */
+    PriorityQueue &operator=(const PriorityQueue &x) {
+        if (this != &x) {
+            PriorityQueue y(x);
+            swap(y);
+        }
+        return (*this);
+    }
+
+    /**
+     * Copy-constructor
+     * The array is copied as it is, in O(n) time.
+     */
+    PriorityQueue(const PriorityQueue &x) {
+        copy(x);
+    }
+
+    /**
+     * Constructs a priority queue over the elements of x, heapified in O(n) time.
+     */
+    PriorityQueue(const ArrayList<V> &x): data(NULL), Size(0), save_size(0), broken(false) {
+        cmp = C();
+        if (x.size() > 0) reallocate(x.size() > Min_capacity ? x.size() : Min_capacity);
+        for (; Size < x.size(); ++Size)
+            new (data + Size) V(x.get(Size));
+        heapify();
+    }
+
+    /**
+     * Constructs a priority queue over the elements of the queues in [first, last),
+     * which are left empty. The elements are moved and heapified once, in O(n) time.
+     */
+    template <class It>
+    PriorityQueue(It first, It last): data(NULL), Size(0), save_size(0), broken(false) {
+        cmp = C();
+        for (; first != last; ++first)
+            take(*first);
+        heapify();
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    PriorityQueue(PriorityQueue &&x): data(NULL), Size(0), save_size(0), broken(false) {
+        cmp = C();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    PriorityQueue &operator=(PriorityQueue &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this priority queue and x.
+     */
+    void swap(PriorityQueue &x) {
+        std::swap(data, x.data);
+        std::swap(Size, x.Size);
+        std::swap(save_size, x.save_size);
+        std::swap(broken, x.broken);
+        std::swap(cmp, x.cmp);
+    }
+
+    /**
+     * Returns an iterator over the elements in this priority queue, in no
+     * particular order.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the elements from this priority queue.
+     */
+    void clear() {
+        removeAll();
+    }
+
+    /**
+     * Returns a const reference to the least element.
+     * @throw ElementNotExist
+     */
+    const V &front() const {
+        if (Size == 0) throw ElementNotExist();
+        return data[0];
+    }
+
+    /**
+     * Returns true if this priority queue contains no elements.
+     */
+    bool empty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Adds an element, sifted up from the end of the array in O(log_D n) time.
+     */
+    void push(const V &value) {
+        emplace(value);
+    }
+
+    void push(V &&value) {
+        emplace(std::move(value));
+    }
+
+    /**
+     * Add an element made from args, built in place at the end of the array.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        repair();
+        append(std::forward<Args>(args)...);
+        heapup(Size - 1);
+    }
+
+    /**
+     * Add the elements in [first, last). A batch at least as large as the heap
+     * already there is heapified with it in O(n) time, instead of one heapup per
+     * element.
+     */
+    template <class It>
+    void pushAll(It first, It last) {
+        int from = Size;
+        for (; first != last; ++first)
+            append(*first);
+        restore(from);
+    }
+
+    /**
+     * Add the elements of x, as pushAll(first, last).
+     */
+    void pushAll(const ArrayList<V> &x) {
+        int from = Size;
+        for (int i = 0; i < x.size(); ++i)
+            append(x.get(i));
+        restore(from);
+    }
+
+    /**
+     * Moves all the elements of x into this queue, and leaves x empty. Takes
+     * O(m log n) time for m elements of x if m is small, else O(n + m).
+     */
+    void meld(PriorityQueue &&x) {
+        int from = Size;
+        take(x);
+        restore(from);
+    }
+
+    /**
+     * Removes the least element: the last element of the array takes its place
+     * and is sifted down, in O(D log_D n) time.
+     * @throw ElementNotExist
+     */
+    void pop() {
+        if (Size == 0) throw ElementNotExist();
+        repair();
+        --Size;
+        if (Size > 0) data[0] = std::move(data[Size]);
+        data[Size].~V();
+        heapdown(0);
+    }
+
+    /**
+     * Returns the k least elements (all of them if there are fewer), least
+     * first, in O(k log k) time.
+     */
+    ArrayList<V> topK(int k) const {
+        ArrayList<int> at;
+        least(k, at);
+        ArrayList<V> out;
+        out.reserve(at.size());
+        for (int i = 0; i < at.size(); ++i)
+            out.add(data[at.get(i)]);
+        return out;
+    }
+
+    /**
+     * Removes the k least elements (all of them if there are fewer) and adds
+     * them to out, least first. Each one is taken out bottom-up (see removeFront),
+     * with about half the comparisons of pop().
+     */
+    void popK(int k, ArrayList<V> &out) {
+        repair();
+        if (k > Size) k = Size;
+        out.reserve(out.size() + k);
+        for (int i = 0; i < k; ++i) {
+            out.add(std::move(data[0]));
+            removeFront();
+        }
+    }
+
+    /**
+     * Returns the number of elements in this priority queue.
+     */
+    int size() const {
+        return Size;
+    }
+};
+
+#endif
@@ -0,0 +1,504 @@
+/** @file */
+#ifndef __PRIORITYQUEUE_PAIRING_H
+#define __PRIORITYQUEUE_PAIRING_H
+
+#include "PriorityQueue.h"
+#include "SlabAllocator.h"
+
+#include <new>
+#include <type_traits>
+
+/**
+ * PriorityQueue with the PairingHeap policy: a pairing heap.
+ *
+ * The heap is a tree of nodes in which no child is less than its parent; each
+ * node keeps its children in a list (child, then next), and left points to the
+ * previous sibling, or to the parent for the first child. push links the new node
+ * with the root in O(1). pop merges the children of the root in two passes (pairs
+ * from the left, then the pairs from the right), in O(log n) amortized time.
+ * decreaseKey cuts the node's subtree off and links it with the root, in O(1)
+ * (o(log n) amortized), which suits decrease-key-heavy workloads. meld links the
+ * two roots, in O(1).
+ *
+ * push returns a Handle as with NodeHeap. The nodes are also in a circular list
+ * for the iterator, and come from a SlabAllocator owned by the queue.
+ */
+template <class V, class C>
+class PriorityQueue<V, C, PairingHeap>
+{
+private:
+    /*
+     * The list of all the nodes, through begin
+     */
+    struct Link {
+        Link *prev, *succ;
+    };
+
+    struct Node: Link {
+        V v;
+        Node *child, *next, *left;
+        template <class... Args>
+        Node(Args&&... args): v(std::forward<Args>(args)...), child(NULL), next(NULL), left(NULL) {}
+    };
+
+    C cmp;
+    Node *root;
+    Link *begin;
+    int Size;
+    SlabAllocator<Node> alloc;
+
+    void removeAll() {
+        Link *p = begin->succ;
+        begin->succ = begin->prev = begin;
+        if (!std::is_trivially_destructible<V>::value)
+            for (Link *q; p != begin; p = q) {
+                q = p->succ;
+                static_cast<Node *>(p)->~Node();
+            }
+        alloc.releaseAll();
+        root = NULL;
+        Size = 0;
+    }
+
+    /*
+     * Make x, a root, the first child of y, a root, or the other way round;
+     * returns the new root.
+     */
+    Node *link(Node *x, Node *y) {
+        if (cmp(y->v, x->v)) {
+            Node *z = x; x = y; y = z;
+        }
+        y->next = x->child;
+        if (x->child != NULL) x->child->left = y;
+        y->left = x;
+        x->child = y;
+        return x;
+    }
+
+    /*
+     * Merge the list of trees which starts at first, in two passes; returns the
+     * new root, or NULL if the list is empty.
+     */
+    Node *mergePairs(Node *first) {
+        if (first == NULL) return NULL;
+        Node *stack = NULL;
+        while (first != NULL) {
+            Node *a = first, *b = a->next;
+            if (b == NULL) {
+                a->next = stack;
+                stack = a;
+                break;
+            }
+            first = b->next;
+            a->next = b->next = NULL;
+            Node *m = link(a, b);
+            m->next = stack;
+            stack = m;
+        }
+        Node *r = stack;
+        stack = stack->next;
+        r->next = NULL;
+        while (stack != NULL) {
+            Node *s = stack->next;
+            stack->next = NULL;
+            r = link(stack, r);
+            stack = s;
+        }
+        r->left = NULL;
+        return r;
+    }
+
+    /*
+     * Take the subtree of x, which is not the root, out of its parent's children
+     */
+    void cut(Node *x) {
+        if (x->left->child == x) x->left->child = x->next;
+        else x->left->next = x->next;
+        if (x->next != NULL) x->next->left = x->left;
+        x->next = x->left = NULL;
+    }
+
+    /*
+     * Take x out of the tree, leaving its children in the heap
+     */
+    void detach(Node *x) {
+        if (x == root) {
+            root = mergePairs(x->child);
+        } else {
+            cut(x);
+            Node *r = mergePairs(x->child);
+            if (r != NULL) root = link(root, r);
+        }
+        x->child = NULL;
+    }
+
+    /*
+     * Put the tree of x, which has no siblings, into the heap
+     */
+    void attach(Node *x) {
+        root = root == NULL ? x : link(root, x);
+    }
+
+    /*
+     * Move the nodes of x, tree and list, into this queue; x is left empty
+     */
+    void take(PriorityQueue &x) {
+        if (&x == this || x.Size == 0) return;
+        Link *first = x.begin->succ, *last = x.begin->prev, *Suc = begin->succ;
+        begin->succ = first; first->prev = begin;
+        last->succ = Suc; Suc->prev = last;
+        x.begin->succ = x.begin->prev = x.begin;
+        attach(x.root);
+        Size += x.Size;
+        alloc.adopt(x.alloc);
+        x.root = NULL;
+        x.Size = 0;
+    }
+
+    void Delete(Node *x) {
+        detach(x);
+        x->prev->succ = x->succ;
+        x->succ->prev = x->prev;
+        x->~Node();
+        alloc.deallocate(x);
+        --Size;
+    }
+
+public:
+    /**
+     * Names one element of the queue; a default-constructed Handle names none.
+     */
+    class Handle {
+        friend class PriorityQueue;
+        Node *node;
+        Handle(Node *x): node(x) {}
+    public:
+        Handle(): node(NULL) {}
+        bool operator==(const Handle &x) const { return node == x.node; }
+        bool operator!=(const Handle &x) const { return node != x.node; }
+    };
+
+    class Iterator {
+
+    PriorityQueue *container;
+    Link *pos;
+    bool dead;
+
+    public:
+
+        Iterator() {}
+        Iterator(PriorityQueue *con): container(con), pos(con->begin), dead(false) {}
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return pos->succ != container->begin;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const V &next() {
+            if (!hasNext()) throw ElementNotExist();
+            if (dead) dead = false;
+            pos = pos->succ;
+            return static_cast<Node *>(pos)->v;
+        }
+
+        /**
+         * Removes the last element returned by the iterator, as erase() does
+         * with its handle. The queue must not be changed otherwise while the
+         * iteration is in progress.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (pos == container->begin || dead) throw ElementNotExist();
+            dead = true;
+            Link *p = pos->prev;
+            container->Delete(static_cast<Node *>(pos));
+            pos = p;
+        }
+    };
+
+    /**
+     * Constructs an empty priority queue.
+     */
+    PriorityQueue(): root(NULL), Size(0) {
+        begin = new Link;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+    }
+
+    /**
+     * Destructor
+     */
+    ~PriorityQueue() {
+        removeAll();
+        delete begin;
+    }
+
+    /**
+     * Assignment operator
+     */
+    PriorityQueue &operator=(const PriorityQueue &x) {
+        if (this != &x) {
+            PriorityQueue y(x);
+            swap(y);
+        }
+        return (*this);
+    }
+
+    /**
+     * Copy-constructor
+     * The copy is built by pushing, in O(n) time; its shape may differ.
+     */
+    PriorityQueue(const PriorityQueue &x): root(NULL), Size(0) {
+        begin = new Link;
+        begin->succ = begin->prev = begin;
+        cmp = x.cmp;
+        for (Link *p = x.begin->prev; p != x.begin; p = p->prev)
+            push(static_cast<Node *>(p)->v);
+    }
+
+    /**
+     * Constructs a priority queue over the elements of x, each pushed in O(1).
+     */
+    PriorityQueue(const ArrayList<V> &x): root(NULL), Size(0) {
+        begin = new Link;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+        for (int i = 0; i < x.size(); ++i)
+            push(x.get(i));
+    }
+
+    /**
+     * Constructs a priority queue over the elements of the queues in [first, last),
+     * which are left empty. Each one is melded in O(1).
+     */
+    template <class It>
+    PriorityQueue(It first, It last): root(NULL), Size(0) {
+        begin = new Link;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+        for (; first != last; ++first)
+            take(*first);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    PriorityQueue(PriorityQueue &&x): root(NULL), Size(0) {
+        begin = new Link;
+        begin->succ = begin->prev = begin;
+        cmp = C();
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    PriorityQueue &operator=(PriorityQueue &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this priority queue and x.
+     */
+    void swap(PriorityQueue &x) {
+        std::swap(root, x.root);
+        std::swap(begin, x.begin);
+        std::swap(Size, x.Size);
+        std::swap(cmp, x.cmp);
+        alloc.swap(x.alloc);
+    }
+
+    /**
+     * Returns an iterator over the elements in this priority queue, in no
+     * particular order.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the elements from this priority queue.
+     */
+    void clear() {
+        removeAll();
+    }
+
+    /**
+     * Returns a const reference to the least element, the root.
+     * @throw ElementNotExist
+     */
+    const V &front() const {
+        if (Size == 0) throw ElementNotExist();
+        return root->v;
+    }
+
+    /**
+     * Returns true if this priority queue contains no elements.
+     */
+    bool empty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Adds an element, linked with the root in O(1) time.
+     * Returns the handle of the new element.
+     */
+    Handle push(const V &value) {
+        return emplace(value);
+    }
+
+    Handle push(V &&value) {
+        return emplace(std::move(value));
+    }
+
+    /**
+     * Add an element made from args, built in place in its node.
+     */
+    template <class... Args>
+    Handle emplace(Args&&... args) {
+        Node *x = new (alloc.allocate()) Node(std::forward<Args>(args)...);
+        Link *Suc = begin->succ;
+        x->prev = begin; begin->succ = x;
+        x->succ = Suc; Suc->prev = x;
+        ++Size;
+        attach(x);
+        return Handle(x);
+    }
+
+    /**
+     * Add the elements in [first, last), each in O(1) time.
+     */
+    template <class It>
+    void pushAll(It first, It last) {
+        for (; first != last; ++first)
+            push(*first);
+    }
+
+    /**
+     * Add the elements of x, as pushAll(first, last).
+     */
+    void pushAll(const ArrayList<V> &x) {
+        for (int i = 0; i < x.size(); ++i)
+            push(x.get(i));
+    }
+
+    /**
+     * Returns a const reference to the element named by h.
+     */
+    const V &get(Handle h) const {
+        return h.node->v;
+    }
+
+    /**
+     * Replace the element named by h with value, and move it to its place.
+     */
+    void update(Handle h, const V &value) {
+        if (cmp(value, h.node->v)) decreaseKey(h, value);
+        else increaseKey(h, value);
+    }
+
+    /**
+     * Replace the element named by h with value, which must not be greater than it.
+     * The node's subtree is cut off and linked with the root.
+     */
+    void decreaseKey(Handle h, const V &value) {
+        Node *x = h.node;
+        x->v = value;
+        if (x == root) return;
+        cut(x);
+        root = link(root, x);
+    }
+
+    /**
+     * Replace the element named by h with value, which must not be less than it.
+     * The node leaves the tree, its children are merged, and it goes back in.
+     */
+    void increaseKey(Handle h, const V &value) {
+        Node *x = h.node;
+        detach(x);
+        x->v = value;
+        attach(x);
+    }
+
+    /**
+     * Remove the element named by h; h is no longer valid.
+     */
+    void erase(Handle h) {
+        Delete(h.node);
+    }
+
+    /**
+     * Moves all the elements of x into this queue in O(1) time, and leaves x
+     * empty: the two roots are linked, and the nodes and the memory of x's
+     * allocator come over, so the handles of x now name elements of this queue.
+     */
+    void meld(PriorityQueue &&x) {
+        take(x);
+    }
+
+    /**
+     * Removes the least element: the children of the root are merged in two
+     * passes, in O(log n) amortized time.
+     * @throw ElementNotExist
+     */
+    void pop() {
+        if (Size == 0) throw ElementNotExist();
+        Delete(root);
+    }
+
+    /**
+     * Returns the k least elements (all of them if there are fewer), least
+     * first. The heap is not changed: the tree is walked from the root through
+     * a small queue of the children of the nodes taken so far (see HeapSlot),
+     * in O(k log k) time plus the number of those children.
+     */
+    ArrayList<V> topK(int k) const {
+        typedef HeapSlot<V, const Node *> S;
+        PriorityQueue<S, SlotLess<S, C>, DaryHeap<> > q;
+        ArrayList<S> children;
+        ArrayList<V> out;
+        if (k > 0 && root != NULL) q.push(S(&root->v, root));
+        while (out.size() < k && !q.empty()) {
+            const Node *x = q.front().at;
+            q.pop();
+            out.add(x->v);
+            children.clear();
+            for (const Node *c = x->child; c != NULL; c = c->next)
+                children.add(S(&c->v, c));
+            q.pushAll(children);
+        }
+        return out;
+    }
+
+    /**
+     * Removes the k least elements (all of them if there are fewer) and adds
+     * them to out, least first.
+     */
+    void popK(int k, ArrayList<V> &out) {
+        for (; k > 0 && Size > 0; --k) {
+            out.add(std::move(root->v));
+            Delete(root);
+        }
+    }
+
+    /**
+     * Returns the number of elements in this priority queue.
+     */
+    int size() const {
+        return Size;
+    }
+};
+
+#endif
@@ -0,0 +1,377 @@
+/** @file */
+#ifndef __PRIORITYQUEUE_RADIX_H
+#define __PRIORITYQUEUE_RADIX_H
+
+#include "PriorityQueue.h"
+
+#include <type_traits>
+
+/**
+ * PriorityQueue with the RadixHeap policy: a radix heap of unsigned integers.
+ *
+ * V must be an unsigned integer type and the order is that of the values; C is
+ * not used. The heap suits monotone use, where no element pushed is less than the
+ * last one popped, as in Dijkstra with integer lengths or an event simulator.
+ *
+ * last is the least element of the queue. An element x is kept in bucket 0 if
+ * x == last, else in bucket b, where b - 1 is the highest bit in which x and last
+ * differ; so bucket b only holds elements less than last + 2^b. When a pop or
+ * Iterator::remove() empties bucket 0, the least element of the first non-empty
+ * bucket becomes last, and the elements of that bucket move to lower buckets.
+ * So bucket 0 is never empty unless the queue is, and front() and topK() only
+ * read the buckets. An element moves down at most once per bit, so push is O(1)
+ * and pop is O(log U) amortized, U being the range of the elements. Pushing an
+ * element below last is allowed, but costs a rebuild of all the buckets in O(n)
+ * time.
+ *
+ * The buckets are ArrayLists; the iterator walks them in turn.
+ */
+template <class V, class C>
+class PriorityQueue<V, C, RadixHeap>
+{
+    static_assert(std::is_unsigned<V>::value, "a RadixHeap holds unsigned integers");
+
+    static const int Bits = sizeof(V) * 8;
+
+    ArrayList<V> bucket[Bits + 1];
+    V last;
+    int Size;
+
+    int bucketOf(V x) const {
+        if (x == last) return 0;
+        return 64 - __builtin_clzll((unsigned long long) (x ^ last));
+    }
+
+    /*
+     * Refill bucket 0 from the next non-empty bucket, after a removal emptied it
+     */
+    void settle() {
+        if (Size == 0 || bucket[0].size() > 0) return;
+        int b = 1;
+        while (bucket[b].size() == 0) ++b;
+        ArrayList<V> &a = bucket[b];
+        last = a.get(0);
+        for (int i = 1; i < a.size(); ++i)
+            if (a.get(i) < last) last = a.get(i);
+        for (int i = 0; i < a.size(); ++i)
+            bucket[bucketOf(a.get(i))].add(a.get(i));
+        a.clear();
+    }
+
+    /*
+     * Put every element into its bucket again, for a new value of last
+     */
+    void rebucket(V x) {
+        ArrayList<V> all;
+        all.reserve(Size);
+        for (int b = 0; b <= Bits; ++b) {
+            for (int i = 0; i < bucket[b].size(); ++i)
+                all.add(bucket[b].get(i));
+            bucket[b].clear();
+        }
+        last = x;
+        for (int i = 0; i < all.size(); ++i)
+            bucket[bucketOf(all.get(i))].add(all.get(i));
+    }
+
+    /*
+     * Push the elements of x; x is left empty
+     */
+    void take(PriorityQueue &x) {
+        if (&x == this) return;
+        for (int b = 0; b <= Bits; ++b) {
+            for (int i = 0; i < x.bucket[b].size(); ++i)
+                push(x.bucket[b].get(i));
+            x.bucket[b].clear();
+        }
+        x.Size = 0;
+    }
+
+public:
+    class Iterator {
+
+    PriorityQueue *container;
+    int b, index;
+    bool dead;
+
+    /*
+     * Move (b, index) on to the next element, if any
+     */
+    void skip() {
+        while (b <= Bits && index >= container->bucket[b].size()) {
+            ++b;
+            index = 0;
+        }
+    }
+
+    public:
+
+        Iterator() {}
+        Iterator(PriorityQueue *con): container(con), b(0), index(0), dead(true) {
+            skip();
+        }
+
+        /**
+         * Returns true if the iteration has more elements.
+         */
+        bool hasNext() {
+            return b <= Bits;
+        }
+
+        /**
+         * Returns the next element in the iteration.
+         * @throw ElementNotExist exception when hasNext() == false
+         */
+        const V &next() {
+            if (!hasNext()) throw ElementNotExist();
+            dead = false;
+            const V &x = container->bucket[b].get(index);
+            ++index;
+            skip();
+            return x;
+        }
+
+        /**
+         * Removes the last element returned by the iterator.
+         * The last element of its bucket takes its place, and is returned next.
+         * If that empties bucket 0, the next bucket moves down (see settle);
+         * the iterator is then at the start of bucket 0, so it goes on over
+         * those elements, none of which has been returned yet.
+         * @throw ElementNotExist
+         */
+        void remove() {
+            if (dead) throw ElementNotExist();
+            dead = true;
+            if (index == 0) {
+                do --b; while (container->bucket[b].size() == 0);
+                index = container->bucket[b].size();
+            }
+            ArrayList<V> &a = container->bucket[b];
+            --index;
+            a.set(index, a.get(a.size() - 1));
+            a.removeIndex(a.size() - 1);
+            --container->Size;
+            container->settle();
+            skip();
+        }
+    };
+
+    /**
+     * Constructs an empty priority queue.
+     */
+    PriorityQueue(): last(0), Size(0) {}
+
+    /**
+     * Destructor
+     */
+    ~PriorityQueue() {}
+
+    /**
+     * Assignment operator
+     */
+    PriorityQueue &operator=(const PriorityQueue &x) {
+        if (this != &x) {
+            for (int b = 0; b <= Bits; ++b)
+                bucket[b] = x.bucket[b];
+            last = x.last;
+            Size = x.Size;
+        }
+        return (*this);
+    }
+
+    /**
+     * Copy-constructor
+     */
+    PriorityQueue(const PriorityQueue &x): last(x.last), Size(x.Size) {
+        for (int b = 0; b <= Bits; ++b)
+            bucket[b] = x.bucket[b];
+    }
+
+    /**
+     * Constructs a priority queue over the elements of x, with last set to
+     * their least, in O(n) time.
+     */
+    PriorityQueue(const ArrayList<V> &x): last(0), Size(x.size()) {
+        if (Size == 0) return;
+        last = x.get(0);
+        for (int i = 1; i < Size; ++i)
+            if (x.get(i) < last) last = x.get(i);
+        for (int i = 0; i < Size; ++i)
+            bucket[bucketOf(x.get(i))].add(x.get(i));
+    }
+
+    /**
+     * Constructs a priority queue over the elements of the queues in [first, last),
+     * which are left empty.
+     */
+    template <class It>
+    PriorityQueue(It first, It last): last(0), Size(0) {
+        for (; first != last; ++first)
+            take(*first);
+    }
+
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    PriorityQueue(PriorityQueue &&x): last(0), Size(0) {
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    PriorityQueue &operator=(PriorityQueue &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return (*this);
+    }
+
+    /**
+     * Exchanges the elements of this priority queue and x.
+     */
+    void swap(PriorityQueue &x) {
+        for (int b = 0; b <= Bits; ++b)
+            bucket[b].swap(x.bucket[b]);
+        std::swap(last, x.last);
+        std::swap(Size, x.Size);
+    }
+
+    /**
+     * Returns an iterator over the elements in this priority queue, in no
+     * particular order.
+     */
+    Iterator iterator() {
+        return Iterator(this);
+    }
+
+    /**
+     * Removes all of the elements from this priority queue.
+     */
+    void clear() {
+        for (int b = 0; b <= Bits; ++b)
+            bucket[b].clear();
+        Size = 0;
+    }
+
+    /**
+     * Returns a const reference to the least element, the first of bucket 0.
+     * @throw ElementNotExist
+     */
+    const V &front() const {
+        if (Size == 0) throw ElementNotExist();
+        return bucket[0].get(0);
+    }
+
+    /**
+     * Returns true if this priority queue contains no elements.
+     */
+    bool empty() const {
+        return Size == 0;
+    }
+
+    /**
+     * Adds an element to its bucket in O(1) time, or in O(n) if it is less
+     * than last. The first element of an empty queue becomes last.
+     */
+    void push(V value) {
+        if (Size == 0) last = value;
+        else if (value < last) rebucket(value);
+        bucket[bucketOf(value)].add(value);
+        ++Size;
+    }
+
+    /**
+     * Adds an element made from args, as push() does.
+     */
+    template <class... Args>
+    void emplace(Args&&... args) {
+        push(V(std::forward<Args>(args)...));
+    }
+
+    /**
+     * Moves all the elements of x into this queue, and leaves x empty. Each one is
+     * pushed, in O(1) time unless it is below last.
+     */
+    void meld(PriorityQueue &&x) {
+        take(x);
+    }
+
+    /**
+     * Add the elements in [first, last), each in O(1) time unless it is below last.
+     */
+    template <class It>
+    void pushAll(It first, It last) {
+        for (; first != last; ++first)
+            push(*first);
+    }
+
+    /**
+     * Add the elements of x, as pushAll(first, last).
+     */
+    void pushAll(const ArrayList<V> &x) {
+        for (int i = 0; i < x.size(); ++i)
+            push(x.get(i));
+    }
+
+    /**
+     * Removes the least element, from bucket 0, and refills bucket 0 if that
+     * emptied it.
+     * @throw ElementNotExist
+     */
+    void pop() {
+        if (Size == 0) throw ElementNotExist();
+        bucket[0].removeIndex(bucket[0].size() - 1);
+        --Size;
+        settle();
+    }
+
+    /**
+     * Returns the k least elements (all of them if there are fewer), least
+     * first. Every element of a bucket is less than those of the next one, so
+     * whole buckets are copied, and only the bucket where the k-th element falls
+     * is heapified to pick the rest.
+     */
+    ArrayList<V> topK(int k) const {
+        ArrayList<V> out;
+        int b = 0;
+        for (; b <= Bits && out.size() + bucket[b].size() <= k; ++b) {
+            if (b == 0) {
+                out.addAll(bucket[0]);
+                continue;
+            }
+            PriorityQueue<V, Less<V>, DaryHeap<> > q(bucket[b]);
+            q.popK(bucket[b].size(), out);
+        }
+        if (b <= Bits && out.size() < k) {
+            PriorityQueue<V, Less<V>, DaryHeap<> > q(bucket[b]);
+            q.popK(k - out.size(), out);
+        }
+        return out;
+    }
+
+    /**
+     * Removes the k least elements (all of them if there are fewer) and adds
+     * them to out, least first.
+     */
+    void popK(int k, ArrayList<V> &out) {
+        for (; k > 0 && Size > 0; --k) {
+            out.add(bucket[0].get(bucket[0].size() - 1));
+            bucket[0].removeIndex(bucket[0].size() - 1);
+            --Size;
+            settle();
+        }
+    }
+
+    /**
+     * Returns the number of elements in this priority queue.
+     */
+    int size() const {
+        return Size;
+    }
+};
+
+#endif
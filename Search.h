@@ -0,0 +1,297 @@
+/** @file */
+#ifndef __SEARCH_H
+#define __SEARCH_H
+
+#include <cstring>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SEARCH_AVX2
+#endif
+#endif
+
+/**
+ * Linear search kernels for the array-backed containers.
+ * @code
+ *      Search<T>::indexOf(a, n, x)       the first i < n with a[i] == x, or -1
+ *      Search<T>::lastIndexOf(a, n, x)   the last such i, or -1
+ *      Search<T>::count(a, n, x)         the number of such i
+ * @endcode
+ * For an arithmetic T of 1, 2, 4 or 8 bytes, Search<T> compares 16 bytes at once
+ * with SSE2, or 32 bytes with AVX2 if the processor has it (checked once, at the
+ * first call). Floating point elements are compared as numbers, exactly like
+ * operator== (0.0 == -0.0, NaN matches nothing). Any other T, or a build without
+ * SSE2, gets the plain loop with operator==.
+ */
+template <class T>
+struct SearchLaneKind {
+    /*
+     * n for an integer of n bytes, -n for a floating point of n bytes, 0 if no kernel fits
+     */
+    static const int value =
+        std::is_integral<T>::value && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)
+            ? (int) sizeof(T) :
+        std::is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)
+            ? -(int) sizeof(T) : 0;
+
+#ifdef __SSE2__
+    static const bool simd = value != 0;
+#else
+    static const bool simd = false;
+#endif
+};
+
+template <class T, bool Simd = SearchLaneKind<T>::simd>
+class Search {
+public:
+    static int indexOf(const T *a, int n, const T &x) {
+        for (int i = 0; i < n; ++i)
+            if (a[i] == x) return i;
+        return -1;
+    }
+
+    static int lastIndexOf(const T *a, int n, const T &x) {
+        for (int i = n - 1; i >= 0; --i)
+            if (a[i] == x) return i;
+        return -1;
+    }
+
+    static int count(const T *a, int n, const T &x) {
+        int c = 0;
+        for (int i = 0; i < n; ++i)
+            if (a[i] == x) ++c;
+        return c;
+    }
+};
+
+#ifdef __SSE2__
+
+/*
+ * SearchLanes<K> compares a block of elements of lane kind K (see SearchLaneKind)
+ * with a key. match() returns one bit per byte of the block, set for every byte
+ * of an equal element.
+ */
+template <int K> struct SearchLanes;
+
+/*
+ * The key as an L; it is copied out, since x points to the caller's T, which
+ * may be another type of the same size (long for long long, float for int...)
+ */
+template <class L>
+inline L searchKey(const void *x) {
+    L k;
+    std::memcpy(&k, x, sizeof(L));
+    return k;
+}
+
+template <> struct SearchLanes<1> {
+    static __m128i key(const void *x) { return _mm_set1_epi8(searchKey<char>(x)); }
+    static unsigned int match(const void *p, __m128i k) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) p), k));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_set1_epi8(searchKey<char>(x));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) p), k));
+    }
+#endif
+};
+
+template <> struct SearchLanes<2> {
+    static __m128i key(const void *x) { return _mm_set1_epi16(searchKey<short>(x)); }
+    static unsigned int match(const void *p, __m128i k) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) p), k));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_set1_epi16(searchKey<short>(x));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) p), k));
+    }
+#endif
+};
+
+template <> struct SearchLanes<4> {
+    static __m128i key(const void *x) { return _mm_set1_epi32(searchKey<int>(x)); }
+    static unsigned int match(const void *p, __m128i k) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) p), k));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_set1_epi32(searchKey<int>(x));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *) p), k));
+    }
+#endif
+};
+
+/*
+ * SSE2 has no 64-bit compare: a lane is equal if both of its halves are
+ */
+template <> struct SearchLanes<8> {
+    static __m128i key(const void *x) { return _mm_set1_epi64x(searchKey<long long>(x)); }
+    static unsigned int match(const void *p, __m128i k) {
+        __m128i e = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *) p), k);
+        return _mm_movemask_epi8(_mm_and_si128(e, _mm_shuffle_epi32(e, _MM_SHUFFLE(2, 3, 0, 1))));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_set1_epi64x(searchKey<long long>(x));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i *) p), k));
+    }
+#endif
+};
+
+template <> struct SearchLanes<-4> {
+    static __m128i key(const void *x) { return _mm_castps_si128(_mm_set1_ps(searchKey<float>(x))); }
+    static unsigned int match(const void *p, __m128i k) {
+        return _mm_movemask_epi8(_mm_castps_si128(
+                    _mm_cmpeq_ps(_mm_loadu_ps((const float *) p), _mm_castsi128_ps(k))));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_castps_si256(_mm256_set1_ps(searchKey<float>(x)));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_castps_si256(
+                    _mm256_cmp_ps(_mm256_loadu_ps((const float *) p), _mm256_castsi256_ps(k), _CMP_EQ_OQ)));
+    }
+#endif
+};
+
+template <> struct SearchLanes<-8> {
+    static __m128i key(const void *x) { return _mm_castpd_si128(_mm_set1_pd(searchKey<double>(x))); }
+    static unsigned int match(const void *p, __m128i k) {
+        return _mm_movemask_epi8(_mm_castpd_si128(
+                    _mm_cmpeq_pd(_mm_loadu_pd((const double *) p), _mm_castsi128_pd(k))));
+    }
+#ifdef SEARCH_AVX2
+    __attribute__((target("avx2"))) static __m256i key256(const void *x) {
+        return _mm256_castpd_si256(_mm256_set1_pd(searchKey<double>(x)));
+    }
+    __attribute__((target("avx2"))) static unsigned int match256(const void *p, __m256i k) {
+        return _mm256_movemask_epi8(_mm256_castpd_si256(
+                    _mm256_cmp_pd(_mm256_loadu_pd((const double *) p), _mm256_castsi256_pd(k), _CMP_EQ_OQ)));
+    }
+#endif
+};
+
+template <class T>
+class Search<T, true> {
+    typedef SearchLanes<SearchLaneKind<T>::value> Lanes;
+    typedef Search<T, false> Scalar;
+
+    /*
+     * The elements in one 16-byte block
+     */
+    static const int Block = 16 / sizeof(T);
+
+    static int lowest(unsigned int m) { return __builtin_ctz(m) / sizeof(T); }
+    static int highest(unsigned int m) { return (31 - __builtin_clz(m)) / sizeof(T); }
+    static int lanes(unsigned int m) { return __builtin_popcount(m) / sizeof(T); }
+
+public:
+    /*
+     * The 16-byte and 32-byte kernels, which the functions at the end choose
+     * from. They are public so that each can be checked against the plain loop;
+     * the 32-byte ones may only be called if hasAvx2().
+     */
+    static int indexOf128(const T *a, int n, const T &x) {
+        __m128i k = Lanes::key(&x);
+        int i = 0;
+        for (; i + Block <= n; i += Block) {
+            unsigned int m = Lanes::match(a + i, k);
+            if (m != 0) return i + lowest(m);
+        }
+        int r = Scalar::indexOf(a + i, n - i, x);
+        return r < 0 ? -1 : i + r;
+    }
+
+    static int lastIndexOf128(const T *a, int n, const T &x) {
+        __m128i k = Lanes::key(&x);
+        int i = n;
+        for (; i - Block >= 0; i -= Block) {
+            unsigned int m = Lanes::match(a + i - Block, k);
+            if (m != 0) return i - Block + highest(m);
+        }
+        return Scalar::lastIndexOf(a, i, x);
+    }
+
+    static int count128(const T *a, int n, const T &x) {
+        __m128i k = Lanes::key(&x);
+        int c = 0, i = 0;
+        for (; i + Block <= n; i += Block)
+            c += lanes(Lanes::match(a + i, k));
+        return c + Scalar::count(a + i, n - i, x);
+    }
+
+#ifdef SEARCH_AVX2
+    static bool hasAvx2() {
+        static const bool avx2 = __builtin_cpu_supports("avx2");
+        return avx2;
+    }
+
+    __attribute__((target("avx2"))) static int indexOf256(const T *a, int n, const T &x) {
+        __m256i k = Lanes::key256(&x);
+        int i = 0;
+        for (; i + 2 * Block <= n; i += 2 * Block) {
+            unsigned int m = Lanes::match256(a + i, k);
+            if (m != 0) return i + lowest(m);
+        }
+        int r = Scalar::indexOf(a + i, n - i, x);
+        return r < 0 ? -1 : i + r;
+    }
+
+    __attribute__((target("avx2"))) static int lastIndexOf256(const T *a, int n, const T &x) {
+        __m256i k = Lanes::key256(&x);
+        int i = n;
+        for (; i - 2 * Block >= 0; i -= 2 * Block) {
+            unsigned int m = Lanes::match256(a + i - 2 * Block, k);
+            if (m != 0) return i - 2 * Block + highest(m);
+        }
+        return Scalar::lastIndexOf(a, i, x);
+    }
+
+    __attribute__((target("avx2"))) static int count256(const T *a, int n, const T &x) {
+        __m256i k = Lanes::key256(&x);
+        int c = 0, i = 0;
+        for (; i + 2 * Block <= n; i += 2 * Block)
+            c += lanes(Lanes::match256(a + i, k));
+        return c + Scalar::count(a + i, n - i, x);
+    }
+#endif
+
+    static int indexOf(const T *a, int n, const T &x) {
+#ifdef SEARCH_AVX2
+        if (n >= 2 * Block && hasAvx2()) return indexOf256(a, n, x);
+#endif
+        return indexOf128(a, n, x);
+    }
+
+    static int lastIndexOf(const T *a, int n, const T &x) {
+#ifdef SEARCH_AVX2
+        if (n >= 2 * Block && hasAvx2()) return lastIndexOf256(a, n, x);
+#endif
+        return lastIndexOf128(a, n, x);
+    }
+
+    static int count(const T *a, int n, const T &x) {
+#ifdef SEARCH_AVX2
+        if (n >= 2 * Block && hasAvx2()) return count256(a, n, x);
+#endif
+        return count128(a, n, x);
+    }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+/** @file */
+#ifndef __SLABALLOCATOR_H
+#define __SLABALLOCATOR_H
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Allocators for the nodes of the containers.
+ *
+ * An allocator hands out raw memory for one T at a time; the container constructs
+ * and destroys the T itself (placement new and an explicit destructor call).
+ * @code
+ *      T *allocate();
+ *      void deallocate(T *p);
+ *      void releaseAll();
+ *      void swap(A &x);
+ *      void adopt(A &x);
+ *      void join(A &x);
+ *      bool joined(const A &x) const;
+ * @endcode
+ * releaseAll() gives back every cell allocated so far. If Releases_all is true it
+ * also returns the memory, so a container whose nodes need no destructor can drop
+ * all of them with one call instead of deallocating them one by one. It also means
+ * a cell belongs to the memory of the allocator which made it: a node can be handed
+ * to another container together with all that memory, which adopt() takes over,
+ * or after join(), which makes the two allocators share their memory, so that
+ * cells may be deallocated to either one; joined() tells if that is already so.
+ */
+
+/**
+ * NewAllocator takes every node from operator new.
+ */
+template <class T>
+class NewAllocator {
+public:
+    static const bool Releases_all = false;
+
+    T *allocate() {
+        return (T *) ::operator new(sizeof(T));
+    }
+
+    void deallocate(T *p) {
+        ::operator delete(p);
+    }
+
+    void releaseAll() {}
+
+    void swap(NewAllocator &) {}
+
+    void adopt(NewAllocator &) {}
+
+    void join(NewAllocator &) {}
+
+    bool joined(const NewAllocator &) const {
+        return true;
+    }
+};
+
+/**
+ * SlabAllocator cuts the nodes from slabs, and keeps the nodes given back in a
+ * free list. Each slab is twice as large as the last one (up to Max_cells), so a
+ * small container only owns a small slab.
+ *
+ * Every container owns its own SlabAllocator; it cannot be copied. After join(),
+ * the slabs of the two allocators are owned together through a Shared record
+ * counting its owners, and are only freed when the last one releases them.
+ */
+template <class T>
+class SlabAllocator {
+    union Cell {
+        Cell *next;
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type data;
+    };
+
+    static const int Min_cells = 16;
+    static const int Max_cells = 4096;
+
+    /*
+     * The slabs of joined allocators. Records are merged like the sets of a
+     * union-find: parent is the record which holds the slabs now, and owners
+     * counts the allocators and the records whose parent this is.
+     */
+    struct Shared {
+        Cell *slabs, *last;
+        Shared *parent;
+        int owners;
+    };
+
+    /*
+     * @var slabs, last the list of slabs, linked by the first cell of each slab,
+     *  and its last slab; if shared is not NULL, the slabs are in the root of
+     *  shared instead
+     * @var free_last the last cell of free_list, so that adopt() can append to it
+     * @var bump, bump_end the cells of the newest slab which have never been used
+     */
+    Cell *free_list, *free_last;
+    Cell *slabs, *last;
+    Cell *bump, *bump_end;
+    int next_cells;
+    Shared *shared;
+
+    SlabAllocator(const SlabAllocator &);
+    SlabAllocator &operator=(const SlabAllocator &);
+
+    void newSlab() {
+        Cell *s = (Cell *) ::operator new((next_cells + 1) * sizeof(Cell));
+        Cell *&head = shared == NULL ? slabs : root(shared)->slabs;
+        if (head == NULL) (shared == NULL ? last : root(shared)->last) = s;
+        s->next = head;
+        head = s;
+        bump = s + 1;
+        bump_end = bump + next_cells;
+        if (next_cells < Max_cells) next_cells *= 2;
+    }
+
+    static Shared *root(Shared *r) {
+        while (r->parent != NULL) r = r->parent;
+        return r;
+    }
+
+    static void freeSlabs(Cell *s) {
+        for (Cell *x; s != NULL; s = x) {
+            x = s->next;
+            ::operator delete(s);
+        }
+    }
+
+    /*
+     * Drop one owner of r, freeing the records and slabs left without any
+     */
+    static void release(Shared *r) {
+        while (r != NULL && --r->owners == 0) {
+            Shared *p = r->parent;
+            freeSlabs(r->slabs);
+            delete r;
+            r = p;
+        }
+    }
+
+    /*
+     * Link the list of slabs s, which ends at t, in front of the list head,
+     * which ends at tail; s is left empty. Both ends are known, so it takes
+     * O(1) time.
+     */
+    static void moveSlabs(Cell *&head, Cell *&tail, Cell *&s, Cell *&t) {
+        if (s == NULL) return;
+        t->next = head;
+        if (head == NULL) tail = t;
+        head = s;
+        s = t = NULL;
+    }
+
+public:
+    static const bool Releases_all = true;
+
+    SlabAllocator(): free_list(NULL), free_last(NULL), slabs(NULL), last(NULL), bump(NULL), bump_end(NULL),
+                     next_cells(Min_cells), shared(NULL) {}
+
+    ~SlabAllocator() {
+        releaseAll();
+    }
+
+    T *allocate() {
+        if (free_list != NULL) {
+            Cell *c = free_list;
+            free_list = c->next;
+            return (T *) c;
+        }
+        if (bump == bump_end) newSlab();
+        return (T *) bump++;
+    }
+
+    void deallocate(T *p) {
+        Cell *c = (Cell *) p;
+        if (free_list == NULL) free_last = c;
+        c->next = free_list;
+        free_list = c;
+    }
+
+    /*
+     * The slabs shared with joined allocators outlive this call until the last
+     * of them releases its cells too.
+     */
+    void releaseAll() {
+        freeSlabs(slabs);
+        release(shared);
+        free_list = free_last = slabs = last = bump = bump_end = NULL;
+        next_cells = Min_cells;
+        shared = NULL;
+    }
+
+    /*
+     * Exchange the cells of two allocators, with the containers which own them
+     */
+    void swap(SlabAllocator &x) {
+        std::swap(free_list, x.free_list);
+        std::swap(free_last, x.free_last);
+        std::swap(slabs, x.slabs);
+        std::swap(last, x.last);
+        std::swap(bump, x.bump);
+        std::swap(bump_end, x.bump_end);
+        std::swap(next_cells, x.next_cells);
+        std::swap(shared, x.shared);
+    }
+
+    /*
+     * Take over the slabs of x with all their cells, in use or not; x is left
+     * empty. The free list of x is appended to this one, and of the two runs
+     * of never used cells the shorter one goes to the free list too, so no
+     * cell is lost. That takes at most Max_cells steps, whatever the sizes.
+     */
+    void adopt(SlabAllocator &x) {
+        if (&x == this) return;
+        if (x.shared != NULL) join(x);
+        else if (shared != NULL) moveSlabs(root(shared)->slabs, root(shared)->last, x.slabs, x.last);
+        else moveSlabs(slabs, last, x.slabs, x.last);
+        if (x.free_list != NULL) {
+            x.free_last->next = free_list;
+            if (free_list == NULL) free_last = x.free_last;
+            free_list = x.free_list;
+        }
+        if (bump_end - bump < x.bump_end - x.bump) {
+            std::swap(bump, x.bump);
+            std::swap(bump_end, x.bump_end);
+        }
+        for (; x.bump != x.bump_end; ++x.bump) deallocate((T *) x.bump);
+        x.releaseAll();
+    }
+
+    /*
+     * Share the slabs of this allocator and x, so that a cell of either may be
+     * deallocated to the other. Each keeps its own free cells.
+     */
+    void join(SlabAllocator &x) {
+        if (&x == this) return;
+        if (shared == NULL) {
+            if (x.shared == NULL) {
+                x.shared = new Shared;
+                x.shared->slabs = x.shared->last = NULL;
+                x.shared->parent = NULL;
+                x.shared->owners = 1;
+            }
+            shared = root(x.shared);
+            ++shared->owners;
+            moveSlabs(shared->slabs, shared->last, slabs, last);
+            moveSlabs(shared->slabs, shared->last, x.slabs, x.last);
+            return;
+        }
+        if (x.shared == NULL) {
+            x.join(*this);
+            return;
+        }
+        Shared *a = root(shared), *b = root(x.shared);
+        if (a == b) return;
+        b->parent = a;
+        ++a->owners;
+        moveSlabs(a->slabs, a->last, b->slabs, b->last);
+    }
+
+    /*
+     * True if a cell of x may be deallocated to this allocator
+     */
+    bool joined(const SlabAllocator &x) const {
+        return &x == this || (shared != NULL && x.shared != NULL && root(shared) == root(x.shared));
+    }
+};
+
+#endif
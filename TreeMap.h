@@ -4,6 +4,8 @@
 
 #include "ElementNotExist.h"
 #include <cstdlib>
+#include <type_traits>
+#include <utility>
 
 /**
  * TreeMap is the balanced-tree implementation of map. The iterators must
@@ -31,7 +33,7 @@ private:
         if (y == NULL) {
             x = NULL; return;
         }
-        x = new Entry(y->key, y->value, y->heap);
+        x = new Entry(y->heap, y->key, y->value);
         copy(x->l, y->l);
         copy(x->r, y->r);
     }
@@ -68,24 +70,68 @@ private:
         if (x->r != NULL) cnt +=Travel(x->r);
     }
 
-    inline Entry* Insert(Entry* &x, const K &key, const V &value) {
+    /*
+     * Insert a new entry whose key is made from k and value from args
+     */
+    template <class KK, class... Args>
+    inline Entry* Insert(Entry* &x, KK &&k, Args&&... args) {
         if (x == NULL) {
-            x = new Entry(key, value);
+            x = new Entry(rand(), std::forward<KK>(k), std::forward<Args>(args)...);
             return x;
         }
         Entry *ans;
-        if (key < x->key) {
-            ans = Insert(x->l, key, value);
+        if (k < x->key) {
+            ans = Insert(x->l, std::forward<KK>(k), std::forward<Args>(args)...);
             if (x->l->heap > x->heap) rotate_r(x);
             return ans;
         } else {
-            ans = Insert(x->r, key, value);
+            ans = Insert(x->r, std::forward<KK>(k), std::forward<Args>(args)...);
             if (x->r->heap > x->heap) rotate_l(x);
             return ans;
         }
         return ans;
     }
 
+    /*
+     * A V is assigned as it is; anything else, as in putEmplace(key, args),
+     * makes a V to assign, so args need not be assignable to V
+     */
+    template <class U>
+    static typename std::enable_if<std::is_same<typename std::decay<U>::type, V>::value>::type
+    assignValue(V &v, U &&u) {
+        v = std::forward<U>(u);
+    }
+
+    template <class... Args>
+    static void assignValue(V &v, Args&&... args) {
+        v = V(std::forward<Args>(args)...);
+    }
+
+    /*
+     * Put a value made from args; a present value is assigned, an absent one
+     * is built in place in the new entry.
+     */
+    template <class KK, class... Args>
+    void putValue(KK &&key, Args&&... args) {
+        Entry *x = root;
+        while (x != NULL) {
+            if (x->key == key) {
+                assignValue(x->value, std::forward<Args>(args)...);
+                return;
+            }
+            if (key < x->key) x = x->l; else x = x->r;
+        }
+        ++Size;
+        x = Insert(root, std::forward<KK>(key), std::forward<Args>(args)...);
+        Entry *Pre = Find_min(x->key);
+        if (Pre == NULL) Pre = begin;
+        Entry *Suc = Pre->succ;
+        
+        x->prev = Pre; Pre->succ = x;
+        if (Suc != NULL)
+            x->succ = Suc, Suc->prev = x;
+    }
+
     inline void Delete(Entry* &x, const K &key) {
         if (x == NULL) return;
         if (x->l == NULL && x->r == NULL) {
@@ -161,6 +207,39 @@ public:
         buildrank(root, begin);
     }
 
+    /**
+     * Move-constructor
+     * x is left empty.
+     */
+    TreeMap(TreeMap &&x) {
+        root = NULL;
+        Size = 0;
+        begin = new Entry();
+        begin->prev = begin->succ = NULL;
+        swap(x);
+    }
+
+    /**
+     * Move assignment operator
+     * x is left empty.
+     */
+    TreeMap &operator=(TreeMap &&x) {
+        if (this != &x) {
+            clear();
+            swap(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the mappings of this map and x.
+     */
+    void swap(TreeMap &x) {
+        std::swap(root, x.root);
+        std::swap(begin, x.begin);
+        std::swap(Size, x.Size);
+    }
+
     /**
      * TODO Returns an iterator over the elements in this map.
      */
@@ -224,23 +303,29 @@ public:
      * TODO Associates the specified value with the specified key in this map.
      */
     void put(const K &key, const V &value) {
-        Entry *x = root;
-        while (x != NULL) {
-            if (x->key == key) {
-                x->value = value; 
-                return;
-            }
-            if (key < x->key) x = x->l; else x = x->r;
-        }
-        ++Size;
-        x = Insert(root, key, value);
-        Entry *Pre = Find_min(key);
-        if (Pre == NULL) Pre = begin;
-        Entry *Suc = Pre->succ;
-        
-        x->prev = Pre; Pre->succ = x;
-        if (Suc != NULL)
-            x->succ = Suc, Suc->prev = x;
+        putValue(key, value);
+    }
+
+    void put(const K &key, V &&value) {
+        putValue(key, std::move(value));
+    }
+
+    void put(K &&key, V &&value) {
+        putValue(std::move(key), std::move(value));
+    }
+
+    /**
+     * Associates a value made from args with the specified key. If the key is
+     * not present, the value is built in place in the new entry.
+     */
+    template <class... Args>
+    void putEmplace(const K &key, Args&&... args) {
+        putValue(key, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    void putEmplace(K &&key, Args&&... args) {
+        putValue(std::move(key), std::forward<Args>(args)...);
     }
 
     /**
@@ -272,27 +357,27 @@ class TreeMap<K, V>::Entry {
 
         Entry() {}
 
-        Entry(K k, V v) {
-            key = k;
-            value = v;
+        Entry(const K &k, const V &v): key(k), value(v) {
             heap = rand();
             l = r = NULL;
             prev = succ = NULL;
         }
 
-        Entry(K k, V v, int h) {
-            key = k;
-            value = v;
+        /*
+         * key is made from k and value from args, in place
+         */
+        template <class KK, class... Args>
+        Entry(int h, KK &&k, Args&&... args): key(std::forward<KK>(k)), value(std::forward<Args>(args)...) {
             heap = h;
             l = r = NULL;
             prev = succ = NULL;            
         }
 
-        K getKey() const {
+        const K &getKey() const {
             return key;
         }
 
-        V getValue() const {
+        const V &getValue() const {
             return value;
         }
 };
@@ -0,0 +1,169 @@
+/** @file */
+#ifndef __WORKSTEALINGDEQUE_H
+#define __WORKSTEALINGDEQUE_H
+
+#include <atomic>
+#include <type_traits>
+
+/**
+ * A Chase-Lev work-stealing deque: the per-worker task queue of a thread pool.
+ *
+ * One thread, the owner, calls push() and pop() at the bottom, like a stack of
+ * its own work. Any other thread may call steal(), which takes the oldest
+ * element from the top. Only when the deque holds a single element do the owner
+ * and a thief race for it, with one compare-and-swap; otherwise push() and pop()
+ * take no atomic read-modify-write at all.
+ * @code
+ *      WorkStealingDeque<Task *> d;
+ *      d.push(t);                      // owner
+ *      if (d.pop(t)) run(t);           // owner, newest first
+ *      if (other.steal(t)) run(t);     // any thread, oldest first
+ * @endcode
+ * The storage is a power-of-two ring, indexed with a mask like Deque, and grows
+ * when the owner fills it. A thief may still be reading the old ring, so it is
+ * kept until the deque is destroyed; together the old rings are smaller than
+ * the current one.
+ *
+ * The elements are copied in and out of atomic slots, so T must be trivially
+ * copyable: a pointer to the task, usually.
+ */
+template <class T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque holds trivially copyable elements");
+
+    /*
+     * @var prev the ring this one replaced
+     */
+    struct Ring {
+        long mask;
+        std::atomic<T> *slot;
+        Ring *prev;
+
+        Ring(long size, Ring *p): mask(size - 1), slot(new std::atomic<T>[size]), prev(p) {}
+        ~Ring() { delete[] slot; }
+
+        T get(long i) const { return slot[i & mask].load(std::memory_order_relaxed); }
+        void put(long i, const T &e) { slot[i & mask].store(e, std::memory_order_relaxed); }
+    };
+
+    /*
+     * top is moved by thieves (and by the owner taking the last element),
+     * bottom only by the owner; they live on different cache lines.
+     */
+    std::atomic<Ring *> ring;
+    char pad0[64];
+    std::atomic<long> top;
+    char pad1[64];
+    std::atomic<long> bottom;
+    char pad2[64];
+
+    WorkStealingDeque(const WorkStealingDeque &);
+    WorkStealingDeque &operator=(const WorkStealingDeque &);
+
+    /*
+     * Double the ring, which holds the elements at [t, b)
+     */
+    Ring *grow(Ring *r, long t, long b) {
+        Ring *n = new Ring(2 * (r->mask + 1), r);
+        for (long i = t; i < b; ++i)
+            n->put(i, r->get(i));
+        ring.store(n, std::memory_order_release);
+        return n;
+    }
+
+public:
+    /**
+     * Constructs an empty deque with room for c elements before it grows.
+     */
+    explicit WorkStealingDeque(int c = 64) {
+        long size = 2;
+        while (size < c) size *= 2;
+        ring.store(new Ring(size, NULL), std::memory_order_relaxed);
+        top.store(0, std::memory_order_relaxed);
+        bottom.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * Destructor
+     * No other thread may use the deque any more.
+     */
+    ~WorkStealingDeque() {
+        Ring *r = ring.load(std::memory_order_relaxed);
+        while (r != NULL) {
+            Ring *p = r->prev;
+            delete r;
+            r = p;
+        }
+    }
+
+    /**
+     * Adds e at the bottom. Only the owner may call it.
+     */
+    void push(const T &e) {
+        long b = bottom.load(std::memory_order_relaxed);
+        long t = top.load(std::memory_order_acquire);
+        Ring *r = ring.load(std::memory_order_relaxed);
+        if (b - t > r->mask) r = grow(r, t, b);
+        r->put(b, e);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    /**
+     * Takes the element at the bottom (the newest) into e. Only the owner may
+     * call it. Returns false if the deque is empty, or a thief won its last
+     * element.
+     */
+    bool pop(T &e) {
+        long b = bottom.load(std::memory_order_relaxed) - 1;
+        Ring *r = ring.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        e = r->get(b);
+        if (t < b) return true;
+        bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    /**
+     * Takes the element at the top (the oldest) into e. Any thread may call it.
+     * Returns false if the deque is empty, or another thread took the element
+     * first; the caller may simply try again.
+     */
+    bool steal(T &e) {
+        long t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        long b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+        Ring *r = ring.load(std::memory_order_acquire);
+        e = r->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of elements; only a hint while other threads work.
+     */
+    int size() const {
+        long b = bottom.load(std::memory_order_acquire);
+        long n = b - top.load(std::memory_order_acquire);
+        return n < 0 ? 0 : (int) n;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+    /**
+     * Returns the number of elements the deque holds before it grows again.
+     */
+    int capacity() const {
+        return (int) ring.load(std::memory_order_acquire)->mask + 1;
+    }
+};
+
+#endif
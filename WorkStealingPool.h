@@ -0,0 +1,270 @@
+/** @file */
+#ifndef __WORKSTEALINGPOOL_H
+#define __WORKSTEALINGPOOL_H
+
+#include "ArrayList.h"
+#include "ConcurrentQueue.h"
+#include "WorkStealingDeque.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * A fixed set of worker threads which run tasks, each worker keeping its own
+ * WorkStealingDeque.
+ *
+ * A task submitted by a worker goes to the bottom of that worker's deque, where
+ * the same worker picks it up again, newest first, while its data is still in
+ * the cache. A worker with nothing to do steals the oldest task of another
+ * worker, usually the biggest piece of work left. Tasks submitted from outside
+ * the pool go through a shared MpmcQueue.
+ * @code
+ *      WorkStealingPool pool;                       // one worker per core
+ *      pool.parallelFor(0, n, 1024, [&](int i) { a[i] = f(i); });
+ *
+ *      WorkStealingPool::TaskGroup g(pool);         // fork-join
+ *      g.run([&] { left = solve(l); });
+ *      right = solve(r);
+ *      g.wait();
+ * @endcode
+ * Tasks must not throw.
+ */
+class WorkStealingPool {
+    struct Task {
+        std::function<void()> f;
+        std::atomic<int> *pending;
+    };
+
+    /*
+     * @var pad keeps the deques of two workers off one cache line
+     */
+    struct Worker {
+        WorkStealingDeque<Task *> deque;
+        std::thread thread;
+        char pad[64];
+    };
+
+    ArrayList<Worker *> workers;
+    MpmcQueue<Task *> inbox;
+    std::atomic<bool> stopping;
+
+    /*
+     * Idle workers sleep on wake for at most a millisecond, so a missed
+     * notify only costs that much
+     */
+    std::mutex idle_lock;
+    std::condition_variable wake;
+    std::atomic<int> sleeping;
+
+    WorkStealingPool(const WorkStealingPool &);
+    WorkStealingPool &operator=(const WorkStealingPool &);
+
+    /*
+     * The pool and worker index of the calling thread; index -1 outside any pool
+     */
+    struct Current {
+        WorkStealingPool *pool;
+        int index;
+    };
+
+    static Current &current() {
+        static thread_local Current c = {NULL, -1};
+        return c;
+    }
+
+    int myIndex() const {
+        Current &c = current();
+        return c.pool == this ? c.index : -1;
+    }
+
+    void enqueue(Task *t) {
+        int me = myIndex();
+        if (me >= 0) workers.get(me)->deque.push(t);
+        else inbox.push(t);
+        if (sleeping.load() > 0) wake.notify_one();
+    }
+
+    /*
+     * Find a task: own deque, then the inbox, then the other workers,
+     * starting from a different one each time
+     */
+    Task *find(unsigned int &seed) {
+        Task *t;
+        int me = myIndex();
+        if (me >= 0 && workers.get(me)->deque.pop(t)) return t;
+        if (inbox.tryPop(t)) return t;
+        int n = workers.size();
+        seed = seed * 1103515245u + 12345u;
+        int first = (seed >> 8) % n;
+        for (int i = 0; i < n; ++i) {
+            int v = (first + i) % n;
+            if (v != me && workers.get(v)->deque.steal(t)) return t;
+        }
+        return NULL;
+    }
+
+    static void execute(Task *t) {
+        t->f();
+        if (t->pending != NULL) t->pending->fetch_sub(1, std::memory_order_release);
+        delete t;
+    }
+
+    void work(int index) {
+        current().pool = this;
+        current().index = index;
+        unsigned int seed = index + 1;
+        int idle = 0;
+        while (true) {
+            Task *t = find(seed);
+            if (t != NULL) {
+                execute(t);
+                idle = 0;
+                continue;
+            }
+            if (stopping.load()) break;
+            if (++idle < 256) {
+                QueueWait::backoff(idle);
+                continue;
+            }
+            std::unique_lock<std::mutex> l(idle_lock);
+            ++sleeping;
+            if (!stopping.load()) wake.wait_for(l, std::chrono::milliseconds(1));
+            --sleeping;
+        }
+    }
+
+public:
+    /**
+     * Starts threads workers, or one per core if threads is 0.
+     */
+    explicit WorkStealingPool(int threads = 0): inbox(1024) {
+        if (threads <= 0) threads = std::thread::hardware_concurrency();
+        if (threads <= 0) threads = 1;
+        stopping.store(false);
+        sleeping.store(0);
+        for (int i = 0; i < threads; ++i)
+            workers.add(new Worker);
+        for (int i = 0; i < threads; ++i)
+            workers.get(i)->thread = std::thread(&WorkStealingPool::work, this, i);
+    }
+
+    /**
+     * Destructor
+     * Runs the tasks still queued, then stops the workers.
+     */
+    ~WorkStealingPool() {
+        stopping.store(true);
+        {
+            std::lock_guard<std::mutex> l(idle_lock);
+            wake.notify_all();
+        }
+        for (int i = 0; i < workers.size(); ++i)
+            workers.get(i)->thread.join();
+        for (int i = 0; i < workers.size(); ++i)
+            delete workers.get(i);
+    }
+
+    /**
+     * Runs f on some worker, some time later.
+     */
+    void submit(std::function<void()> f) {
+        Task *t = new Task;
+        t->f = std::move(f);
+        t->pending = NULL;
+        enqueue(t);
+    }
+
+    /**
+     * Returns the number of workers.
+     */
+    int threads() const {
+        return workers.size();
+    }
+
+    /**
+     * Calls f(i) for every i in [from, to), in parallel, and returns when all
+     * calls have returned. The range is halved until pieces have at most grain
+     * indices; each half is a task which an idle worker may steal.
+     */
+    template <class F>
+    void parallelFor(int from, int to, int grain, const F &f);
+
+    /**
+     * Tasks whose completion can be waited for together. wait() does not block
+     * a worker: it runs queued tasks, its own or stolen, until the group is done,
+     * so groups may be nested freely.
+     */
+    class TaskGroup {
+        WorkStealingPool &pool;
+        std::atomic<int> pending;
+
+        TaskGroup(const TaskGroup &);
+        TaskGroup &operator=(const TaskGroup &);
+
+    public:
+        explicit TaskGroup(WorkStealingPool &p): pool(p) {
+            pending.store(0);
+        }
+
+        /**
+         * The tasks must have finished before the group goes away.
+         */
+        ~TaskGroup() {
+            wait();
+        }
+
+        /**
+         * Runs f on some worker as a task of this group.
+         */
+        void run(std::function<void()> f) {
+            Task *t = new Task;
+            t->f = std::move(f);
+            t->pending = &pending;
+            pending.fetch_add(1, std::memory_order_relaxed);
+            pool.enqueue(t);
+        }
+
+        /**
+         * Returns when every task run() so far has finished.
+         */
+        void wait() {
+            unsigned int seed = (unsigned int) (size_t) this;
+            for (int n = 0; pending.load(std::memory_order_acquire) > 0; ) {
+                Task *t = pool.find(seed);
+                if (t != NULL) {
+                    execute(t);
+                    n = 0;
+                } else QueueWait::backoff(++n);
+            }
+        }
+    };
+
+private:
+    template <class F>
+    static void split(TaskGroup &g, int from, int to, int grain, const F &f);
+};
+
+template <class F>
+void WorkStealingPool::split(TaskGroup &g, int from, int to, int grain, const F &f) {
+    while (to - from > grain) {
+        int mid = from + (to - from) / 2;
+        g.run([&g, mid, to, grain, &f]() { split(g, mid, to, grain, f); });
+        to = mid;
+    }
+    for (int i = from; i < to; ++i)
+        f(i);
+}
+
+template <class F>
+void WorkStealingPool::parallelFor(int from, int to, int grain, const F &f) {
+    if (grain < 1) grain = 1;
+    TaskGroup g(*this);
+    split(g, from, to, grain, f);
+    g.wait();
+}
+
+#endif
@@ -0,0 +1,1146 @@
+/*
+ * benchmark.cpp: timing of the containers.
+ *
+ * g++ -O2 -std=c++11 -pthread benchmark.cpp -o benchmark
+ * ./benchmark          runs every benchmark
+ * ./benchmark HashMap  runs the benchmarks whose name contains "HashMap"
+ */
+
+#include "ArrayList.h"
+#include "Deque.h"
+#include "LinkedList.h"
+#include "IntrusiveList.h"
+#include "HashMap.h"
+#include "TreeMap.h"
+#include "PriorityQueue.h"
+#include "ConcurrentHashMap.h"
+#include "ConcurrentQueue.h"
+#include "WorkStealingPool.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::vector;
+
+class HashInt {
+public:
+    static int hashCode(int obj) {
+        return obj;
+    }
+};
+
+/*
+ * Seconds since the last call of lap()
+ */
+class Timer {
+    std::chrono::steady_clock::time_point last;
+public:
+    Timer(): last(std::chrono::steady_clock::now()) {}
+    double lap() {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double s = std::chrono::duration<double>(now - last).count();
+        last = now;
+        return s;
+    }
+};
+
+/*
+ * Keep the optimizer from dropping a result
+ */
+volatile long long sink;
+
+static unsigned int rand_state = 12345;
+unsigned int next_rand() {
+    rand_state = rand_state * 1103515245u + 12345u;
+    return rand_state >> 1;
+}
+
+/*
+ * Deque behind one mutex, the way a queue is shared without ConcurrentQueue.h
+ */
+class LockedQueue {
+    Deque<int> d;
+    std::mutex lock;
+public:
+    explicit LockedQueue(int) {}
+    bool tryPush(int e) {
+        std::lock_guard<std::mutex> l(lock);
+        if (d.size() >= 1024) return false;
+        d.addLast(e);
+        return true;
+    }
+    bool tryPop(int &e) {
+        std::lock_guard<std::mutex> l(lock);
+        if (d.isEmpty()) return false;
+        e = d.getFirst();
+        d.removeFirst();
+        return true;
+    }
+};
+
+/*
+ * producers threads push n ints in all, consumers threads pop them (Mops/s)
+ */
+template <class Q>
+double queue_throughput(int producers, int consumers, int n) {
+    Q q(1024);
+    vector<std::thread> th;
+    std::atomic<long long> sum(0);
+    Timer t;
+    for (int i = 0; i < producers; ++i)
+        th.push_back(std::thread([&q, i, producers, n]() {
+            for (int j = i; j < n; j += producers)
+                for (int w = 0; !q.tryPush(j); ++w) QueueWait::backoff(w);
+        }));
+    for (int i = 0; i < consumers; ++i)
+        th.push_back(std::thread([&q, &sum, i, consumers, n]() {
+            long long s = 0;
+            for (int j = i; j < n; j += consumers) {
+                int e;
+                for (int w = 0; !q.tryPop(e); ++w) QueueWait::backoff(w);
+                s += e;
+            }
+            sum += s;
+        }));
+    for (size_t i = 0; i < th.size(); ++i)
+        th[i].join();
+    double s = t.lap();
+    sink = sum;
+    return n / s / 1e6;
+}
+
+/*
+ * Round trips of one element between two threads through a pair of queues;
+ * returns the mean round trip in microseconds
+ */
+template <class Q>
+double queue_latency(int rounds) {
+    Q ping(16), pong(16);
+    std::thread echo([&ping, &pong, rounds]() {
+        for (int i = 0; i < rounds; ++i) {
+            int e;
+            for (int w = 0; !ping.tryPop(e); ++w) QueueWait::backoff(w);
+            for (int w = 0; !pong.tryPush(e); ++w) QueueWait::backoff(w);
+        }
+    });
+    Timer t;
+    for (int i = 0; i < rounds; ++i) {
+        int e;
+        for (int w = 0; !ping.tryPush(i); ++w) QueueWait::backoff(w);
+        for (int w = 0; !pong.tryPop(e); ++w) QueueWait::backoff(w);
+    }
+    double s = t.lap();
+    echo.join();
+    return s / rounds * 1e6;
+}
+
+void bench_queues() {
+    const int n = 4000000, rounds = 100000;
+    printf("Bounded queues of 1024 ints, %d elements through them (Mops/s)\n", n);
+    printf("  1 -> 1  SpscQueue %7.2f  MpmcQueue %7.2f  Deque+mutex %7.2f\n",
+            queue_throughput<SpscQueue<int> >(1, 1, n), queue_throughput<MpmcQueue<int> >(1, 1, n),
+            queue_throughput<LockedQueue>(1, 1, n));
+    printf("  2 -> 2                     MpmcQueue %7.2f  Deque+mutex %7.2f\n",
+            queue_throughput<MpmcQueue<int> >(2, 2, n), queue_throughput<LockedQueue>(2, 2, n));
+    printf("  4 -> 4                     MpmcQueue %7.2f  Deque+mutex %7.2f\n",
+            queue_throughput<MpmcQueue<int> >(4, 4, n), queue_throughput<LockedQueue>(4, 4, n));
+    printf("Ping-pong between two threads, %d round trips (us per round trip)\n", rounds);
+    printf("          SpscQueue %7.3f  MpmcQueue %7.3f  Deque+mutex %7.3f\n",
+            queue_latency<SpscQueue<int> >(rounds), queue_latency<MpmcQueue<int> >(rounds),
+            queue_latency<LockedQueue>(rounds));
+}
+
+/*
+ * Some arithmetic per index, so that a parallel loop has work to share;
+ * kept out of line so that the plain loop is not vectorized where the tasks are not
+ */
+__attribute__((noinline)) double busy(int i) {
+    double x = i;
+    for (int k = 0; k < 200; ++k)
+        x = x * 0.999 + 1.0 / (k + 1);
+    return x;
+}
+
+long fib_seq(int n) {
+    return n < 2 ? n : fib_seq(n - 1) + fib_seq(n - 2);
+}
+
+long fib_par(WorkStealingPool &pool, int n) {
+    if (n < 20) return fib_seq(n);
+    long a, b;
+    WorkStealingPool::TaskGroup g(pool);
+    g.run([&pool, &a, n]() { a = fib_par(pool, n - 1); });
+    b = fib_par(pool, n - 2);
+    g.wait();
+    return a + b;
+}
+
+void bench_work_stealing() {
+    const int n = 1 << 20, depth = 38;
+    int cores = std::thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+    vector<double> a(n);
+    Timer t;
+    for (int i = 0; i < n; ++i) a[i] = busy(i);
+    double loop1 = t.lap();
+    sink = fib_seq(depth);
+    double fib1 = t.lap();
+    printf("WorkStealingPool: parallelFor over %d indices, fork-join fib(%d) (speedup over sequential code)\n", n, depth);
+    printf("  sequential   parallelFor %7.3fs          fib %7.3fs\n", loop1, fib1);
+    for (int w = 1; ; w = (w * 2 > cores && w < cores) ? cores : w * 2) {
+        WorkStealingPool pool(w);
+        t.lap();
+        pool.parallelFor(0, n, 1024, [&a](int i) { a[i] = busy(i); });
+        double loop = t.lap();
+        sink = fib_par(pool, depth);
+        double fib = t.lap();
+        printf("  threads %3d  parallelFor %7.3fs %5.2fx  fib %7.3fs %5.2fx\n",
+                w, loop, loop1 / loop, fib, fib1 / fib);
+        if (w >= cores) break;
+    }
+}
+
+/*
+ * Build a list, walk it, thin it out with Iterator::remove, and churn both ends
+ */
+template <class L>
+void list_nodes(const char *name, int n, int rounds) {
+    Timer t;
+    double build = 0, walk = 0, thin = 0, churn = 0;
+    for (int r = 0; r < rounds; ++r) {
+        L l;
+        for (int i = 0; i < n; ++i) l.add(i);
+        build += t.lap();
+        long long sum = 0;
+        for (int k = 0; k < 10; ++k) {
+            typename L::Iterator it = l.iterator();
+            while (it.hasNext()) sum += it.next();
+        }
+        sink = sum;
+        walk += t.lap();
+        typename L::Iterator it = l.iterator();
+        while (it.hasNext())
+            if (it.next() & 1) it.remove();
+        thin += t.lap();
+        for (int i = 0; i < n; ++i) {
+            l.addLast(i);
+            l.removeFirst();
+        }
+        churn += t.lap();
+    }
+    printf("  %-24s add %7.3fs  iterate x10 %7.3fs  Iterator::remove %7.3fs  addLast+removeFirst %7.3fs\n",
+            name, build, walk, thin, churn);
+}
+
+void bench_list_nodes() {
+    const int n = 1000000, rounds = 5;
+    printf("LinkedList<int> of %d elements, %d rounds\n", n, rounds);
+    list_nodes<LinkedList<int, NodePerElement, NewAllocator> >("one new per node", n, rounds);
+    list_nodes<LinkedList<int> >("SlabAllocator pool", n, rounds);
+    list_nodes<LinkedList<int, Unrolled> >("Unrolled", n, rounds);
+}
+
+void bench_list_splice() {
+    const int n = 1000000;
+    printf("LinkedList<int> of %d elements: sort, and concatenating two lists\n", n);
+    Timer t;
+    LinkedList<int> a, b;
+    for (int i = 0; i < n; ++i) a.add(next_rand());
+    LinkedList<int> c(a);
+    t.lap();
+    a.sort();
+    double sort = t.lap();
+    vector<int> v;
+    for (LinkedList<int>::Iterator it = c.iterator(); it.hasNext(); ) v.push_back(it.next());
+    std::sort(v.begin(), v.end());
+    c.clear();
+    for (int i = 0; i < n; ++i) c.add(v[i]);
+    double dump = t.lap();
+    printf("  sort()                   %7.3fs   copy out, std::sort, copy back %7.3fs\n", sort, dump);
+    for (int i = 0; i < n; ++i) b.add(i);
+    t.lap();
+    for (LinkedList<int>::Iterator it = b.iterator(); it.hasNext(); ) c.add(it.next());
+    double add = t.lap();
+    a.splice(a.size(), b);
+    double splice = t.lap();
+    a.sort();
+    c.sort();
+    t.lap();
+    LinkedList<int> m(c);
+    t.lap();
+    a.merge(m);
+    double merge = t.lap();
+    sink = a.size() + c.size();
+    printf("  splice(size(), list)     %7.3fs   add() each element             %7.3fs\n", splice, add);
+    printf("  merge of two sorted lists of %d and %d elements %7.3fs\n", 2 * n, 2 * n, merge);
+}
+
+/*
+ * Positional access patterns: a scan by index each way, edits near the tail,
+ * and a cursor which wanders through the middle
+ */
+template <class L>
+void list_index(const char *name, int n) {
+    L l;
+    for (int i = 0; i < n; ++i) l.add(i);
+    Timer t;
+    long long sum = 0;
+    for (int i = 0; i < n; ++i) sum += l.get(i);
+    for (int i = n - 1; i >= 0; --i) sum += l.get(i);
+    double scan = t.lap();
+    for (int i = 0; i < n; ++i) {
+        l.add(l.size() - 5, i);
+        l.removeIndex(l.size() - 7);
+    }
+    double tail = t.lap();
+    int cur = n / 2;
+    for (int i = 0; i < n; ++i) {
+        cur += next_rand() % 9 - 4;
+        if (cur < 0 || cur >= l.size()) cur = l.size() / 2;
+        if (i & 1) sum += l.get(cur);
+        else l.set(cur, i);
+    }
+    double walk = t.lap();
+    sink = sum;
+    printf("  %-10s get(0..n) and back %7.3fs  add/removeIndex near the tail %7.3fs  wandering get/set %7.3fs\n",
+            name, scan, tail, walk);
+}
+
+void bench_list_index() {
+    const int n = 200000;
+    printf("Indexed access to a list of %d ints, %d operations per pattern\n", n, n);
+    list_index<LinkedList<int> >("LinkedList", n);
+    list_index<LinkedList<int, Unrolled> >("Unrolled", n);
+    list_index<ArrayList<int> >("ArrayList", n);
+    list_index<LinkedList<int, SkipIndexed> >("SkipList", n);
+}
+
+/*
+ * Uniformly random positions, where no finger helps: get, then add(index)
+ * paired with removeIndex so the size stays at n
+ */
+template <class L>
+double list_random_index(int n, int ops) {
+    L l;
+    for (int i = 0; i < n; ++i) l.add(i);
+    Timer t;
+    long long sum = 0;
+    for (int i = 0; i < ops; ++i) sum += l.get(next_rand() % n);
+    for (int i = 0; i < ops; ++i) {
+        l.add(next_rand() % (n + 1), i);
+        l.removeIndex(next_rand() % (n + 1));
+    }
+    sink = sum;
+    return t.lap();
+}
+
+void bench_list_random_index() {
+    const int ops = 10000;
+    printf("%d random get, then %d random add(index) + removeIndex\n", ops, ops);
+    printf("  %9s %12s %12s %12s\n", "n", "LinkedList", "ArrayList", "SkipList");
+    for (int n = 1000; n <= 10000000; n *= 10) {
+        printf("  %9d ", n);
+        if (n <= 100000) printf("%11.4fs ", list_random_index<LinkedList<int> >(n, ops));
+        else printf("%12s ", "-");
+        printf("%11.4fs ", list_random_index<ArrayList<int> >(n, ops));
+        printf("%11.4fs\n", list_random_index<LinkedList<int, SkipIndexed> >(n, ops));
+    }
+}
+
+/*
+ * Items kept in two lists at once: by pointer in LinkedLists, or through two
+ * hooks in IntrusiveLists
+ */
+struct Item: ListHook<> {
+    int key;
+    ListHook<> second;
+};
+
+typedef IntrusiveList<Item, MemberHook<Item, &Item::second> > SecondList;
+
+void bench_intrusive_list() {
+    const int n = 200000, k = 2000;
+    vector<Item> items(n);
+    for (int i = 0; i < n; ++i) items[i].key = i;
+    vector<int> gone(k);
+    for (int i = 0; i < k; ++i) gone[i] = next_rand() % n;
+    printf("%d items in two lists, walk both, then take %d of them out of both\n", n, k);
+    Timer t;
+    {
+        LinkedList<Item *> a, b;
+        for (int i = 0; i < n; ++i) {
+            a.add(&items[i]);
+            b.addFirst(&items[i]);
+        }
+        double build = t.lap();
+        long long sum = 0;
+        for (LinkedList<Item *>::Iterator it = a.iterator(); it.hasNext(); ) sum += it.next()->key;
+        for (LinkedList<Item *>::Iterator it = b.iterator(); it.hasNext(); ) sum += it.next()->key;
+        double walk = t.lap();
+        for (int i = 0; i < k; ++i) {
+            a.remove(&items[gone[i]]);
+            b.remove(&items[gone[i]]);
+        }
+        double remove = t.lap();
+        sink = sum + a.size();
+        printf("  LinkedList<Item *>  build %7.4fs  walk %7.4fs  remove %7.4fs\n", build, walk, remove);
+    }
+    t.lap();
+    {
+        IntrusiveList<Item> a;
+        SecondList b;
+        for (int i = 0; i < n; ++i) {
+            a.add(items[i]);
+            b.addFirst(items[i]);
+        }
+        double build = t.lap();
+        long long sum = 0;
+        for (IntrusiveList<Item>::Iterator it = a.iterator(); it.hasNext(); ) sum += it.next().key;
+        for (SecondList::Iterator it = b.iterator(); it.hasNext(); ) sum += it.next().key;
+        double walk = t.lap();
+        for (int i = 0; i < k; ++i) {
+            Item &e = items[gone[i]];
+            if (static_cast<ListHook<> &>(e).isLinked()) a.remove(e);
+            if (e.second.isLinked()) b.remove(e);
+        }
+        double remove = t.lap();
+        sink = sum + a.size();
+        printf("  IntrusiveList       build %7.4fs  walk %7.4fs  remove %7.4fs\n", build, walk, remove);
+    }
+}
+
+/*
+ * A heap of n elements: push them in random order, then hold the size at n while
+ * ops pop + push pairs go through, then pop them all. The pairs push a little
+ * above the element popped, like the events of a simulation, so the keys are
+ * monotone for RadixHeap.
+ */
+template <class Q>
+void heap_throughput(const char *name, int n, int ops) {
+    rand_state = 12345;
+    Timer t;
+    Q q;
+    for (int i = 0; i < n; ++i) q.push(next_rand());
+    double push = t.lap();
+    long long s = 0;
+    for (int i = 0; i < ops; ++i) {
+        unsigned int x = q.front();
+        s += x;
+        q.pop();
+        q.push(x + next_rand() % 1024);
+    }
+    double steady = t.lap();
+    while (!q.empty()) {
+        s += q.front();
+        q.pop();
+    }
+    double drain = t.lap();
+    sink = s;
+    printf("  %-14s push %7.3fs  pop+push %7.3fs  pop %7.3fs\n", name, push, steady, drain);
+}
+
+void bench_heap() {
+    const int ops = 4000000;
+    int sizes[] = {1000, 1000000};
+    for (int k = 0; k < 2; ++k) {
+        int n = sizes[k];
+        printf("PriorityQueue<unsigned int> of %d elements, %d pop + push\n", n, ops);
+        heap_throughput<PriorityQueue<unsigned int> >("NodeHeap", n, ops);
+        heap_throughput<PriorityQueue<unsigned int, Less<unsigned int>, DaryHeap<2> > >("DaryHeap<2>", n, ops);
+        heap_throughput<PriorityQueue<unsigned int, Less<unsigned int>, DaryHeap<> > >("DaryHeap<4>", n, ops);
+        heap_throughput<PriorityQueue<unsigned int, Less<unsigned int>, DaryHeap<8> > >("DaryHeap<8>", n, ops);
+        heap_throughput<PriorityQueue<unsigned int, Less<unsigned int>, PairingHeap> >("PairingHeap", n, ops);
+        heap_throughput<PriorityQueue<unsigned int, Less<unsigned int>, RadixHeap> >("RadixHeap", n, ops);
+    }
+}
+
+/*
+ * Fill shards queues with n elements in all, then combine them into one: by
+ * pushing every element, by meld, and with the constructor from a range of queues
+ */
+template <class Q>
+void heap_meld(const char *name, int shards, int n) {
+    vector<Q> a(shards), b(shards), c(shards);
+    for (int i = 0; i < n; ++i) {
+        unsigned int x = next_rand();
+        a[i % shards].push(x);
+        b[i % shards].push(x);
+        c[i % shards].push(x);
+    }
+    Timer t;
+    Q p;
+    for (int k = 0; k < shards; ++k) {
+        while (!a[k].empty()) {
+            p.push(a[k].front());
+            a[k].pop();
+        }
+    }
+    double push = t.lap();
+    Q m;
+    for (int k = 0; k < shards; ++k) m.meld(std::move(b[k]));
+    double meld = t.lap();
+    Q r(c.begin(), c.end());
+    double range = t.lap();
+    sink = p.front() + m.front() + r.front();
+    printf("  %-12s push+pop each %7.4fs  meld %7.4fs  range constructor %7.4fs\n", name, push, meld, range);
+}
+
+void bench_heap_meld() {
+    const int n = 1000000;
+    int shards[] = {4, 256};
+    for (int k = 0; k < 2; ++k) {
+        printf("Combining %d queues of %d unsigned ints in all\n", shards[k], n);
+        heap_meld<PriorityQueue<unsigned int> >("NodeHeap", shards[k], n);
+        heap_meld<PriorityQueue<unsigned int, Less<unsigned int>, DaryHeap<> > >("DaryHeap<4>", shards[k], n);
+        heap_meld<PriorityQueue<unsigned int, Less<unsigned int>, PairingHeap> >("PairingHeap", shards[k], n);
+        heap_meld<PriorityQueue<unsigned int, Less<unsigned int>, RadixHeap> >("RadixHeap", shards[k], n);
+    }
+}
+
+/*
+ * A scheduler tick: push a batch of new items, then drain the k least. Done
+ * ticks times with push/pop loops, and with pushAll/popK. Urgent items are each
+ * less than every item before them, the worst case of push.
+ */
+template <class Q>
+void heap_batch(const char *name, int batch, int k, int ticks, bool urgent) {
+    vector<unsigned int> items(batch);
+    unsigned int seq = 0;
+    Q a, b;
+    Timer t;
+    long long s = 0;
+    for (int r = 0; r < ticks; ++r) {
+        for (int i = 0; i < batch; ++i) items[i] = urgent ? 0x7FFFFFFF - seq++ : next_rand();
+        for (int i = 0; i < batch; ++i) a.push(items[i]);
+        for (int i = 0; i < k && !a.empty(); ++i) {
+            s += a.front();
+            a.pop();
+        }
+    }
+    double loop = t.lap();
+    ArrayList<unsigned int> out;
+    seq = 0;
+    for (int r = 0; r < ticks; ++r) {
+        for (int i = 0; i < batch; ++i) items[i] = urgent ? 0x7FFFFFFF - seq++ : next_rand();
+        b.pushAll(items.begin(), items.end());
+        out.clear();
+        b.popK(k, out);
+        s += out.size();
+    }
+    double bulk = t.lap();
+    sink = s;
+    printf("  %-12s push/pop loops %7.3fs  pushAll/popK %7.3fs\n", name, loop, bulk);
+}
+
+void bench_heap_batch() {
+    const int ticks = 200;
+    int batches[] = {100, 20000, 20000};
+    int ks[] = {100, 15000, 15000};
+    for (int c = 0; c < 3; ++c) {
+        bool urgent = c == 2;
+        printf("%d ticks: push %d %s items, pop the least %d\n", ticks, batches[c], urgent ? "urgent" : "random", ks[c]);
+        heap_batch<PriorityQueue<unsigned int> >("NodeHeap", batches[c], ks[c], ticks, urgent);
+        heap_batch<PriorityQueue<unsigned int, Less<unsigned int>, DaryHeap<> > >("DaryHeap<4>", batches[c], ks[c], ticks, urgent);
+        heap_batch<PriorityQueue<unsigned int, Less<unsigned int>, PairingHeap> >("PairingHeap", batches[c], ks[c], ticks, urgent);
+    }
+}
+
+/*
+ * A random directed graph in adjacency arrays: edges of vertex u are
+ * to[first[u]] .. to[first[u + 1] - 1], with weights w
+ */
+struct Graph {
+    int n;
+    vector<int> first, to, w;
+
+    Graph(int n, int degree): n(n), first(n + 1) {
+        for (int u = 0; u < n; ++u) {
+            first[u] = (int) to.size();
+            to.push_back((u + 1) % n);
+            w.push_back(1000);
+            for (int k = 1; k < degree; ++k) {
+                to.push_back(next_rand() % n);
+                w.push_back(1 + next_rand() % 1000);
+            }
+        }
+        first[n] = (int) to.size();
+    }
+};
+
+struct Label {
+    long long d;
+    int u;
+    Label() {}
+    Label(long long d, int u): d(d), u(u) {}
+    bool operator<(const Label &x) const { return d < x.d; }
+};
+
+/*
+ * Dijkstra with one heap entry per vertex, lowered by decreaseKey
+ */
+template <class Queue>
+long long dijkstra_handles(const Graph &g) {
+    const long long inf = 1LL << 62;
+    vector<long long> dist(g.n, inf);
+    vector<typename Queue::Handle> h(g.n);
+    vector<char> queued(g.n, 0);
+    Queue q;
+    dist[0] = 0;
+    h[0] = q.push(Label(0, 0));
+    queued[0] = 1;
+    while (!q.empty()) {
+        int u = q.front().u;
+        q.pop();
+        queued[u] = 0;
+        for (int e = g.first[u]; e < g.first[u + 1]; ++e) {
+            int v = g.to[e];
+            long long d = dist[u] + g.w[e];
+            if (d >= dist[v]) continue;
+            dist[v] = d;
+            if (queued[v]) q.decreaseKey(h[v], Label(d, v));
+            else {
+                h[v] = q.push(Label(d, v));
+                queued[v] = 1;
+            }
+        }
+    }
+    long long s = 0;
+    for (int u = 0; u < g.n; ++u) s += dist[u];
+    return s;
+}
+
+/*
+ * Dijkstra which pushes a new entry for every improvement and skips stale ones
+ */
+template <class Queue>
+long long dijkstra_lazy(const Graph &g) {
+    const long long inf = 1LL << 62;
+    vector<long long> dist(g.n, inf);
+    Queue q;
+    dist[0] = 0;
+    q.push(Label(0, 0));
+    while (!q.empty()) {
+        Label x = q.front();
+        q.pop();
+        if (x.d > dist[x.u]) continue;
+        for (int e = g.first[x.u]; e < g.first[x.u + 1]; ++e) {
+            int v = g.to[e];
+            long long d = x.d + g.w[e];
+            if (d >= dist[v]) continue;
+            dist[v] = d;
+            q.push(Label(d, v));
+        }
+    }
+    long long s = 0;
+    for (int u = 0; u < g.n; ++u) s += dist[u];
+    return s;
+}
+
+/*
+ * Lazy Dijkstra on a RadixHeap: an entry is the distance shifted above the vertex
+ */
+long long dijkstra_radix(const Graph &g) {
+    const long long inf = 1LL << 62;
+    const int shift = 23;
+    vector<long long> dist(g.n, inf);
+    PriorityQueue<unsigned long long, Less<unsigned long long>, RadixHeap> q;
+    dist[0] = 0;
+    q.push(0);
+    while (!q.empty()) {
+        unsigned long long x = q.front();
+        q.pop();
+        long long d = x >> shift;
+        int u = x & ((1 << shift) - 1);
+        if (d > dist[u]) continue;
+        for (int e = g.first[u]; e < g.first[u + 1]; ++e) {
+            int v = g.to[e];
+            long long dv = d + g.w[e];
+            if (dv >= dist[v]) continue;
+            dist[v] = dv;
+            q.push((unsigned long long) dv << shift | v);
+        }
+    }
+    long long s = 0;
+    for (int u = 0; u < g.n; ++u) s += dist[u];
+    return s;
+}
+
+void bench_shortest_path() {
+    int sizes[] = {100000, 1000000, 4000000};
+    const int degree = 8;
+    for (int k = 0; k < 3; ++k) {
+        Graph g(sizes[k], degree);
+        printf("Dijkstra on a random graph of %d vertices and %d edges\n", g.n, (int) g.to.size());
+        Timer t;
+        long long r[5];
+        double s[5];
+        r[0] = dijkstra_handles<PriorityQueue<Label> >(g);
+        s[0] = t.lap();
+        r[1] = dijkstra_handles<PriorityQueue<Label, Less<Label>, PairingHeap> >(g);
+        s[1] = t.lap();
+        r[2] = dijkstra_lazy<PriorityQueue<Label> >(g);
+        s[2] = t.lap();
+        r[3] = dijkstra_lazy<PriorityQueue<Label, Less<Label>, DaryHeap<> > >(g);
+        s[3] = t.lap();
+        r[4] = dijkstra_radix(g);
+        s[4] = t.lap();
+        bool same = true;
+        for (int i = 1; i < 5; ++i) same = same && r[i] == r[0];
+        sink = r[0];
+        printf("  decreaseKey  NodeHeap %7.3fs  PairingHeap %7.3fs\n", s[0], s[1]);
+        printf("  lazy         NodeHeap %7.3fs  DaryHeap    %7.3fs  RadixHeap %7.3fs%s\n",
+                s[2], s[3], s[4], same ? "" : "  (results differ!)");
+    }
+}
+
+/*----------------------------------------------------------------------*/
+
+template <class Map>
+void hashmap_lookup(const char *name, const vector<int> &keys, const vector<int> &miss) {
+    Timer t;
+    Map *m = new Map();
+    for (size_t i = 0; i < keys.size(); ++i)
+        m->put(keys[i], (int) i);
+    double put = t.lap();
+    long long s = 0;
+    for (size_t i = 0; i < keys.size(); ++i)
+        s += m->get(keys[i]);
+    double hit = t.lap();
+    for (size_t i = 0; i < miss.size(); ++i)
+        s += m->containsKey(miss[i]);
+    double mis = t.lap();
+    delete m;
+    double del = t.lap();
+    sink = s;
+    printf("  %-14s put %7.3fs  get(hit) %7.3fs  containsKey(miss) %7.3fs  destroy %7.3fs\n",
+            name, put, hit, mis, del);
+}
+
+void bench_hashmap_lookup() {
+    const int n = 1000000;
+    vector<int> keys, miss;
+    for (int i = 0; i < n; ++i) {
+        keys.push_back(next_rand() & 0x3FFFFFFF);
+        miss.push_back(next_rand() | 0x40000000);
+    }
+    printf("HashMap lookup, %d random int keys\n", n);
+    hashmap_lookup<HashMap<int, int, HashInt, Chaining, NewAllocator> >("Chaining/new", keys, miss);
+    hashmap_lookup<HashMap<int, int, HashInt, Chaining> >("Chaining/slab", keys, miss);
+    hashmap_lookup<HashMap<int, int, HashInt, RobinHood> >("RobinHood", keys, miss);
+    hashmap_lookup<HashMap<int, int, HashInt, GroupProbing> >("GroupProbing", keys, miss);
+}
+
+/*
+ * The slowest single put() tells how long a growth stalls the caller.
+ */
+void hashmap_rehash(int budget, int n) {
+    HashMap<int, int, HashInt> m;
+    m.setRehashBudget(budget);
+    double worst = 0, total = 0;
+    for (int i = 0; i < n; ++i) {
+        Timer t;
+        m.put(i, i);
+        double s = t.lap();
+        total += s;
+        if (s > worst) worst = s;
+    }
+    printf("  budget %2d  total %7.3fs  slowest put %9.3fms\n", budget, total, worst * 1e3);
+}
+
+void bench_hashmap_rehash() {
+    const int n = 4000000;
+    printf("HashMap growth, %d puts\n", n);
+    hashmap_rehash(0, n);
+    hashmap_rehash(1, n);
+    hashmap_rehash(4, n);
+}
+
+/*
+ * HashMap behind one mutex, the way it is shared without ConcurrentHashMap
+ */
+class LockedHashMap {
+    HashMap<int, int, HashInt> map;
+    mutable std::mutex lock;
+public:
+    bool containsKey(int k) const {
+        std::lock_guard<std::mutex> l(lock);
+        return map.containsKey(k);
+    }
+    void put(int k, int v) {
+        std::lock_guard<std::mutex> l(lock);
+        map.put(k, v);
+    }
+};
+
+/*
+ * Each thread does ops operations, 90% containsKey and 10% put
+ */
+template <class Map>
+double concurrent_ops(Map &m, int threads, int ops, int range) {
+    vector<std::thread> th;
+    Timer t;
+    for (int i = 0; i < threads; ++i)
+        th.push_back(std::thread([&m, i, ops, range]() {
+            unsigned int s = 1 + i;
+            long long hit = 0;
+            for (int j = 0; j < ops; ++j) {
+                s = s * 1103515245u + 12345u;
+                int k = (s >> 8) % range;
+                if ((s >> 4) % 10 == 0) m.put(k, j);
+                else hit += m.containsKey(k);
+            }
+            sink = hit;
+        }));
+    for (size_t i = 0; i < th.size(); ++i)
+        th[i].join();
+    return (double) threads * ops / t.lap() / 1e6;
+}
+
+void bench_concurrent_hashmap() {
+    const int range = 1 << 20, ops = 2000000;
+    int cores = std::thread::hardware_concurrency();
+    if (cores < 1) cores = 1;
+    printf("Shared map, 90%% containsKey / 10%% put, %d ops per thread (Mops/s)\n", ops);
+    ConcurrentHashMap<int, int, HashInt> c(64);
+    LockedHashMap l;
+    for (int i = 0; i < range; i += 2) {
+        c.put(i, i);
+        l.put(i, i);
+    }
+    for (int n = 1; ; n = (n * 2 > cores && n < cores) ? cores : n * 2) {
+        printf("  threads %3d  ConcurrentHashMap %8.2f  HashMap+mutex %8.2f\n",
+                n, concurrent_ops(c, n, ops, range), concurrent_ops(l, n, ops, range));
+        if (n >= cores) break;
+    }
+}
+
+/*
+ * A payload which counts how often it is copied and moved
+ */
+struct Counted {
+    static long copies, moves;
+    std::string s;
+
+    Counted() {}
+    Counted(int n): s(n, 'x') {}
+    Counted(const Counted &x): s(x.s) { ++copies; }
+    Counted(Counted &&x): s(std::move(x.s)) { ++moves; }
+    Counted &operator=(const Counted &x) { s = x.s; ++copies; return *this; }
+    Counted &operator=(Counted &&x) { s = std::move(x.s); ++moves; return *this; }
+    bool operator<(const Counted &x) const { return s < x.s; }
+    bool operator==(const Counted &x) const { return s == x.s; }
+};
+long Counted::copies, Counted::moves;
+
+static const int len = 64;
+
+class HashString {
+public:
+    static int hashCode(const std::string &s) {
+        unsigned int h = 0;
+        for (size_t i = 0; i < s.size(); ++i) h = h * 31 + s[i];
+        return (int) h;
+    }
+};
+
+/*
+ * Times fill(container, i) for i < n, and reports the copies and moves of Counted
+ */
+template <class C, class F>
+void copies_moves(const char *name, int n, F fill) {
+    Counted::copies = Counted::moves = 0;
+    Timer t;
+    C *c = new C();
+    for (int i = 0; i < n; ++i)
+        fill(*c, i);
+    C d(std::move(*c));
+    delete c;
+    printf("  %-26s %7.3fs  copies %9ld  moves %9ld\n", name, t.lap(), Counted::copies, Counted::moves);
+}
+
+void bench_copies_moves() {
+    const int n = 200000;
+    printf("Copies and moves of a %d-byte string payload, %d insertions\n", len, n);
+    copies_moves<ArrayList<Counted> >("ArrayList add(const&)", n,
+            [](ArrayList<Counted> &c, int) { Counted x(len); c.add(x); });
+    copies_moves<ArrayList<Counted> >("ArrayList add(&&)", n,
+            [](ArrayList<Counted> &c, int) { c.add(Counted(len)); });
+    copies_moves<ArrayList<Counted> >("ArrayList emplace", n,
+            [](ArrayList<Counted> &c, int) { c.emplace(len); });
+    copies_moves<Deque<Counted> >("Deque addLast(const&)", n,
+            [](Deque<Counted> &c, int) { Counted x(len); c.addLast(x); });
+    copies_moves<Deque<Counted> >("Deque emplaceLast", n,
+            [](Deque<Counted> &c, int) { c.emplaceLast(len); });
+    copies_moves<LinkedList<Counted> >("LinkedList add(const&)", n,
+            [](LinkedList<Counted> &c, int) { Counted x(len); c.add(x); });
+    copies_moves<LinkedList<Counted> >("LinkedList emplace", n,
+            [](LinkedList<Counted> &c, int) { c.emplace(len); });
+    copies_moves<HashMap<std::string, Counted, HashString> >("HashMap put(const&)", n,
+            [](HashMap<std::string, Counted, HashString> &c, int i) { Counted x(len); c.put(std::to_string(i), x); });
+    copies_moves<HashMap<std::string, Counted, HashString> >("HashMap putEmplace", n,
+            [](HashMap<std::string, Counted, HashString> &c, int i) { c.putEmplace(std::to_string(i), len); });
+    copies_moves<HashMap<std::string, Counted, HashString, RobinHood> >("RobinHood putEmplace", n,
+            [](HashMap<std::string, Counted, HashString, RobinHood> &c, int i) { c.putEmplace(std::to_string(i), len); });
+    copies_moves<HashMap<std::string, Counted, HashString, GroupProbing> >("GroupProbing putEmplace", n,
+            [](HashMap<std::string, Counted, HashString, GroupProbing> &c, int i) { c.putEmplace(std::to_string(i), len); });
+    copies_moves<TreeMap<std::string, Counted> >("TreeMap put(const&)", n,
+            [](TreeMap<std::string, Counted> &c, int i) { Counted x(len); c.put(std::to_string(i), x); });
+    copies_moves<TreeMap<std::string, Counted> >("TreeMap putEmplace", n,
+            [](TreeMap<std::string, Counted> &c, int i) { c.putEmplace(std::to_string(i), len); });
+    copies_moves<PriorityQueue<Counted> >("PriorityQueue push(const&)", n,
+            [](PriorityQueue<Counted> &c, int) { Counted x(len); c.push(x); });
+    copies_moves<PriorityQueue<Counted> >("PriorityQueue emplace", n,
+            [](PriorityQueue<Counted> &c, int) { c.emplace(len); });
+    copies_moves<PriorityQueue<Counted, Less<Counted>, DaryHeap<> > >("DaryHeap emplace", n,
+            [](PriorityQueue<Counted, Less<Counted>, DaryHeap<> > &c, int) { c.emplace(len); });
+}
+
+/*
+ * Appends n elements after setGrowthFactor(factor), or after reserve(n) if factor is 0
+ */
+template <class T>
+void arraylist_append(const char *name, double factor, int n, const T &x) {
+    Timer t;
+    for (int r = 0; r < 10; ++r) {
+        ArrayList<T> a;
+        if (factor == 0) a.reserve(n);
+        else a.setGrowthFactor(factor);
+        for (int i = 0; i < n; ++i)
+            a.add(x);
+        sink = a.size();
+    }
+    if (factor == 0) printf("  %-12s reserve      %7.3fs\n", name, t.lap());
+    else printf("  %-12s growth %4.2f  %7.3fs\n", name, factor, t.lap());
+}
+
+void bench_arraylist_append() {
+    const int n = 1000000;
+    printf("ArrayList, 10 times %d add()\n", n);
+    double factors[] = {1.5, 2, 0};
+    for (int i = 0; i < 3; ++i) {
+        arraylist_append("int", factors[i], n, 1);
+        arraylist_append("string", factors[i], n, std::string(32, 'x'));
+    }
+}
+
+static bool is_odd(const int &x) {
+    return x % 2 != 0;
+}
+
+void bench_arraylist_bulk() {
+    const int n = 100000, k = 1000;
+    printf("ArrayList of %d ints: remove the odd ones, insert %d in the middle\n", n, k);
+    ArrayList<int> base, batch;
+    for (int i = 0; i < n; ++i) base.add(i);
+    for (int i = 0; i < k; ++i) batch.add(i);
+
+    Timer t;
+    ArrayList<int> a(base);
+    for (int i = 0; i < a.size(); )
+        if (is_odd(a.get(i))) a.removeIndex(i); else ++i;
+    printf("  removeIndex loop    %7.3fs\n", t.lap());
+    a = base;
+    t.lap();
+    ArrayList<int>::Iterator itr = a.iterator();
+    while (itr.hasNext())
+        if (is_odd(itr.next())) itr.remove();
+    sink = a.size();
+    printf("  Iterator::remove    %7.3fs\n", t.lap());
+    a = base;
+    t.lap();
+    a.removeIf(is_odd);
+    printf("  removeIf            %7.3fs\n", t.lap());
+
+    a = base;
+    t.lap();
+    for (int i = 0; i < k; ++i) a.add(n / 2 + i, batch.get(i));
+    printf("  add(index, x) loop  %7.3fs\n", t.lap());
+    a = base;
+    t.lap();
+    a.addAll(n / 2, batch);
+    printf("  addAll(index, list) %7.3fs\n", t.lap());
+}
+
+/*
+ * Searches a list of n elements for a missing value, reps times, with the kernel
+ * ArrayList uses and with the plain operator== loop
+ */
+template <class T>
+void search_kernel(const char *name, int n, int reps) {
+    ArrayList<T> a;
+    for (int i = 0; i < n; ++i) a.add((T) (i % 100));
+    vector<T> v;
+    for (int i = 0; i < n; ++i) v.push_back((T) (i % 100));
+    T miss = (T) 101;
+    Timer t;
+    long long s = 0;
+    for (int r = 0; r < reps; ++r) s += a.indexOf(miss) + a.count((T) 7);
+    double simd = t.lap();
+    for (int r = 0; r < reps; ++r)
+        s += Search<T, false>::indexOf(&v[0], n, miss) + Search<T, false>::count(&v[0], n, (T) 7);
+    double plain = t.lap();
+    sink = s;
+    printf("  %-8s indexOf+count  kernel %7.3fs  loop %7.3fs  (x%.1f)\n", name, simd, plain, plain / simd);
+}
+
+void bench_search() {
+    const int n = 4096, reps = 20000;
+    printf("Search of %d elements, %d times\n", n, reps);
+    search_kernel<char>("char", n, reps);
+    search_kernel<short>("short", n, reps);
+    search_kernel<int>("int", n, reps);
+    search_kernel<long long>("int64", n, reps);
+    search_kernel<float>("float", n, reps);
+    search_kernel<double>("double", n, reps);
+}
+
+/*
+ * Sustained queue traffic: the deque holds about window elements while ops
+ * elements pass through it
+ */
+void bench_deque_fifo() {
+    const int ops = 20000000;
+    printf("Deque as a FIFO, %d addLast + removeFirst\n", ops);
+    int windows[] = {16, 1000, 100000};
+    for (int w = 0; w < 3; ++w) {
+        int window = windows[w];
+        Timer t;
+        Deque<int> d;
+        Deque<int, BlockMap> b;
+        long long s = 0;
+        for (int i = 0; i < ops; ++i) {
+            d.addLast(i);
+            if (d.size() > window) {
+                s += d.getFirst();
+                d.removeFirst();
+            }
+        }
+        double mine = t.lap();
+        for (int i = 0; i < ops; ++i) {
+            b.addLast(i);
+            if (b.size() > window) {
+                s += b.getFirst();
+                b.removeFirst();
+            }
+        }
+        double blocks = t.lap();
+        std::deque<int> q;
+        for (int i = 0; i < ops; ++i) {
+            q.push_back(i);
+            if ((int) q.size() > window) {
+                s += q.front();
+                q.pop_front();
+            }
+        }
+        double stl = t.lap();
+        sink = s;
+        printf("  window %6d  Deque %7.3fs (capacity %6d)  BlockMap %7.3fs  std::deque %7.3fs\n",
+                window, mine, d.capacity(), blocks, stl);
+    }
+}
+
+/*
+ * The slowest single addLast() tells how long a growth stalls the caller.
+ */
+template <class D>
+void deque_growth(const char *name, int n) {
+    Timer t;
+    D *d = new D();
+    double worst = 0;
+    for (int i = 0; i < n; ++i) {
+        Timer one;
+        d->addLast(i);
+        double s = one.lap();
+        if (s > worst) worst = s;
+    }
+    double total = t.lap();
+    long long sum = 0;
+    for (int i = 0; i < n; i += 7) sum += d->get(i);
+    double get = t.lap();
+    sink = sum;
+    delete d;
+    printf("  %-10s total %7.3fs  slowest addLast %9.3fms  get %7.3fs\n", name, total, worst * 1e3, get);
+}
+
+void bench_deque_growth() {
+    const int n = 1 << 26;
+    printf("Deque growth, %d addLast of int\n", n);
+    deque_growth<Deque<int> >("RingBuffer", n);
+    deque_growth<Deque<int, BlockMap> >("BlockMap", n);
+}
+
+/*
+ * Insert and remove at random positions near the ends and in the middle
+ */
+template <class D>
+double deque_edits(int n, int ops, int spread) {
+    D d;
+    for (int i = 0; i < n; ++i) d.addLast(i);
+    Timer t;
+    for (int i = 0; i < ops; ++i) {
+        int k = next_rand() % spread;
+        int index = (i & 1) ? k : d.size() - k;
+        d.add(index, i);
+        d.removeIndex((i & 2) ? k : d.size() - 1 - k);
+    }
+    return t.lap();
+}
+
+void bench_deque_edits() {
+    const int n = 100000, ops = 20000;
+    printf("Deque of %d ints, %d add(index) + removeIndex(index) near either end, then anywhere\n", n, ops);
+    printf("  near ends  RingBuffer %7.3fs  BlockMap %7.3fs\n",
+            deque_edits<Deque<int> >(n, ops, 100), deque_edits<Deque<int, BlockMap> >(n, ops, 100));
+    printf("  anywhere   RingBuffer %7.3fs  BlockMap %7.3fs\n",
+            deque_edits<Deque<int> >(n, ops, n / 2), deque_edits<Deque<int, BlockMap> >(n, ops, n / 2));
+}
+
+/*----------------------------------------------------------------------*/
+
+struct Benchmark {
+    const char *name;
+    void (*run)();
+};
+
+Benchmark benchmarks[] = {
+    {"HashMapLookup", bench_hashmap_lookup},
+    {"HashMapRehash", bench_hashmap_rehash},
+    {"ConcurrentHashMap", bench_concurrent_hashmap},
+    {"CopiesMoves", bench_copies_moves},
+    {"ArrayListAppend", bench_arraylist_append},
+    {"ArrayListBulk", bench_arraylist_bulk},
+    {"Search", bench_search},
+    {"DequeFifo", bench_deque_fifo},
+    {"DequeGrowth", bench_deque_growth},
+    {"DequeEdits", bench_deque_edits},
+    {"Queues", bench_queues},
+    {"WorkStealing", bench_work_stealing},
+    {"ListNodes", bench_list_nodes},
+    {"ListSplice", bench_list_splice},
+    {"ListIndex", bench_list_index},
+    {"ListRandomIndex", bench_list_random_index},
+    {"IntrusiveList", bench_intrusive_list},
+    {"Heap", bench_heap},
+    {"HeapMeld", bench_heap_meld},
+    {"HeapBatch", bench_heap_batch},
+    {"ShortestPath", bench_shortest_path},
+};
+
+int main(int argc, char **argv) {
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+        if (argc < 2 || strstr(benchmarks[i].name, argv[1]) != NULL) {
+            benchmarks[i].run();
+            puts("");
+        }
+    return 0;
+}
@@ -28,13 +28,26 @@
 #include "TreeMap.h"
 #include "ArrayList.h"
 #include "LinkedList.h"
+#include "IntrusiveList.h"
 #include "Deque.h"
+#include "PriorityQueue.h"
+#include "ConcurrentHashMap.h"
+#include "ConcurrentQueue.h"
+#include "WorkStealingPool.h"
+#include "Search.h"
 
 #include <cstdlib>
 #include <vector>
+#include <deque>
 #include <ctime>
 #include <set>
+#include <map>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <limits>
+#include <thread>
 
 using UnitTest::TestCase;
 using UnitTest::TestFixture;
@@ -43,10 +56,47 @@ using UnitTest::TestException;
 using std::random_shuffle;
 using std::make_pair;
 using std::vector;
+using std::deque;
 using std::pair;
 using std::sort;
 using std::set;
 
+/*
+ * An element which counts how often it is copied and moved, for the tests of
+ * the move and emplace functions
+ */
+class MoveTestValue {
+	int v;
+	public:
+		static int copies, moves;
+		MoveTestValue(): v(0) {}
+		explicit MoveTestValue(int _v): v(_v) {}
+		MoveTestValue(int a, int b): v(a + b) {}
+		MoveTestValue(const MoveTestValue &x): v(x.v) { copies++; }
+		MoveTestValue(MoveTestValue &&x): v(x.v) { moves++; }
+		MoveTestValue &operator=(const MoveTestValue &x) {
+			v = x.v;
+			copies++;
+			return *this;
+		}
+		MoveTestValue &operator=(MoveTestValue &&x) {
+			v = x.v;
+			moves++;
+			return *this;
+		}
+		bool operator==(const MoveTestValue &x) const {
+			return v == x.v;
+		}
+		bool operator<(const MoveTestValue &x) const {
+			return v < x.v;
+		}
+		int get() const {
+			return v;
+		}
+};
+int MoveTestValue::copies = 0;
+int MoveTestValue::moves = 0;
+
 template <class List>
 class ListTest : public TestCase {/*{{{*/
     protected:
@@ -352,6 +402,767 @@ class ListTestRandomOperation: public ListTest<List> {/*{{{*/
         }
 };/*}}}*/
 
+/*
+ * Compares by the last two digits only, so that sort() and merge() have ties
+ * whose order can be checked
+ */
+struct ListTestLastDigits {
+    bool operator()(int a, int b) const {
+        return a % 100 < b % 100;
+    }
+};
+
+template <class List>
+class ListTestSplice: public ListTest<List> {/*{{{*/
+    private:
+        int times;
+
+        /*
+         * Check list against std
+         */
+        void check(List &list, const vector<int> &std) {
+            if (list.size() != (int) std.size())
+                throw TestException("the size of the list differs from the standard");
+            int k = 0;
+            for (typename List::Iterator it = list.iterator(); it.hasNext(); k++)
+                if (it.next() != std[k])
+                    throw TestException("the list differs from the standard");
+        }
+
+    public:
+        ListTestSplice(int _times, TestFixture *_fixture):
+            ListTest<List>("ListTestSplice", _fixture), times(_times) {}
+        ListTestSplice(string case_name, int _times, TestFixture *_fixture):
+            ListTest<List>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Splice, Sort and Merge...");
+            ListTest<List>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Splice, Sort and Merge...");
+            ListTest<List>::tear_down();
+        }
+
+        /*
+         * Four lists trade elements at random; the lists are deleted in a
+         * random order at the end, while others may still hold their nodes.
+         */
+        void run_test() {
+            srand(time(0));
+            ListTestLastDigits less;
+            List *list[4] = {this -> arr_ptr, new List(), new List(), new List()};
+            vector<int> std[4];
+            int splice_cnt = 0, sort_cnt = 0, merge_cnt = 0;
+            for (int i = 0; i < times; i++)
+            {
+                int a = rand() % 4, b = rand() % 4;
+                int opt = rand() % 12;
+                int na = std[a].size(), nb = std[b].size();
+                if (opt <= 2 || nb == 0)
+                {
+                    int idx = rand() % (na + 1), num = rand() % 1000;
+                    list[a] -> add(idx, num);
+                    std[a].insert(std[a].begin() + idx, num);
+                }
+                else if (opt == 3)
+                {
+                    int idx = rand() % nb;
+                    list[b] -> removeIndex(idx);
+                    std[b].erase(std[b].begin() + idx);
+                }
+                else if (opt <= 6)
+                {
+                    int from = rand() % nb, to = from + rand() % (nb - from + 1);
+                    int idx = rand() % (na + 1);
+                    if (a == b && idx > from && idx < to) continue;
+                    const int *p = to > from ? &list[b] -> get(from) : NULL;
+                    vector<int> part(std[b].begin() + from, std[b].begin() + to);
+                    if (opt == 6 && to > from)
+                    {
+                        to = from + 1;
+                        part.resize(1);
+                        list[a] -> splice(idx, *list[b], from);
+                    }
+                    else list[a] -> splice(idx, *list[b], from, to);
+                    std[b].erase(std[b].begin() + from, std[b].begin() + to);
+                    if (a == b && idx >= to) idx -= to - from;
+                    std[a].insert(std[a].begin() + idx, part.begin(), part.end());
+                    if (p != NULL && (a == b || to - from > List::Move_limit) && p != &list[a] -> get(idx))
+                        throw TestException("splice() should relink the nodes, "
+                                "not copy the elements");
+                    splice_cnt++;
+                }
+                else if (opt >= 10)
+                {
+                    /*
+                     * the forms taking iterators: where has returned idx
+                     * elements of a, first from and last to elements of b
+                     */
+                    int from = rand() % nb, to = opt == 10 ? from + 1 : from + rand() % (nb - from + 1);
+                    int idx = rand() % (na + 1);
+                    if (a == b && idx > from && idx < to) continue;
+                    typename List::Iterator where = list[a] -> iterator();
+                    typename List::Iterator first = list[b] -> iterator(), last = list[b] -> iterator();
+                    for (int k = 0; k < idx; k++) where.next();
+                    for (int k = 0; k < from; k++) first.next();
+                    for (int k = 0; k < to; k++) last.next();
+                    vector<int> part(std[b].begin() + from, std[b].begin() + to);
+                    if (opt == 10) list[a] -> splice(where, *list[b], last);
+                    else list[a] -> splice(where, *list[b], first, last, rand() % 2 ? to - from : -1);
+                    std[b].erase(std[b].begin() + from, std[b].begin() + to);
+                    if (a == b && idx >= to) idx -= to - from;
+                    std[a].insert(std[a].begin() + idx, part.begin(), part.end());
+                    if (a != b && from < (int) std[b].size() && last.next() != std[b][from])
+                        throw TestException("the iterator should stand where the moved elements were");
+                    splice_cnt++;
+                }
+                else if (opt == 7)
+                {
+                    if (a == b) continue;
+                    int idx = rand() % (na + 1);
+                    list[a] -> splice(idx, *list[b]);
+                    std[a].insert(std[a].begin() + idx, std[b].begin(), std[b].end());
+                    std[b].clear();
+                    splice_cnt++;
+                }
+                else if (opt == 8)
+                {
+                    list[a] -> sort(less);
+                    std::stable_sort(std[a].begin(), std[a].end(), less);
+                    sort_cnt++;
+                }
+                else
+                {
+                    list[a] -> sort(less);
+                    std::stable_sort(std[a].begin(), std[a].end(), less);
+                    list[b] -> sort(less);
+                    std::stable_sort(std[b].begin(), std[b].end(), less);
+                    list[a] -> merge(*list[b], less);
+                    if (a != b)
+                    {
+                        vector<int> merged(std[a].size() + std[b].size());
+                        std::merge(std[a].begin(), std[a].end(), std[b].begin(), std[b].end(),
+                                merged.begin(), less);
+                        std[a] = merged;
+                        std[b].clear();
+                    }
+                    merge_cnt++;
+                }
+                check(*list[a], std[a]);
+                check(*list[b], std[b]);
+            }
+            printf("Splice: %d\nSort:%d\nMerge:%d\n", splice_cnt, sort_cnt, merge_cnt);
+            /*
+             * A small splice moves the elements into new nodes, so the list
+             * they came from can give back all its memory
+             */
+            {
+                List x;
+                x.add(0);
+                int base = total_alloc_cnt;
+                List *y = new List();
+                for (int i = 0; i < 100; i++)
+                    y -> add(i);
+                x.splice(1, *y, 50);
+                delete y;
+                if (total_alloc_cnt > base + 1)
+                    throw TestException("a small splice keeps the memory of the other list");
+                if (x.size() != 2 || x.get(1) != 50)
+                    throw TestException("a small splice moves a wrong element");
+            }
+            int order[3] = {1, 2, 3};
+            random_shuffle(order, order + 3);
+            for (int k = 0; k < 3; k++)
+            {
+                delete list[order[k]];
+                check(*this -> arr_ptr, std[0]);
+                for (int i = 0; i < 100; i++)
+                    this -> arr_ptr -> add(i);
+                for (int i = 0; i < 100; i++)
+                    this -> arr_ptr -> removeLast();
+            }
+        }
+};/*}}}*/
+
+/*
+ * Removes the odd elements, for removeIf()
+ */
+struct ListTestIsOdd {
+    bool operator()(int x) const {
+        return x % 2 != 0;
+    }
+};
+
+template <class List>
+class ListTestBulk: public ListTest<List> {/*{{{*/
+    private:
+        int times;
+
+        /*
+         * The list may hold the gap of an unfinished pass; the const functions
+         * must read around it without moving any element.
+         */
+        void check(const vector<int> &std) {
+            const List &c = *this -> arr_ptr;
+            if (c.size() != (int) std.size())
+                throw TestException("the size of the list differs from the standard");
+            for (int i = 0; i < (int) std.size(); i++)
+                if (c.get(i) != std[i])
+                    throw TestException("the list differs from the standard");
+            int key = std.empty() || rand() % 4 == 0 ? rand() : std[rand() % std.size()];
+            int index = std::find(std.begin(), std.end(), key) - std.begin(), last = -1;
+            for (int i = 0; i < (int) std.size(); i++)
+                if (std[i] == key) last = i;
+            if (index == (int) std.size()) index = -1;
+            if (c.indexOf(key) != index || c.lastIndexOf(key) != last || c.contains(key) != (index >= 0)
+                    || c.count(key) != std::count(std.begin(), std.end(), key))
+                throw TestException("searching the list differs from the standard");
+            List copy(c);
+            for (int i = 0; i < (int) std.size(); i++)
+                if (copy.get(i) != std[i])
+                    throw TestException("the copy of the list differs from the standard");
+        }
+
+    public:
+        ListTestBulk(int _times, TestFixture *_fixture):
+            ListTest<List>("ListTestBulk", _fixture), times(_times) {}
+        ListTestBulk(string case_name, int _times, TestFixture *_fixture):
+            ListTest<List>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Bulk Operation...");
+            ListTest<List>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Bulk Operation...");
+            ListTest<List>::tear_down();
+        }
+
+        /*
+         * Iterator::remove() is called many times in one pass, and the list is
+         * read in the middle of some passes, or left with a pass unfinished.
+         */
+        void run_test() {
+            srand(time(0));
+            vector<int> std;
+            int bulk_cnt = 0, rm_cnt = 0;
+            for (int i = 0; i < times; i++)
+            {
+                int opt = rand() % 6;
+                int size = std.size();
+                if (opt == 0 || size < 10)
+                {
+                    vector<int> part(rand() % 20);
+                    for (int k = 0; k < (int) part.size(); k++)
+                        part[k] = rand();
+                    int idx = rand() % (size + 1);
+                    const int *p = part.empty() ? NULL : &part[0];
+                    this -> arr_ptr -> insertRange(idx, p, p + part.size());
+                    std.insert(std.begin() + idx, part.begin(), part.end());
+                }
+                else if (opt == 1)
+                {
+                    int from = rand() % (size + 1), to = from + rand() % (size - from + 1);
+                    this -> arr_ptr -> removeRange(from, to);
+                    std.erase(std.begin() + from, std.begin() + to);
+                }
+                else if (opt == 2)
+                {
+                    int removed = this -> arr_ptr -> removeIf(ListTestIsOdd());
+                    int n = std.size();
+                    std.erase(std::remove_if(std.begin(), std.end(), ListTestIsOdd()), std.end());
+                    if (removed != n - (int) std.size())
+                        throw TestException("removeIf() counts the removed elements wrong");
+                }
+                else if (opt == 3 && size < 1000)
+                {
+                    List other;
+                    for (int k = rand() % 20; k > 0; k--)
+                        other.add(rand());
+                    int idx = rand() % (size + 1);
+                    vector<int> part;
+                    if (rand() % 4 == 0) {
+                        part = std;
+                        this -> arr_ptr -> addAll(idx, *this -> arr_ptr);
+                    } else {
+                        for (int k = 0; k < other.size(); k++)
+                            part.push_back(other.get(k));
+                        if (rand() % 2) this -> arr_ptr -> addAll(idx, other);
+                        else {
+                            idx = size;
+                            this -> arr_ptr -> addAll(other);
+                        }
+                    }
+                    std.insert(std.begin() + idx, part.begin(), part.end());
+                }
+                else
+                {
+                    int k = 0, stop = rand() % 2 ? size : rand() % (size + 1);
+                    for (typename List::Iterator it = this -> arr_ptr -> iterator(); it.hasNext() && k < stop; )
+                    {
+                        if (it.next() != std[k])
+                            throw TestException("the iterator differs from the standard");
+                        if (rand() % 3 == 0) {
+                            it.remove();
+                            std.erase(std.begin() + k);
+                            rm_cnt++;
+                        }
+                        else k++;
+                        if (rand() % 50 == 0 && k < (int) std.size()
+                                && this -> arr_ptr -> get(k) != std[k])
+                            throw TestException("get() during an iteration differs "
+                                    "from the standard");
+                    }
+                }
+                bulk_cnt++;
+                check(std);
+            }
+            printf("Bulk: %d\nIterator Remove:%d\n", bulk_cnt, rm_cnt);
+        }
+};/*}}}*/
+
+/*
+ * A forward iterator over from, from + 1, ..., which takes no memory
+ */
+struct ListTestCounter {
+    long long v;
+    ListTestCounter(long long _v): v(_v) {}
+    int operator*() const { return (int) v; }
+    ListTestCounter &operator++() { ++v; return *this; }
+    bool operator!=(const ListTestCounter &x) const { return v != x.v; }
+};
+
+/*
+ * reserve(), shrinkToFit() and setGrowthFactor() of ArrayList
+ */
+template <class List>
+class ListTestCapacity: public ListTest<List> {/*{{{*/
+    private:
+        int times;
+
+        void check(int n, const char *msg) {
+            if (this -> arr_ptr -> size() != n)
+                throw TestException(msg);
+            for (int i = 0; i < n; i++)
+                if (this -> arr_ptr -> get(i) != i)
+                    throw TestException(msg);
+        }
+
+        /*
+         * Add elements until the list grows once, and check its new capacity
+         */
+        void grow(double factor, const char *msg) {
+            List &a = *this -> arr_ptr;
+            int cap = a.capacity();
+            while (a.size() < cap)
+                a.add(a.size());
+            a.add(a.size());
+            if (a.capacity() != std::max((int) (cap * factor), cap + 1))
+                throw TestException(msg);
+        }
+
+    public:
+        ListTestCapacity(int _times, TestFixture *_fixture):
+            ListTest<List>("ListTestCapacity", _fixture), times(_times) {}
+        ListTestCapacity(string case_name, int _times, TestFixture *_fixture):
+            ListTest<List>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Capacity...");
+            ListTest<List>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Capacity...");
+            ListTest<List>::tear_down();
+        }
+
+        void run_test() {
+            List &a = *this -> arr_ptr;
+            if (a.capacity() != 0)
+                throw TestException("an empty list should take no memory");
+            a.reserve(times);
+            if (a.capacity() < times)
+                throw TestException("reserve() makes too little room");
+            int cap = a.capacity();
+            a.add(0);
+            const int *first = &a.get(0);
+            for (int i = 1; i < times; i++)
+                a.add(i);
+            if (&a.get(0) != first || a.capacity() != cap)
+                throw TestException("adding within the reserved room moves the elements");
+            a.reserve(1);
+            if (a.capacity() != cap)
+                throw TestException("reserve() should never shrink the list");
+            check(times, "reserve() changes the elements");
+
+            a.removeRange(10, times);
+            a.shrinkToFit();
+            if (a.capacity() != 10)
+                throw TestException("shrinkToFit() leaves unused room");
+            check(10, "shrinkToFit() changes the elements");
+
+            grow(2, "the list should double its capacity by default");
+            a.setGrowthFactor(1.5);
+            grow(1.5, "setGrowthFactor() is not followed");
+            a.setGrowthFactor(1);
+            a.setGrowthFactor(-2);
+            grow(1.5, "a growth factor not above 1 should be ignored");
+            a.setGrowthFactor(1000);
+            grow(1000, "setGrowthFactor() is not followed");
+            check(a.size(), "growing the list changes the elements");
+
+            int n = a.size();
+            try {
+                a.insertRange(0, ListTestCounter(0), ListTestCounter(INT_MAX));
+                throw TestException("a list of more than INT_MAX elements should throw bad_alloc");
+            } catch (std::bad_alloc &) {}
+            check(n, "a failed insertRange() changes the elements");
+
+            a.clear();
+            a.shrinkToFit();
+            if (a.capacity() != 0)
+                throw TestException("shrinkToFit() on an empty list should give back the memory");
+            a.add(0);
+            check(1, "the list can not be reused after shrinkToFit()");
+        }
+};/*}}}*/
+
+template <class List>
+class ListTestFinger: public ListTest<List> {/*{{{*/
+    private:
+        int times;
+    public:
+        ListTestFinger(int _times, TestFixture *_fixture):
+            ListTest<List>("ListTestFinger", _fixture), times(_times) {}
+        ListTestFinger(string case_name, int _times, TestFixture *_fixture):
+            ListTest<List>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Finger...");
+            ListTest<List>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Finger...");
+            ListTest<List>::tear_down();
+        }
+
+        /*
+         * Positional accesses walk from the last one used, so each round sweeps
+         * the list forward or backward while editing both ends and the middle.
+         */
+        void run_test() {
+            srand(time(0));
+            deque<int> std;
+            for (int i = 0; i < 1000; i++) {
+                this -> arr_ptr -> add(i);
+                std.push_back(i);
+            }
+            int get_cnt = 0;
+            for (int t = 0; t < times; t++)
+            {
+                int size = std.size();
+                int pos = rand() % size;
+                int step = rand() % 2 ? 1 : -1;
+                for (int k = 0; k < 20 && pos >= 0 && pos < size; k++, pos += step)
+                {
+                    if (this -> arr_ptr -> get(pos) != std[pos])
+                        throw TestException("get() near the finger differs "
+                                "from the standard");
+                    get_cnt++;
+                    int opt = rand() % 8;
+                    int num = rand();
+                    if (opt == 0) {
+                        this -> arr_ptr -> addFirst(num);
+                        std.push_front(num);
+                        pos++;
+                    } else if (opt == 1) {
+                        this -> arr_ptr -> addLast(num);
+                        std.push_back(num);
+                    } else if (opt == 2 && pos > 0) {
+                        this -> arr_ptr -> removeFirst();
+                        std.pop_front();
+                        pos--;
+                    } else if (opt == 3 && pos < size - 1) {
+                        this -> arr_ptr -> removeLast();
+                        std.pop_back();
+                    } else if (opt == 4) {
+                        this -> arr_ptr -> set(pos, num);
+                        std[pos] = num;
+                    } else if (opt == 5) {
+                        int idx = rand() % (size + 1);
+                        this -> arr_ptr -> add(idx, num);
+                        std.insert(std.begin() + idx, num);
+                        if (idx <= pos) pos++;
+                    } else if (opt == 6 && size > 1) {
+                        int idx = rand() % size;
+                        if (idx == pos) continue;
+                        this -> arr_ptr -> removeIndex(idx);
+                        std.erase(std.begin() + idx);
+                        if (idx < pos) pos--;
+                    }
+                    size = std.size();
+                }
+                if (this -> arr_ptr -> size() != (int) std.size())
+                    throw TestException("the size of the list differs from the standard");
+            }
+            int k = 0;
+            for (typename List::Iterator it = this -> arr_ptr -> iterator(); it.hasNext(); k++)
+                if (it.next() != std[k])
+                    throw TestException("the iterator differs from the standard");
+            printf("Get:%d\n", get_cnt);
+        }
+};/*}}}*/
+
+/*
+ * The list holds MoveTestValue; every element goes in by add(T&&) or emplace,
+ * so none may ever be copied.
+ */
+template <class List>
+class ListTestMove: public ListTest<List> {/*{{{*/
+    private:
+        int times;
+
+        void check(List &a, int from, int n, const char *msg) {
+            if (a.size() != n || a.isEmpty() != (n == 0))
+                throw TestException(msg);
+            int k = from;
+            for (typename List::Iterator it = a.iterator(); it.hasNext(); k++)
+                if (it.next().get() != k)
+                    throw TestException(msg);
+            if (k != from + n)
+                throw TestException(msg);
+        }
+
+        void check_copies() {
+            if (MoveTestValue::copies != 0)
+                throw TestException("an element is copied where it should be moved");
+        }
+
+    public:
+        ListTestMove(int _times, TestFixture *_fixture) :
+            ListTest<List>("ListTestMove", _fixture), times(_times) {}
+        ListTestMove(string case_name, int _times, TestFixture *_fixture) :
+            ListTest<List>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Move and Emplace...");
+            MoveTestValue::copies = MoveTestValue::moves = 0;
+            ListTest<List>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Move and Emplace...");
+            ListTest<List>::tear_down();
+        }
+
+        void run_test() {
+            List &a = *this -> arr_ptr;
+            for (int i = 0; i < times; i++) {
+                if (i % 4 == 0) a.add(MoveTestValue(i));
+                else if (i % 4 == 1) a.emplace(i);
+                else if (i % 4 == 2) a.emplace(i, 0);
+                else a.add(a.size(), MoveTestValue(i));
+            }
+            check(a, 0, times, "add(T&&) or emplace gives a wrong list");
+            check_copies();
+
+            List b(std::move(a));
+            check(a, 0, 0, "the moved-from list should be empty");
+            check(b, 0, times, "the move-constructor loses elements");
+            a.add(MoveTestValue(-1));
+            check(a, -1, 1, "the moved-from list can not be reused");
+
+            List &self = b;
+            b = std::move(self);
+            check(b, 0, times, "self-move-assignment changes the list");
+
+            a.swap(b);
+            check(a, 0, times, "swap() gives wrong elements");
+            check(b, -1, 1, "swap() gives wrong elements");
+
+            b = std::move(a);
+            check(a, 0, 0, "the moved-from list should be empty");
+            check(b, 0, times, "the move assignment loses elements");
+            a.emplace(-1);
+            check(a, -1, 1, "the moved-from list can not be reused");
+            check_copies();
+
+            /*
+             * a pass of Iterator::remove() left unfinished may leave a gap in
+             * the list; reading the list must not move the elements behind it
+             */
+            typename List::Iterator it = b.iterator();
+            for (int k = 0; k < times / 2; k++) {
+                it.next();
+                if (k % 3 == 0) it.remove();
+            }
+            const List &c = b;
+            int moves = MoveTestValue::moves, n = 0;
+            for (int k = 0; k < times; k++) {
+                if (k < times / 2 && k % 3 == 0) continue;
+                if (c.get(n++).get() != k)
+                    throw TestException("get() after Iterator::remove() gives wrong elements");
+            }
+            if (n != c.size() || !c.contains(MoveTestValue(times - 1)) || c.contains(MoveTestValue(0)))
+                throw TestException("contains() after Iterator::remove() gives wrong results");
+            if (MoveTestValue::moves != moves)
+                throw TestException("a const function moves the elements");
+        }
+};/*}}}*/
+
+struct IntrusiveListTestTag {};
+
+/*
+ * An object in three lists at once: through the two base hooks and the member
+ */
+struct IntrusiveListTestItem: ListHook<>, ListHook<IntrusiveListTestTag> {
+    int value;
+    ListHook<> member;
+    IntrusiveListTestItem(): value(0) {}
+};
+
+class IntrusiveListTest: public TestCase {/*{{{*/
+    private:
+        int times;
+
+        typedef IntrusiveList<IntrusiveListTestItem> ListA;
+        typedef IntrusiveList<IntrusiveListTestItem,
+                BaseHook<IntrusiveListTestItem, IntrusiveListTestTag> > ListB;
+        typedef IntrusiveList<IntrusiveListTestItem,
+                MemberHook<IntrusiveListTestItem, &IntrusiveListTestItem::member> > ListC;
+
+        template <class List>
+        void check(List &list, const deque<int> &std) {
+            if (list.size() != (int) std.size())
+                throw TestException("the size of the intrusive list "
+                        "differs from the standard");
+            int k = 0;
+            for (typename List::Iterator it = list.iterator(); it.hasNext(); k++)
+                if (it.next().value != std[k])
+                    throw TestException("the intrusive list differs from the standard");
+        }
+
+        /*
+         * One random operation on list, whose elements are also in std
+         */
+        template <class List, class Hook>
+        void operate(List &list, deque<int> &std, vector<IntrusiveListTestItem> &items) {
+            int opt = rand() % 6;
+            IntrusiveListTestItem &e = items[rand() % items.size()];
+            Hook &h = e;
+            if (h.isLinked() && opt == 5) {
+                bool flag = false;
+                try
+                {
+                    if (rand() % 2) list.add(e);
+                    else list.insertBefore(list.getFirst(), e);
+                }
+                catch (ElementExist)
+                {
+                    flag = true;
+                }
+                if (!flag)
+                    throw TestException("adding an element which is linked already "
+                            "should throw ElementExist");
+            } else if (!h.isLinked()) {
+                if (opt <= 1 || std.empty()) {
+                    list.addFirst(e);
+                    std.push_front(e.value);
+                } else if (opt <= 3) {
+                    list.add(e);
+                    std.push_back(e.value);
+                } else {
+                    int idx = rand() % std.size();
+                    IntrusiveListTestItem *pos = &items[std[idx]];
+                    if (opt == 4) {
+                        list.insertBefore(*pos, e);
+                        std.insert(std.begin() + idx, e.value);
+                    } else {
+                        list.insertAfter(*pos, e);
+                        std.insert(std.begin() + idx + 1, e.value);
+                    }
+                }
+            } else if (opt == 0) {
+                list.removeFirst();
+                std.pop_front();
+            } else if (opt == 1) {
+                list.removeLast();
+                std.pop_back();
+            } else {
+                list.remove(e);
+                std.erase(std::find(std.begin(), std.end(), e.value));
+            }
+        }
+
+    public:
+        IntrusiveListTest(int _times, TestFixture *_fixture):
+            TestCase("IntrusiveListTest", _fixture), times(_times) {}
+        IntrusiveListTest(string case_name, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Intrusive List...");
+            this -> start_memory_watching();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Intrusive List...");
+            this -> stop_memory_watching();
+        }
+
+        void run_test() {
+            srand(time(0));
+            vector<IntrusiveListTestItem> items(200);
+            for (int i = 0; i < (int) items.size(); i++)
+                items[i].value = i;
+            deque<int> std_a, std_b, std_c;
+            {
+                ListA a;
+                ListB b;
+                ListC c;
+                for (int i = 0; i < times; i++)
+                {
+                    operate<ListA, ListHook<> >(a, std_a, items);
+                    operate<ListB, ListHook<IntrusiveListTestTag> >(b, std_b, items);
+                    IntrusiveListTestItem &e = items[rand() % items.size()];
+                    if (!e.member.isLinked()) {
+                        c.add(e);
+                        std_c.push_back(e.value);
+                    } else {
+                        c.remove(e);
+                        std_c.erase(std::find(std_c.begin(), std_c.end(), e.value));
+                    }
+                    if (i % 100 == 0) {
+                        check(a, std_a);
+                        check(b, std_b);
+                        check(c, std_c);
+                    }
+                }
+                for (ListA::Iterator it = a.iterator(); it.hasNext(); )
+                    if (it.next().value % 2 == 0) it.remove();
+                for (int i = 0; i < (int) std_a.size(); )
+                    if (std_a[i] % 2 == 0) std_a.erase(std_a.begin() + i);
+                    else i++;
+                check(a, std_a);
+                ListA moved(std::move(a));
+                check(moved, std_a);
+                check(a, deque<int>());
+                b.clear();
+                for (int i = 0; i < (int) items.size(); i++)
+                    if (static_cast<ListHook<IntrusiveListTestTag> &>(items[i]).isLinked())
+                        throw TestException("clear() should unlink every element");
+            }
+            for (int i = 0; i < (int) items.size(); i++)
+                if (static_cast<ListHook<> &>(items[i]).isLinked() || items[i].member.isLinked())
+                    throw TestException("the destructor should unlink every element");
+        }
+};/*}}}*/
+
 /*{{{ Map Tester thanks to Liao Chao */
 template <class Map>
 class MapTest: public TestCase { /*{{{*/
@@ -585,25 +1396,371 @@ class MapTestAllRandomly: public MapTest <Map> {/*{{{*/
 			}
 			puts("OK\n");
 		}
-};/*}}}*/ /*}}}*/
-
+};/*}}}*/
 
-template <class Deque>
-class DequeTest : public TestCase {/*{{{*/
-    protected:
-        Deque *arr_ptr;
-    public:
-        DequeTest(TestFixture *_fixture) : 
-            TestCase("DequeTest", _fixture) {}
-        DequeTest(string case_name, TestFixture *_fixture) : 
-            TestCase(case_name, _fixture) {}
+template <class Map>
+class MapTestRehash: public MapTest <Map> {/*{{{*/
+	private:
+		int times;
+
+		/*
+		 * Check that the map holds exactly the keys in std, each with its
+		 * value, through both get() and the iterator.
+		 */
+		void check(const std::map <int, int> &std) {
+			if (this->map_ptr->size() != (int)std.size()) {
+				throw TestException("Ooooops, the size() function "\
+						"goes wrong during the rehash!!!");
+			}
+			for (std::map <int, int>::const_iterator e = std.begin(); e != std.end(); ++e) {
+				if (!this->map_ptr->containsKey(e->first) || this->map_ptr->get(e->first) != e->second) {
+					throw TestException("Ooooops, the get() function of the Map "\
+							"goes wrong during the rehash!!!");
+				}
+			}
+			int counter = 0;
+			for (typename Map::Iterator it = this->map_ptr->iterator(); it.hasNext(); counter++) {
+				typename Map::Entry tmp = it.next();
+				std::map <int, int>::const_iterator e = std.find(tmp.getKey());
+				if (e == std.end() || e->second != tmp.getValue()) {
+					throw TestException("Ooooops, the Iterator of the Map "\
+							"goes wrong during the rehash!!!");
+				}
+			}
+			if (counter != (int)std.size()) {
+				throw TestException("Ooooops, the Iterator of the Map "\
+						"misses entries during the rehash!!!");
+			}
+		}
 
-        void print_array_list() {
-            int ra = rand() % 2;
-            if (ra == 0) {
-                for (int i = 0; i < arr_ptr -> size(); i++)
-                    printf("%d ", arr_ptr -> get(i));
-                puts("");
+	public:
+		MapTestRehash(int _times, TestFixture *_fixture):
+			MapTest <Map>("MapTestRehash", _fixture), times(_times) {}
+		MapTestRehash(string case_name, int _times, TestFixture *_fixture):
+			MapTest <Map>(case_name, _fixture), times(_times) {}
+
+		void set_up() {
+			puts("== Now Preparing to test the incremental rehash...");
+			MapTest <Map>::set_up();
+		}
+
+		void tear_down() {
+			puts("== Finishing the test...");
+			MapTest <Map>::tear_down();
+		}
+
+		/*
+		 * Grow the map at once to about 1000 buckets, then start a growth one
+		 * bucket per put(), so the old and the new table stay live for a while.
+		 */
+		void run_test() {
+			srand(time(0));
+			std::map <int, int> std;
+			int key = 0;
+			this->map_ptr->setRehashBudget(0);
+			for (; key < 1000; key++) {
+				std[key * 7] = rand();
+				this->map_ptr->put(key * 7, std[key * 7]);
+			}
+			this->map_ptr->setRehashBudget(1);
+			int cap = this->map_ptr->capacity();
+			while (this->map_ptr->capacity() == cap) {
+				std[key * 7] = rand();
+				this->map_ptr->put(key * 7, std[key * 7]);
+				key++;
+			}
+			cap = this->map_ptr->capacity();
+
+			puts("checking get() and the Iterator with both tables live:");
+			for (int i = 0; i < 100; i++) {
+				int k = rand() % key * 7;
+				if (rand() % 2 && std.count(k)) {
+					std.erase(k);
+					this->map_ptr->remove(k);
+				} else {
+					std[k] = rand();
+					this->map_ptr->put(k, std[k]);
+				}
+			}
+			check(std);
+			puts("OK\n");
+
+			puts("checking a map which becomes read-only during the rehash:");
+			for (int t = 0; t < 3; t++) {
+				check(std);
+			}
+			if (this->map_ptr->capacity() != cap) {
+				throw TestException("Ooooops, get() should not move the buckets!!!");
+			}
+			puts("OK\n");
+
+			puts("checking setRehashBudget(0) during the rehash:");
+			this->map_ptr->setRehashBudget(0);
+			for (int i = 0; i < times; i++, key++) {
+				std[key * 7] = i;
+				this->map_ptr->put(key * 7, i);
+			}
+			if (this->map_ptr->capacity() < this->map_ptr->size()) {
+				throw TestException("Ooooops, the map stopped growing "\
+						"after the budget changed!!!");
+			}
+			check(std);
+			puts("OK\n");
+
+			puts("checking a budget of INT_MAX (10 * budget empty buckets may be visited):");
+			this->map_ptr->setRehashBudget(INT_MAX);
+			for (int i = 0; i < times; i++, key++) {
+				std[key * 7] = i;
+				this->map_ptr->put(key * 7, i);
+			}
+			check(std);
+			puts("OK\n");
+		}
+};/*}}}*/
+
+/*
+ * A map value without a default constructor, which counts its live copies
+ */
+class MapTestValue {
+	int v;
+	public:
+		static int live;
+		explicit MapTestValue(int _v): v(_v) { live++; }
+		MapTestValue(const MapTestValue &x): v(x.v) { live++; }
+		~MapTestValue() { live--; }
+		MapTestValue &operator=(const MapTestValue &x) {
+			v = x.v;
+			return *this;
+		}
+		bool operator==(const MapTestValue &x) const {
+			return v == x.v;
+		}
+		int get() const {
+			return v;
+		}
+};
+int MapTestValue::live = 0;
+
+/*
+ * HashMap(c) should hold c elements before its first growth, whatever the policy
+ */
+template <class Map>
+class MapTestCapacity: public TestCase {/*{{{*/
+	private:
+		int times;
+
+	public:
+		MapTestCapacity(int _times, TestFixture *_fixture):
+			TestCase("MapTestCapacity", _fixture), times(_times) {}
+		MapTestCapacity(string case_name, int _times, TestFixture *_fixture):
+			TestCase(case_name, _fixture), times(_times) {}
+
+		void set_up() {
+			puts("== Now Preparing to test the constructor with a capacity...");
+			this -> start_memory_watching();
+		}
+
+		void tear_down() {
+			puts("== Finishing the test...");
+			this -> stop_memory_watching();
+		}
+
+		void run_test() {
+			srand(time(0));
+			for (int t = 0; t < times; t++) {
+				int c = t < 70 ? t : rand() % 5000;
+				Map a(c);
+				int cap = a.capacity();
+				for (int i = 0; i < c; i++) {
+					a.put(i, i);
+				}
+				if (a.capacity() != cap) {
+					throw TestException("Ooooops, HashMap(c) grows before it holds c elements!!!");
+				}
+				if (cap > 3 * c + 32) {
+					throw TestException("Ooooops, HashMap(c) takes a far larger table than needed!!!");
+				}
+			}
+		}
+};/*}}}*/
+
+/*
+ * The values are MoveTestValue; they go in by put(K, V&&) or putEmplace, so none
+ * may ever be copied, however the map grows.
+ */
+template <class Map>
+class MapTestMove: public MapTest <Map> {/*{{{*/
+	private:
+		int times;
+
+		void check(Map &a, int n, int delta, const char *msg) {
+			if (a.size() != n || a.isEmpty() != (n == 0)) {
+				throw TestException(msg);
+			}
+			for (int i = 0; i < n; i++) {
+				if (!a.containsKey(i) || a.get(i).get() != i + (i % 2 == 0 ? delta : 0)) {
+					throw TestException(msg);
+				}
+			}
+		}
+
+		void check_copies() {
+			if (MoveTestValue::copies != 0) {
+				throw TestException("Ooooops, a value is copied where it should be moved!!!");
+			}
+		}
+
+	public:
+		MapTestMove(int _times, TestFixture *_fixture):
+			MapTest <Map>("MapTestMove", _fixture), times(_times) {}
+		MapTestMove(string case_name, int _times, TestFixture *_fixture):
+			MapTest <Map>(case_name, _fixture), times(_times) {}
+
+		void set_up() {
+			puts("== Now Preparing to test move and putEmplace...");
+			MoveTestValue::copies = MoveTestValue::moves = 0;
+			MapTest <Map>::set_up();
+		}
+
+		void tear_down() {
+			puts("== Finishing the test...");
+			MapTest <Map>::tear_down();
+		}
+
+		void run_test() {
+			Map &a = *this->map_ptr;
+			puts("checking put(K, V&&) and putEmplace():");
+			for (int i = 0; i < times; i++) {
+				if (i % 3 == 0) a.put(i, MoveTestValue(i));
+				else if (i % 3 == 1) a.putEmplace(i, i);
+				else a.putEmplace(i, i, 0);
+			}
+			check(a, times, 0, "Ooooops, put() or putEmplace() gives a wrong map!!!");
+			for (int i = 0; i < times; i += 2) {
+				a.putEmplace(i, i, 1);
+			}
+			check(a, times, 1, "Ooooops, putEmplace() does not overwrite the value!!!");
+			for (int i = 0; i < times; i += 2) {
+				a.put(i, MoveTestValue(i + 2));
+			}
+			check(a, times, 2, "Ooooops, put() does not overwrite the value!!!");
+			check_copies();
+			puts("OK\n");
+
+			puts("checking the move functions and swap():");
+			Map b(std::move(a));
+			check(a, 0, 0, "Ooooops, the moved-from map should be empty!!!");
+			check(b, times, 2, "Ooooops, the move-constructor loses values!!!");
+			a.putEmplace(0, 0);
+			check(a, 1, 0, "Ooooops, the moved-from map can not be reused!!!");
+
+			Map &self = b;
+			b = std::move(self);
+			check(b, times, 2, "Ooooops, self-move-assignment changes the map!!!");
+
+			a.swap(b);
+			check(a, times, 2, "Ooooops, swap() gives wrong values!!!");
+			check(b, 1, 0, "Ooooops, swap() gives wrong values!!!");
+
+			b = std::move(a);
+			check(a, 0, 0, "Ooooops, the moved-from map should be empty!!!");
+			check(b, times, 2, "Ooooops, the move assignment loses values!!!");
+			a.put(0, MoveTestValue(0));
+			check(a, 1, 0, "Ooooops, the moved-from map can not be reused!!!");
+			check_copies();
+			puts("OK\n");
+		}
+};/*}}}*/
+
+template <class Map>
+class MapTestDestroy: public MapTest <Map> {/*{{{*/
+	private:
+		int times;
+
+		void check_live(const char *msg) {
+			if (MapTestValue::live != this->map_ptr->size()) {
+				throw TestException(msg);
+			}
+		}
+
+	public:
+		MapTestDestroy(int _times, TestFixture *_fixture):
+			MapTest <Map>("MapTestDestroy", _fixture), times(_times) {}
+		MapTestDestroy(string case_name, int _times, TestFixture *_fixture):
+			MapTest <Map>(case_name, _fixture), times(_times) {}
+
+		void set_up() {
+			puts("== Now Preparing to test the destruction of the values...");
+			MapTestValue::live = 0;
+			MapTest <Map>::set_up();
+		}
+
+		void tear_down() {
+			puts("== Finishing the test...");
+			MapTest <Map>::tear_down();
+		}
+
+		void run_test() {
+			srand(time(0));
+			puts("checking put() and the growth:");
+			for (int i = 0; i < times; i++) {
+				this->map_ptr->put(i, MapTestValue(i));
+			}
+			check_live("Ooooops, put() leaves values behind!!!");
+			for (int i = 0; i < times; i++) {
+				this->map_ptr->put(rand() % times, MapTestValue(-1));
+			}
+			check_live("Ooooops, overwriting a value leaves it behind!!!");
+			puts("OK\n");
+
+			puts("checking remove() function:");
+			for (int i = 0; i < times; i += 2) {
+				this->map_ptr->remove(i);
+			}
+			check_live("Ooooops, remove() does not destroy the value!!!");
+			for (int i = 1; i < times; i += 2) {
+				if (!this->map_ptr->containsKey(i)) {
+					throw TestException("Ooooops, remove() removes the wrong key!!!");
+				}
+			}
+			puts("OK\n");
+
+			puts("checking clear() function and the destructor:");
+			{
+				Map copy(*this->map_ptr);
+				this->map_ptr->clear();
+				if (MapTestValue::live != copy.size()) {
+					throw TestException("Ooooops, clear() does not destroy the values!!!");
+				}
+			}
+			check_live("Ooooops, the destructor does not destroy the values!!!");
+			for (int i = 0; i < times; i++) {
+				this->map_ptr->put(i, MapTestValue(i));
+			}
+			delete this->map_ptr;
+			this->map_ptr = new Map();
+			check_live("Ooooops, the destructor does not destroy the values!!!");
+			puts("OK\n");
+		}
+};/*}}}*/ /*}}}*/
+
+
+template <class Deque>
+class DequeTest : public TestCase {/*{{{*/
+    protected:
+        Deque *arr_ptr;
+    public:
+        DequeTest(TestFixture *_fixture) : 
+            TestCase("DequeTest", _fixture) {}
+        DequeTest(string case_name, TestFixture *_fixture) : 
+            TestCase(case_name, _fixture) {}
+
+        void print_array_list() {
+            int ra = rand() % 2;
+            if (ra == 0) {
+                for (int i = 0; i < arr_ptr -> size(); i++)
+                    printf("%d ", arr_ptr -> get(i));
+                puts("");
 
                 for (typename Deque::Iterator it = arr_ptr -> iterator();
                         it.hasNext();)
@@ -923,5 +2080,1061 @@ class DequeTestDescendingIterator: public DequeTest<Deque> {/*{{{*/
         }
 };/*}}}*/
 
+template <class Deque>
+class DequeTestRandomOperation: public DequeTest<Deque> {/*{{{*/
+    private:
+        int times;
+    public:
+        DequeTestRandomOperation(int _times, TestFixture *_fixture):
+            DequeTest<Deque>("DequeTestRandomOperation", _fixture), times(_times) {}
+        DequeTestRandomOperation(string case_name, int _times, TestFixture *_fixture):
+            DequeTest<Deque>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Random Operation...");
+            DequeTest<Deque>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Random Operation...");
+            DequeTest<Deque>::tear_down();
+        }
+
+        /*
+         * The odd rounds are queue-like (add at one end, remove at the other),
+         * so the elements wrap around the ends of the buffer.
+         */
+        void run_test() {
+            deque<int> std;
+            int add_cnt = 0, rm_cnt = 0, set_cnt = 0, get_cnt = 0;
+            for (int r = 0; r < 6; r++)
+            {
+                srand(time(0) + r);
+                for (int i = 0; i < times; i++)
+                {
+                    int opt = rand() % 10;
+                    int size = std.size();
+                    if (!size || opt >= 6 || (r % 2 == 1 && opt >= 4 && size < 50))
+                    {
+                        int num = rand();
+                        if (r % 2 == 1 || rand() % 2) {
+                            this -> arr_ptr -> addLast(num);
+                            std.push_back(num);
+                        } else {
+                            this -> arr_ptr -> addFirst(num);
+                            std.push_front(num);
+                        }
+                        add_cnt++;
+                    }
+                    else if (opt >= 4)
+                    {
+                        if (r % 2 == 1 || rand() % 2) {
+                            this -> arr_ptr -> removeFirst();
+                            std.pop_front();
+                        } else {
+                            this -> arr_ptr -> removeLast();
+                            std.pop_back();
+                        }
+                        rm_cnt++;
+                    }
+                    else if (opt <= 1)
+                    {
+                        int idx = rand() % size;
+                        int num = rand();
+                        this -> arr_ptr -> set(idx, num);
+                        std[idx] = num;
+                        set_cnt++;
+                    }
+                    else
+                    {
+                        int idx = rand() % size;
+                        if (this -> arr_ptr -> get(idx) != std[idx]
+                                || this -> arr_ptr -> getFirst() != std.front()
+                                || this -> arr_ptr -> getLast() != std.back()
+                                || !this -> arr_ptr -> contains(std[idx]))
+                            throw TestException("the answer from the deque "
+                                    "differs from the standard");
+                        get_cnt++;
+                    }
+                    if (this -> arr_ptr -> size() != (int) std.size())
+                        throw TestException("the size of the deque "
+                                "differs from the standard");
+                }
+                int k = 0;
+                for (typename Deque::Iterator it = this -> arr_ptr -> iterator(); it.hasNext(); k++)
+                    if (it.next() != std[k])
+                        throw TestException("the iterator differs from the standard");
+                printf("Add: %d\nRemove:%d\nSet:%d\nGet:%d\n", add_cnt, rm_cnt, set_cnt, get_cnt);
+                if (r % 2 == 0) {
+                    puts("All cleared.");
+                    std.clear();
+                    this -> arr_ptr -> clear();
+                }
+            }
+        }
+};/*}}}*/
+
+/*
+ * The deque holds MoveTestValue; every element goes in by addFirst/addLast(T&&)
+ * or emplaceFirst/emplaceLast, so none may ever be copied.
+ */
+template <class Deque>
+class DequeTestMove: public DequeTest<Deque> {/*{{{*/
+    private:
+        int times;
+
+        void check(Deque &a, const vector<int> &all, const char *msg) {
+            if (a.size() != (int)all.size() || a.isEmpty() != all.empty())
+                throw TestException(msg);
+            int k = 0;
+            for (typename Deque::Iterator it = a.iterator(); it.hasNext(); k++)
+                if (it.next().get() != all[k])
+                    throw TestException(msg);
+        }
+
+        void check_copies() {
+            if (MoveTestValue::copies != 0)
+                throw TestException("an element is copied where it should be moved");
+        }
+
+    public:
+        DequeTestMove(int _times, TestFixture *_fixture) :
+            DequeTest<Deque>("DequeTestMove", _fixture), times(_times) {}
+        DequeTestMove(string case_name, int _times, TestFixture *_fixture) :
+            DequeTest<Deque>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Move and Emplace...");
+            MoveTestValue::copies = MoveTestValue::moves = 0;
+            DequeTest<Deque>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Move and Emplace...");
+            DequeTest<Deque>::tear_down();
+        }
+
+        void run_test() {
+            Deque &a = *this -> arr_ptr;
+            deque<int> both;
+            for (int i = 1; i <= times; i++) {
+                if (i % 2) a.emplaceLast(i);
+                else a.addLast(MoveTestValue(i));
+                if (i % 2) a.emplaceFirst(-i, 0);
+                else a.addFirst(MoveTestValue(-i));
+                both.push_back(i);
+                both.push_front(-i);
+            }
+            vector<int> all(both.begin(), both.end()), none, one(1, 0);
+            check(a, all, "addFirst/addLast(T&&) or emplace gives a wrong deque");
+            check_copies();
+
+            Deque b(std::move(a));
+            check(a, none, "the moved-from deque should be empty");
+            check(b, all, "the move-constructor loses elements");
+            a.emplaceFirst(0);
+            check(a, one, "the moved-from deque can not be reused");
+
+            Deque &self = b;
+            b = std::move(self);
+            check(b, all, "self-move-assignment changes the deque");
+
+            a.swap(b);
+            check(a, all, "swap() gives wrong elements");
+            check(b, one, "swap() gives wrong elements");
+
+            b = std::move(a);
+            check(a, none, "the moved-from deque should be empty");
+            check(b, all, "the move assignment loses elements");
+            a.addLast(MoveTestValue(0));
+            check(a, one, "the moved-from deque can not be reused");
+            check_copies();
+        }
+};/*}}}*/
+
+/*
+ * indexOf, lastIndexOf, count and contains against the standard, on a deque
+ * which grows at both ends, so its elements wrap around the end of the buffer
+ */
+template <class Deque>
+class DequeTestSearch: public DequeTest<Deque> {/*{{{*/
+    private:
+        int times;
+    public:
+        DequeTestSearch(int _times, TestFixture *_fixture) :
+            DequeTest<Deque>("DequeTestSearch", _fixture), times(_times) {}
+        DequeTestSearch(string case_name, int _times, TestFixture *_fixture) :
+            DequeTest<Deque>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Search...");
+            DequeTest<Deque>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Search...");
+            DequeTest<Deque>::tear_down();
+        }
+
+        void run_test() {
+            srand(time(0));
+            deque<int> std;
+            for (int i = 0; i < times; i++) {
+                int opt = rand() % 10, upper = std.size() < 300 ? 6 : 3;
+                if (std.empty() || opt < upper) {
+                    int num = rand() % 10;
+                    if (rand() % 2) {
+                        this -> arr_ptr -> addFirst(num);
+                        std.push_front(num);
+                    } else {
+                        this -> arr_ptr -> addLast(num);
+                        std.push_back(num);
+                    }
+                } else if (rand() % 2) {
+                    this -> arr_ptr -> removeFirst();
+                    std.pop_front();
+                } else {
+                    this -> arr_ptr -> removeLast();
+                    std.pop_back();
+                }
+                int key = rand() % 11;
+                deque<int>::iterator first = std::find(std.begin(), std.end(), key);
+                int index = first == std.end() ? -1 : first - std.begin();
+                int last = -1;
+                for (int k = (int)std.size() - 1; k >= 0; k--)
+                    if (std[k] == key) {
+                        last = k;
+                        break;
+                    }
+                if (this -> arr_ptr -> indexOf(key) != index)
+                    throw TestException("indexOf() differs from the standard");
+                if (this -> arr_ptr -> lastIndexOf(key) != last)
+                    throw TestException("lastIndexOf() differs from the standard");
+                if (this -> arr_ptr -> count(key) != std::count(std.begin(), std.end(), key))
+                    throw TestException("count() differs from the standard");
+                if (this -> arr_ptr -> contains(key) != (index >= 0))
+                    throw TestException("contains() differs from the standard");
+            }
+        }
+};/*}}}*/
+
+/*
+ * The values the search tests fill their arrays with; the last one is never
+ * put in an array, so searching for it finds nothing
+ */
+template <class T, bool Float = std::is_floating_point<T>::value>
+struct SearchTestValues {
+    static const int Size = 5;
+    static T get(int r) {
+        static const T v[Size] = {0, 1, (T) -1, (T) 0x55, 100};
+        return v[r];
+    }
+};
+
+/*
+ * For floating point, NaN (which equals nothing) and both zeros (which are equal)
+ */
+template <class T>
+struct SearchTestValues<T, true> {
+    static const int Size = 5;
+    static T get(int r) {
+        static const T v[Size] = {0.0, -0.0, std::numeric_limits<T>::quiet_NaN(), 1.5, -1.5};
+        return v[r];
+    }
+};
+
+/*
+ * Search<T> and each of its kernels against the plain loop
+ */
+template <class T>
+class SearchTestKernels: public TestCase {/*{{{*/
+    private:
+        typedef Search<T, false> Scalar;
+        typedef SearchTestValues<T> Values;
+        int times;
+
+        void check(const T *a, int n, const T &x) {
+            int index = Scalar::indexOf(a, n, x);
+            int last = Scalar::lastIndexOf(a, n, x);
+            int cnt = Scalar::count(a, n, x);
+            if (Search<T>::indexOf(a, n, x) != index || Search<T>::lastIndexOf(a, n, x) != last
+                    || Search<T>::count(a, n, x) != cnt)
+                throw TestException("Search differs from the plain loop");
+#ifdef __SSE2__
+            typedef Search<T, true> Simd;
+            if (Simd::indexOf128(a, n, x) != index || Simd::lastIndexOf128(a, n, x) != last
+                    || Simd::count128(a, n, x) != cnt)
+                throw TestException("the 16-byte kernel differs from the plain loop");
+#ifdef SEARCH_AVX2
+            if (Simd::hasAvx2() && (Simd::indexOf256(a, n, x) != index
+                    || Simd::lastIndexOf256(a, n, x) != last || Simd::count256(a, n, x) != cnt))
+                throw TestException("the 32-byte kernel differs from the plain loop");
+#endif
+#endif
+        }
+
+        void check_all(const T *a, int n) {
+            for (int r = 0; r < Values::Size; r++)
+                check(a, n, Values::get(r));
+        }
+
+    public:
+        SearchTestKernels(int _times, TestFixture *_fixture):
+            TestCase("SearchTestKernels", _fixture), times(_times) {}
+        SearchTestKernels(string case_name, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test the Search kernels...");
+            this -> start_memory_watching();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test the Search kernels...");
+            this -> stop_memory_watching();
+        }
+
+        void run_test() {
+            srand(time(0));
+            const int Max = 200;
+            T buf[Max + 3];
+            /*
+             * one match at every place of every short array, the tail included
+             */
+            for (int n = 0; n <= 80; n++)
+                for (int p = -1; p < n; p++) {
+                    for (int i = 0; i < n; i++)
+                        buf[i] = Values::get(i == p ? 3 : 0);
+                    check_all(buf, n);
+                }
+            /*
+             * random arrays of random length, starting at any alignment
+             */
+            for (int t = 0; t < times; t++) {
+                int n = rand() % (Max + 1), from = rand() % 4;
+                int common = rand() % (Values::Size - 1);
+                for (int i = 0; i < n; i++)
+                    buf[from + i] = Values::get(rand() % 8 ? common : rand() % (Values::Size - 1));
+                check_all(buf + from, n);
+            }
+        }
+};/*}}}*/
+
+/*
+ * Two allocators hand out cells and take some back, then one adopts the other.
+ * Every free cell of both, and every cell of their slabs never used, should be
+ * handed out again before a new slab is made.
+ */
+class SlabAllocatorTestAdopt: public TestCase {/*{{{*/
+    private:
+        int times;
+
+        /*
+         * The cells of the slabs made for n cells (16, 32, 64... of them)
+         */
+        static int capacity(int n) {
+            int c = 0;
+            for (int s = 16; c < n; s *= 2)
+                c += s;
+            return c;
+        }
+
+        /*
+         * Allocate n cells from a and deallocate the first f of them
+         */
+        static void use(SlabAllocator<long> &a, int n, int f, std::set<long *> &live) {
+            vector<long *> cells;
+            for (int i = 0; i < n; i++)
+                cells.push_back(a.allocate());
+            for (int i = 0; i < n; i++)
+                if (i < f) a.deallocate(cells[i]);
+                else live.insert(cells[i]);
+        }
+
+    public:
+        SlabAllocatorTestAdopt(int _times, TestFixture *_fixture):
+            TestCase("SlabAllocatorTestAdopt", _fixture), times(_times) {}
+        SlabAllocatorTestAdopt(string case_name, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test adopt...");
+            this -> start_memory_watching();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test adopt...");
+            this -> stop_memory_watching();
+        }
+
+        void run_test() {
+            srand(time(0));
+            for (int t = 0; t < times; t++)
+            {
+                SlabAllocator<long> a, b;
+                std::set<long *> live;
+                int n = rand() % 2000, m = rand() % 2000;
+                int fa = n ? rand() % n : 0, fb = m ? rand() % m : 0;
+                use(a, n, fa, live);
+                use(b, m, fb, live);
+                int spare = fa + fb + capacity(n) - n + capacity(m) - m;
+                if (t % 2) b.join(a);
+                a.adopt(b);
+                vector<long *> cells;
+                cells.reserve(spare);
+                int base = total_alloc_cnt;
+                for (int i = 0; i < spare; i++)
+                    cells.push_back(a.allocate());
+                if (total_alloc_cnt != base)
+                    throw TestException("adopt() loses the free cells of an allocator");
+                for (int i = 0; i < spare; i++)
+                    if (!live.insert(cells[i]).second)
+                        throw TestException("adopt() hands out a cell in use");
+                base = total_alloc_cnt;
+                a.allocate();
+                b.allocate();
+                if (total_alloc_cnt != base + 2)
+                    throw TestException("the allocators should make new slabs once all cells are used");
+            }
+        }
+};/*}}}*/
+
+template <class Queue>
+class PriorityQueueTest : public TestCase {/*{{{*/
+    protected:
+        Queue *queue_ptr;
+    public:
+        PriorityQueueTest(TestFixture *_fixture) :
+            TestCase("PriorityQueueTest", _fixture) {}
+        PriorityQueueTest(string case_name, TestFixture *_fixture) :
+            TestCase(case_name, _fixture) {}
+
+        void set_up() {
+            this -> start_memory_watching();
+            queue_ptr = new Queue();
+        }
+
+        void tear_down() {
+            delete queue_ptr;
+            this -> stop_memory_watching();
+        }
+};/*}}}*/
+
+/*
+ * The elements are unsigned, so that every layout, RadixHeap too, can run it.
+ */
+template <class Queue>
+class PriorityQueueTestRandomOperation: public PriorityQueueTest<Queue> {/*{{{*/
+    private:
+        int times;
+
+        void check_least(const ArrayList<unsigned> &out, std::multiset<unsigned> &std, bool erase) {
+            std::multiset<unsigned>::iterator e = std.begin();
+            for (int i = 0; i < out.size(); i++) {
+                if (e == std.end() || out.get(i) != *e)
+                    throw TestException("the least elements of the queue "
+                            "differ from the standard");
+                if (erase) std.erase(e++);
+                else ++e;
+            }
+        }
+
+    public:
+        PriorityQueueTestRandomOperation(int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>("PriorityQueueTestRandomOperation", _fixture), times(_times) {}
+        PriorityQueueTestRandomOperation(string case_name, int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Random Operation...");
+            PriorityQueueTest<Queue>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Random Operation...");
+            PriorityQueueTest<Queue>::tear_down();
+        }
+
+        void run_test() {
+            srand(time(0));
+            std::multiset<unsigned> std;
+            int push_cnt = 0, pop_cnt = 0, meld_cnt = 0, top_cnt = 0, rm_cnt = 0;
+            for (int i = 0; i < times; i++)
+            {
+                int opt = rand() % 20;
+                int size = std.size();
+                if (this -> queue_ptr -> size() != size)
+                    throw TestException("the size of the queue "
+                            "differs from the standard");
+                if (!size || opt >= 10)
+                {
+                    unsigned num = rand() % 10000;
+                    this -> queue_ptr -> push(num);
+                    std.insert(num);
+                    push_cnt++;
+                }
+                else if (opt >= 6)
+                {
+                    if (this -> queue_ptr -> front() != *std.begin())
+                        throw TestException("the front of the queue "
+                                "differs from the standard");
+                    this -> queue_ptr -> pop();
+                    std.erase(std.begin());
+                    pop_cnt++;
+                }
+                else if (opt == 5)
+                {
+                    Queue q[2];
+                    ArrayList<unsigned> batch;
+                    for (int k = rand() % 50; k > 0; k--) {
+                        unsigned num = rand() % 10000;
+                        q[rand() % 2].push(num);
+                        std.insert(num);
+                    }
+                    for (int k = rand() % (size + 1); k > 0; k--) {
+                        unsigned num = rand() % 10000;
+                        batch.add(num);
+                        std.insert(num);
+                    }
+                    q[0].pushAll(batch);
+                    Queue all(q, q + 2);
+                    if (!q[0].empty() || !q[1].empty())
+                        throw TestException("the melded queues should be left empty");
+                    this -> queue_ptr -> meld(std::move(all));
+                    meld_cnt++;
+                }
+                else if (opt >= 3)
+                {
+                    int k = rand() % (size + 2);
+                    ArrayList<unsigned> out = this -> queue_ptr -> topK(k);
+                    if (out.size() != std::min(k, size))
+                        throw TestException("topK() returns a wrong number of elements");
+                    check_least(out, std, false);
+                    top_cnt++;
+                }
+                else if (opt == 2)
+                {
+                    int k = rand() % (size + 2);
+                    ArrayList<unsigned> out;
+                    this -> queue_ptr -> popK(k, out);
+                    if (out.size() != std::min(k, size))
+                        throw TestException("popK() removes a wrong number of elements");
+                    check_least(out, std, true);
+                    top_cnt++;
+                }
+                else
+                {
+                    /*
+                     * Some iterations stop early; the heap order is then
+                     * restored as the iterator is destroyed, so the front
+                     * read through a const queue is right either way
+                     */
+                    std::multiset<unsigned> seen;
+                    bool stop = rand() % 2;
+                    for (typename Queue::Iterator it = this -> queue_ptr -> iterator(); it.hasNext(); )
+                    {
+                        unsigned num = it.next();
+                        if (rand() % 4 == 0) {
+                            it.remove();
+                            std.erase(std.find(num));
+                            rm_cnt++;
+                        }
+                        else seen.insert(num);
+                        if (stop && rand() % 8 == 0) break;
+                    }
+                    if (!stop && seen != std)
+                        throw TestException("the iterator differs from the standard");
+                    const Queue &q = *this -> queue_ptr;
+                    if (!std.empty() && q.front() != *std.begin())
+                        throw TestException("the front of the queue differs from the standard "
+                                "after Iterator::remove()");
+                    check_least(q.topK(std.size()), std, false);
+                }
+            }
+            while (!std.empty())
+            {
+                if (this -> queue_ptr -> front() != *std.begin())
+                    throw TestException("the front of the queue "
+                            "differs from the standard");
+                this -> queue_ptr -> pop();
+                std.erase(std.begin());
+            }
+            if (!this -> queue_ptr -> empty())
+                throw TestException("the queue should be empty");
+            printf("Push: %d\nPop:%d\nMeld:%d\nTop:%d\nRemove:%d\n",
+                    push_cnt, pop_cnt, meld_cnt, top_cnt, rm_cnt);
+        }
+};/*}}}*/
+
+template <class Queue>
+class PriorityQueueTestHandle: public PriorityQueueTest<Queue> {/*{{{*/
+    private:
+        int times;
+    public:
+        PriorityQueueTestHandle(int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>("PriorityQueueTestHandle", _fixture), times(_times) {}
+        PriorityQueueTestHandle(string case_name, int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Handle...");
+            PriorityQueueTest<Queue>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Handle...");
+            PriorityQueueTest<Queue>::tear_down();
+        }
+
+        /*
+         * The values are kept distinct, so that the handle of the front is known.
+         */
+        void run_test() {
+            srand(time(0));
+            std::map<unsigned, typename Queue::Handle> std;
+            int update_cnt = 0, erase_cnt = 0;
+            for (int i = 0; i < times; i++)
+            {
+                int opt = rand() % 10;
+                int size = std.size();
+                unsigned num = rand() % 1000000;
+                if (std.count(num)) continue;
+                if (!size || opt >= 6)
+                {
+                    std[num] = this -> queue_ptr -> push(num);
+                    continue;
+                }
+                typename std::map<unsigned, typename Queue::Handle>::iterator e = std.lower_bound(rand() % 1000000);
+                if (e == std.end()) e = std.begin();
+                typename Queue::Handle h = e -> second;
+                if (this -> queue_ptr -> get(h) != e -> first)
+                    throw TestException("the handle names a wrong element");
+                if (opt == 5)
+                {
+                    this -> queue_ptr -> pop();
+                    std.erase(std.begin());
+                    continue;
+                }
+                if (opt == 4)
+                {
+                    this -> queue_ptr -> erase(h);
+                    erase_cnt++;
+                }
+                else if (opt == 3)
+                    this -> queue_ptr -> update(h, num);
+                else if (num < e -> first)
+                    this -> queue_ptr -> decreaseKey(h, num);
+                else
+                    this -> queue_ptr -> increaseKey(h, num);
+                std.erase(e);
+                if (opt != 4) std[num] = h;
+                update_cnt++;
+                if (this -> queue_ptr -> size() != (int) std.size()
+                        || (!std.empty() && this -> queue_ptr -> front() != std.begin() -> first))
+                    throw TestException("the queue differs from the standard "
+                            "after a change through a handle");
+            }
+            Queue other;
+            for (int i = 0; i < 100; i++)
+            {
+                unsigned num = 1000000 + i;
+                std[num] = other.push(num);
+            }
+            this -> queue_ptr -> meld(std::move(other));
+            for (typename std::map<unsigned, typename Queue::Handle>::iterator e = std.begin(); e != std.end(); ++e)
+                if (this -> queue_ptr -> get(e -> second) != e -> first)
+                    throw TestException("the handles should follow their elements into meld()");
+            printf("Update:%d\nErase:%d\n", update_cnt, erase_cnt);
+        }
+};/*}}}*/
+
+/*
+ * V is unsigned for RadixHeap and MoveTestValue for the other layouts; the
+ * elements go in by push(V&&) or emplace, so none may ever be copied.
+ */
+template <class Queue, class V>
+class PriorityQueueTestMove: public PriorityQueueTest<Queue> {/*{{{*/
+    private:
+        int times;
+
+        /*
+         * Pop every element of a, which should be from, from + 1, ..., from + n - 1
+         */
+        void check(Queue &a, int from, int n, const char *msg) {
+            if (a.size() != n || a.empty() != (n == 0))
+                throw TestException(msg);
+            for (int i = 0; i < n; i++) {
+                if (!(a.front() == V(from + i)))
+                    throw TestException(msg);
+                a.pop();
+            }
+            if (!a.empty())
+                throw TestException(msg);
+        }
+
+        void fill(Queue &a, int n) {
+            vector<int> order;
+            for (int i = 0; i < n; i++)
+                order.push_back(i);
+            random_shuffle(order.begin(), order.end());
+            for (int i = 0; i < n; i++) {
+                if (i % 2) a.push(V(order[i]));
+                else a.emplace(order[i]);
+            }
+        }
+
+    public:
+        PriorityQueueTestMove(int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>("PriorityQueueTestMove", _fixture), times(_times) {}
+        PriorityQueueTestMove(string case_name, int _times, TestFixture *_fixture):
+            PriorityQueueTest<Queue>(case_name, _fixture), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test Move and Emplace...");
+            MoveTestValue::copies = MoveTestValue::moves = 0;
+            PriorityQueueTest<Queue>::set_up();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test Move and Emplace...");
+            PriorityQueueTest<Queue>::tear_down();
+        }
+
+        void run_test() {
+            srand(time(0));
+            Queue &a = *this -> queue_ptr;
+            fill(a, times);
+            Queue b(std::move(a));
+            if (!a.empty() || a.size() != 0)
+                throw TestException("the moved-from queue should be empty");
+            a.emplace(0);
+            if (a.size() != 1 || !(a.front() == V(0)))
+                throw TestException("the moved-from queue can not be reused");
+
+            Queue &self = b;
+            b = std::move(self);
+            if (b.size() != times || !(b.front() == V(0)))
+                throw TestException("self-move-assignment changes the queue");
+
+            a.swap(b);
+            if (a.size() != times || b.size() != 1)
+                throw TestException("swap() gives wrong elements");
+            b = std::move(a);
+            if (!a.empty())
+                throw TestException("the moved-from queue should be empty");
+            fill(a, times);
+            check(a, 0, times, "the moved-from queue can not be reused");
+            check(b, 0, times, "the move functions lose elements");
+            if (MoveTestValue::copies != 0)
+                throw TestException("an element is copied where it should be moved");
+        }
+};/*}}}*/
+
+
+/*
+ * A small random generator for the threads of the tests below, since rand()
+ * is not safe to call from many threads
+ */
+struct ThreadTestRandom {
+    unsigned int seed;
+    ThreadTestRandom(unsigned int s): seed(s * 2654435761u + 1) {}
+    int next(int n) {
+        seed = seed * 1103515245u + 12345u;
+        return (int) ((seed >> 8) % (unsigned int) n);
+    }
+};
+
+template <class Map>
+class ConcurrentMapTestThreads: public TestCase {/*{{{*/
+    private:
+        int threads, times;
+        Map *map_ptr;
+
+    public:
+        ConcurrentMapTestThreads(int _threads, int _times, TestFixture *_fixture):
+            TestCase("ConcurrentMapTestThreads", _fixture), threads(_threads), times(_times) {}
+        ConcurrentMapTestThreads(string case_name, int _threads, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture), threads(_threads), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test threads sharing a map...");
+            this -> start_memory_watching();
+            map_ptr = new Map();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test...");
+            delete map_ptr;
+            this -> stop_memory_watching();
+        }
+
+        /*
+         * Writer w owns the keys w, w + threads, w + 2 * threads, ...; it puts
+         * them all and removes every third one, while the readers check that
+         * any value they find is the one of its key. Then every thread
+         * overwrites one shared set of keys, always with the same values.
+         */
+        void run_test() {
+            Map &map = *map_ptr;
+            int n = threads, m = times;
+            std::atomic<int> writing(n);
+            std::atomic<bool> wrong(false);
+            vector<std::thread> th;
+            for (int w = 0; w < n; w++)
+                th.push_back(std::thread([&map, &writing, w, n, m]() {
+                    for (int i = 0; i < m; i++)
+                        map.put(w + n * i, (w + n * i) * 2);
+                    for (int i = 0; i < m; i += 3)
+                        map.remove(w + n * i);
+                    for (int i = 0; i < m; i++)
+                        map.put(-1 - i % 100, i % 100);
+                    writing.fetch_sub(1);
+                }));
+            for (int r = 0; r < 2; r++)
+                th.push_back(std::thread([&map, &writing, &wrong, r, n, m]() {
+                    ThreadTestRandom random(r);
+                    while (writing.load() > 0) {
+                        int k = random.next(n * m);
+                        try {
+                            if (map.get(k) != k * 2) wrong.store(true);
+                        } catch (ElementNotExist) {}
+                    }
+                }));
+            for (int i = 0; i < (int) th.size(); i++)
+                th[i].join();
+            if (wrong.load())
+                throw TestException("a reader found a value which was never "
+                        "put with its key");
+            puts("checking the map after the threads:");
+            int expect = 100;
+            for (int k = 0; k < n * m; k++) {
+                bool in = (k / n) % 3 != 0;
+                if (map.containsKey(k) != in)
+                    throw TestException("the map lost a key or kept a removed one");
+                if (in) {
+                    expect++;
+                    if (map.get(k) != k * 2)
+                        throw TestException("the map holds a wrong value");
+                }
+            }
+            for (int i = 0; i < 100; i++)
+                if (map.get(-1 - i) != i)
+                    throw TestException("the overwritten keys hold wrong values");
+            if (map.size() != expect)
+                throw TestException("the size of the map is wrong after the threads");
+            int counter = 0;
+            for (typename Map::Iterator it = map.iterator(); it.hasNext(); counter++)
+                it.next();
+            if (counter != expect)
+                throw TestException("the iterator misses entries after the threads");
+            puts("OK\n");
+        }
+};/*}}}*/
+
+/*
+ * One thread more than Epoch has slots: while they all hold a guard, at least
+ * one of them can not, and should get an exception instead of waiting.
+ */
+class EpochTestSlots: public TestCase {/*{{{*/
+    public:
+        EpochTestSlots(TestFixture *_fixture):
+            TestCase("EpochTestSlots", _fixture) {}
+        EpochTestSlots(string case_name, TestFixture *_fixture):
+            TestCase(case_name, _fixture) {}
+
+        void set_up() {
+            puts("== Now preparing to test more threads than Epoch slots...");
+        }
+
+        void tear_down() {
+            puts("== Finishing the test...");
+        }
+
+        void run_test() {
+            int n = Epoch::Max_threads + 1;
+            std::atomic<int> tried(0), refused(0);
+            vector<std::thread> th;
+            for (int i = 0; i < n; i++)
+                th.push_back(std::thread([&tried, &refused, n]() {
+                    try {
+                        Epoch::Guard g;
+                        tried.fetch_add(1);
+                        while (tried.load() < n)
+                            std::this_thread::yield();
+                    } catch (const std::runtime_error &) {
+                        refused.fetch_add(1);
+                        Epoch::retire(new int(0));
+                        tried.fetch_add(1);
+                    }
+                }));
+            for (int i = 0; i < n; i++)
+                th[i].join();
+            if (refused.load() == 0)
+                throw TestException("a thread got a guard with every slot taken");
+            std::thread late([&refused]() {
+                try {
+                    Epoch::Guard g;
+                } catch (const std::runtime_error &) {
+                    refused.store(-1);
+                }
+            });
+            late.join();
+            if (refused.load() < 0)
+                throw TestException("the slots of exited threads are not given back");
+        }
+};/*}}}*/
+
+template <class Queue>
+class QueueTestThreads: public TestCase {/*{{{*/
+    private:
+        int producers, consumers, times;
+
+    public:
+        QueueTestThreads(int _producers, int _consumers, int _times, TestFixture *_fixture):
+            TestCase("QueueTestThreads", _fixture),
+            producers(_producers), consumers(_consumers), times(_times) {}
+        QueueTestThreads(string case_name, int _producers, int _consumers, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture),
+            producers(_producers), consumers(_consumers), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test threads sharing a queue...");
+            this -> start_memory_watching();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test...");
+            this -> stop_memory_watching();
+        }
+
+        /*
+         * Producer p pushes p, p + producers, p + 2 * producers, ...; each
+         * consumer must see the elements of one producer in the order they
+         * were pushed, and all of them together must add up.
+         */
+        void run_test() {
+            Queue q(64);
+            int np = producers, m = times;
+            std::atomic<long long> sum(0);
+            std::atomic<int> left(np * m);
+            std::atomic<bool> wrong(false);
+            vector<std::thread> th;
+            for (int p = 0; p < np; p++)
+                th.push_back(std::thread([&q, p, np, m]() {
+                    for (int i = 0; i < m; i++)
+                        q.push(p + np * i);
+                }));
+            for (int c = 0; c < consumers; c++)
+                th.push_back(std::thread([&q, &sum, &left, &wrong, np]() {
+                    vector<int> last(np, -1);
+                    long long s = 0;
+                    while (left.fetch_sub(1) > 0) {
+                        int x = q.pop();
+                        if (x <= last[x % np]) wrong.store(true);
+                        last[x % np] = x;
+                        s += x;
+                    }
+                    sum.fetch_add(s);
+                }));
+            for (int i = 0; i < (int) th.size(); i++)
+                th[i].join();
+            long long total = (long long) np * m;
+            if (wrong.load())
+                throw TestException("a consumer saw the elements of a producer "
+                        "out of order");
+            if (sum.load() != total * (total - 1) / 2)
+                throw TestException("the elements popped do not add up to those pushed");
+            if (!q.isEmpty())
+                throw TestException("the queue should be empty");
+            printf("Passed %lld elements\n", total);
+        }
+};/*}}}*/
+
+class WorkStealingTestThreads: public TestCase {/*{{{*/
+    private:
+        int thieves, times;
+
+    public:
+        WorkStealingTestThreads(int _thieves, int _times, TestFixture *_fixture):
+            TestCase("WorkStealingTestThreads", _fixture), thieves(_thieves), times(_times) {}
+        WorkStealingTestThreads(string case_name, int _thieves, int _times, TestFixture *_fixture):
+            TestCase(case_name, _fixture), thieves(_thieves), times(_times) {}
+
+        void set_up() {
+            puts("== Now preparing to test work stealing...");
+            this -> start_memory_watching();
+        }
+
+        void tear_down() {
+            puts("== Finishing the test...");
+            this -> stop_memory_watching();
+        }
+
+        void run_test() {
+            puts("checking that every element of the deque is taken once:");
+            int m = times;
+            WorkStealingDeque<int> d(4);
+            std::atomic<bool> done(false);
+            vector<vector<int> > taken(thieves + 1);
+            vector<std::thread> th;
+            for (int k = 1; k <= thieves; k++)
+                th.push_back(std::thread([&d, &done, &taken, k]() {
+                    int x;
+                    while (!done.load() || !d.isEmpty())
+                        if (d.steal(x)) taken[k].push_back(x);
+                }));
+            for (int i = 0; i < m; i++) {
+                d.push(i);
+                int x;
+                if (i % 3 == 0 && d.pop(x)) taken[0].push_back(x);
+            }
+            for (int x; !d.isEmpty(); )
+                if (d.pop(x)) taken[0].push_back(x);
+            done.store(true);
+            for (int i = 0; i < (int) th.size(); i++)
+                th[i].join();
+            vector<int> all;
+            for (int k = 0; k <= thieves; k++)
+                all.insert(all.end(), taken[k].begin(), taken[k].end());
+            sort(all.begin(), all.end());
+            if ((int) all.size() != m)
+                throw TestException("an element of the deque was lost or taken twice");
+            for (int i = 0; i < m; i++)
+                if (all[i] != i)
+                    throw TestException("an element of the deque was lost or taken twice");
+            puts("OK\n");
+
+            puts("checking parallelFor, nested task groups and submit:");
+            WorkStealingPool pool(thieves + 1);
+            std::atomic<long long> sum(0);
+            pool.parallelFor(0, m, 64, [&sum](int i) { sum.fetch_add(i); });
+            if (sum.load() != (long long) m * (m - 1) / 2)
+                throw TestException("parallelFor() missed or repeated an index");
+            std::atomic<int> leaves(0);
+            std::function<void(int)> tree = [&pool, &leaves, &tree](int depth) {
+                if (depth == 0) {
+                    leaves.fetch_add(1);
+                    return;
+                }
+                WorkStealingPool::TaskGroup g(pool);
+                g.run([&tree, depth]() { tree(depth - 1); });
+                tree(depth - 1);
+                g.wait();
+            };
+            {
+                WorkStealingPool::TaskGroup g(pool);
+                g.run([&tree]() { tree(12); });
+            }
+            if (leaves.load() != 1 << 12)
+                throw TestException("a nested task group returned too early");
+            std::atomic<int> submitted(0);
+            for (int i = 0; i < 1000; i++)
+                pool.submit([&submitted]() { submitted.fetch_add(1); });
+            for (int n = 0; submitted.load() < 1000; n++)
+                QueueWait::backoff(n);
+            puts("OK\n");
+        }
+};/*}}}*/
+
 #endif
 
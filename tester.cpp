@@ -30,7 +30,7 @@ int main() {
     //freopen("xxx.txt", "w", stdout);
 
     TestFixture t;
-/*
+
     ListTestConsecutiveInsert<ArrayList<int> > 
         arr_altci("ArrayListConsecutiveInsert", 1000, &t);
     ListTestModification<ArrayList<int> > 
@@ -57,7 +57,35 @@ int main() {
         linked_alti("LinkedListItertor", &t); 
     ListTestRandomOperation<LinkedList<int> > 
         linked_ro("LinkedRandomOperation", 10000, &t);
-*/
+
+    ListTestBulk<ArrayList<int> >
+        arr_bulk("ArrayListBulk", 10000, &t);
+    ListTestCapacity<ArrayList<int> >
+        arr_capacity("ArrayListCapacity", 1000, &t);
+    ListTestFinger<LinkedList<int> >
+        linked_finger("LinkedListFinger", 10000, &t);
+    IntrusiveListTest
+        intrusive("IntrusiveList", 100000, &t);
+    ListTestSplice<LinkedList<int> >
+        linked_splice("LinkedListSplice", 20000, &t);
+    ListTestSplice<LinkedList<int, NodePerElement, NewAllocator> >
+        new_linked_splice("NewAllocatorLinkedListSplice", 20000, &t);
+    ListTestMove<ArrayList<MoveTestValue> >
+        arr_move("ArrayListMove", 10000, &t);
+    ListTestMove<LinkedList<MoveTestValue> >
+        linked_move("LinkedListMove", 10000, &t);
+    ListTestMove<LinkedList<MoveTestValue, Unrolled> >
+        unrolled_move("UnrolledLinkedListMove", 10000, &t);
+    ListTestMove<LinkedList<MoveTestValue, SkipIndexed> >
+        skip_move("SkipIndexedLinkedListMove", 10000, &t);
+    ListTestIterator<LinkedList<int, Unrolled> >
+        unrolled_alti("UnrolledLinkedListIterator", &t);
+    ListTestRandomOperation<LinkedList<int, Unrolled> >
+        unrolled_ro("UnrolledLinkedListRandomOperation", 10000, &t);
+    ListTestIterator<LinkedList<int, SkipIndexed> >
+        skip_alti("SkipIndexedLinkedListIterator", &t);
+    ListTestRandomOperation<LinkedList<int, SkipIndexed> >
+        skip_ro("SkipIndexedLinkedListRandomOperation", 10000, &t);
     DequeTestConsecutiveInsert<Deque<int> > 
         deque_altci("DequeCosecutiveInsert", 1000, &t);
     DequeTestModification<Deque<int> > 
@@ -72,13 +100,102 @@ int main() {
         deque_altdi("DequeDescendingIterator", &t);
     DequeTestRandomOperation<Deque<int> >
         deque_ro("DequeTestRandomOperation", 10000, &t);
-/*
+    ListTestRandomOperation<Deque<int> >
+        deque_list_ro("DequeListRandomOperation", 10000, &t);
+    ListTestRandomOperation<Deque<int, BlockMap> >
+        block_list_ro("BlockDequeListRandomOperation", 10000, &t);
+    DequeTestDescendingIterator<Deque<int, BlockMap> >
+        block_altdi("BlockDequeDescendingIterator", &t);
+    DequeTestRandomOperation<Deque<int, BlockMap> >
+        block_ro("BlockDequeRandomOperation", 10000, &t);
+    DequeTestSearch<Deque<int> >
+        deque_search("DequeSearch", 20000, &t);
+    DequeTestSearch<Deque<int, BlockMap> >
+        block_search("BlockDequeSearch", 20000, &t);
+    SearchTestKernels<char>
+        char_search("CharSearchKernels", 20000, &t);
+    SearchTestKernels<short>
+        short_search("ShortSearchKernels", 20000, &t);
+    SearchTestKernels<int>
+        int_search("IntSearchKernels", 20000, &t);
+    SearchTestKernels<long long>
+        ll_search("LongLongSearchKernels", 20000, &t);
+    SearchTestKernels<unsigned long>
+        ul_search("UnsignedLongSearchKernels", 20000, &t);
+    SearchTestKernels<float>
+        float_search("FloatSearchKernels", 20000, &t);
+    SearchTestKernels<double>
+        double_search("DoubleSearchKernels", 20000, &t);
+    DequeTestMove<Deque<MoveTestValue> >
+        deque_move("DequeMove", 10000, &t);
+    DequeTestMove<Deque<MoveTestValue, BlockMap> >
+        block_move("BlockDequeMove", 10000, &t);
     MapTestAllRandomly<TreeMap<int, int> > 
         tree_all("TreeMapAllRandom", 100000, 10000000, &t);
-
     MapTestAllRandomly<HashMap<int, int, HashInt> > 
         hash_all("HashMapAllRandom", 100000, 10000000, &t);
-*/
+    MapTestRehash<HashMap<int, int, HashInt> >
+        hash_rehash("HashMapRehash", 200000, &t);
+    MapTestAllRandomly<HashMap<int, int, HashInt, RobinHood> >
+        robin_all("RobinHoodHashMapAllRandom", 100000, 10000000, &t);
+    MapTestAllRandomly<HashMap<int, int, HashInt, GroupProbing> >
+        group_all("GroupProbingHashMapAllRandom", 100000, 10000000, &t);
+    MapTestDestroy<HashMap<int, MapTestValue, HashInt> >
+        hash_destroy("HashMapDestroy", 10000, &t);
+    MapTestDestroy<HashMap<int, MapTestValue, HashInt, RobinHood> >
+        robin_destroy("RobinHoodHashMapDestroy", 10000, &t);
+    MapTestDestroy<HashMap<int, MapTestValue, HashInt, GroupProbing> >
+        group_destroy("GroupProbingHashMapDestroy", 10000, &t);
+    MapTestMove<TreeMap<int, MoveTestValue> >
+        tree_move("TreeMapMove", 10000, &t);
+    MapTestCapacity<HashMap<int, int, HashInt> >
+        hash_capacity("HashMapCapacity", 300, &t);
+    MapTestCapacity<HashMap<int, int, HashInt, RobinHood> >
+        robin_capacity("RobinHoodHashMapCapacity", 300, &t);
+    MapTestCapacity<HashMap<int, int, HashInt, GroupProbing> >
+        group_capacity("GroupProbingHashMapCapacity", 300, &t);
+    MapTestMove<HashMap<int, MoveTestValue, HashInt> >
+        hash_move("HashMapMove", 10000, &t);
+    MapTestMove<HashMap<int, MoveTestValue, HashInt, RobinHood> >
+        robin_move("RobinHoodHashMapMove", 10000, &t);
+    MapTestMove<HashMap<int, MoveTestValue, HashInt, GroupProbing> >
+        group_move("GroupProbingHashMapMove", 10000, &t);
+
+    SlabAllocatorTestAdopt
+        slab_adopt("SlabAllocatorAdopt", 1000, &t);
+
+    PriorityQueueTestRandomOperation<PriorityQueue<unsigned> >
+        heap_ro("PriorityQueueRandomOperation", 10000, &t);
+    PriorityQueueTestRandomOperation<PriorityQueue<unsigned, Less<unsigned>, DaryHeap<> > >
+        dary_ro("DaryHeapRandomOperation", 10000, &t);
+    PriorityQueueTestRandomOperation<PriorityQueue<unsigned, Less<unsigned>, PairingHeap> >
+        pairing_ro("PairingHeapRandomOperation", 10000, &t);
+    PriorityQueueTestRandomOperation<PriorityQueue<unsigned, Less<unsigned>, RadixHeap> >
+        radix_ro("RadixHeapRandomOperation", 10000, &t);
+    PriorityQueueTestHandle<PriorityQueue<unsigned> >
+        heap_handle("PriorityQueueHandle", 100000, &t);
+    PriorityQueueTestHandle<PriorityQueue<unsigned, Less<unsigned>, PairingHeap> >
+        pairing_handle("PairingHeapHandle", 100000, &t);
+    PriorityQueueTestMove<PriorityQueue<MoveTestValue>, MoveTestValue>
+        heap_move("PriorityQueueMove", 10000, &t);
+    PriorityQueueTestMove<PriorityQueue<MoveTestValue, Less<MoveTestValue>, DaryHeap<> >, MoveTestValue>
+        dary_move("DaryHeapMove", 10000, &t);
+    PriorityQueueTestMove<PriorityQueue<MoveTestValue, Less<MoveTestValue>, PairingHeap>, MoveTestValue>
+        pairing_move("PairingHeapMove", 10000, &t);
+    PriorityQueueTestMove<PriorityQueue<unsigned, Less<unsigned>, RadixHeap>, unsigned>
+        radix_move("RadixHeapMove", 10000, &t);
+
+    ConcurrentMapTestThreads<ConcurrentHashMap<int, int, HashInt> >
+        concurrent_map("ConcurrentHashMapThreads", 4, 20000, &t);
+    EpochTestSlots
+        epoch_slots("EpochSlots", &t);
+    QueueTestThreads<SpscQueue<int> >
+        spsc_threads("SpscQueueThreads", 1, 1, 1000000, &t);
+    QueueTestThreads<MpmcQueue<int> >
+        mpmc_threads("MpmcQueueThreads", 4, 4, 200000, &t);
+    WorkStealingTestThreads
+        stealing("WorkStealingThreads", 3, 200000, &t);
+
     if (t.test_all()) puts("All tests have finished without errors.");
     else return 1;
     
@@ -25,6 +25,7 @@
 #include <string>
 #include <set>
 #include <vector>
+#include <atomic>
 
 using std::string;
 using std::set;
@@ -32,7 +33,8 @@ using std::vector;
 
 typedef long long ll;
 
-int total_alloc_cnt = 0;
+// atomic, since some tests allocate from many threads
+std::atomic<int> total_alloc_cnt(0);
 
 void * operator new(size_t size) throw (std::bad_alloc) {
     void *p = malloc(size);